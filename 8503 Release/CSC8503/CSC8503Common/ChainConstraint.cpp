@@ -0,0 +1,274 @@
+#include "ChainConstraint.h"
+#include "PositionConstraint.h"
+#include "PhysicsObject.h"
+#include "GameObject.h"
+#include "GameWorld.h"
+#include <map>
+
+using namespace NCL;
+using namespace CSC8503;
+
+ChainConstraint::ChainConstraint(GameObject* first) {
+	links.push_back(first);
+	compliance = 0.0f;
+}
+
+void ChainConstraint::AddLink(GameObject* next, float distance) {
+	links.push_back(next);
+	distances.push_back(distance);
+}
+
+/*
+The positions are projected back onto the chain first, so that the bridge
+can't stretch, and then the velocities along each link are removed, so
+that it doesn't immediately start stretching again. Both use the same
+matrix, so it's only worked out once per step.
+*/
+void ChainConstraint::UpdateConstraint(float dt) {
+	if (distances.empty()) {
+		return;
+	}
+	UpdateLinks();
+	SolvePositions();
+	UpdateLinks();
+	SolveVelocities();
+}
+
+/*
+Each link i joins object i to object i+1, and pulls along the direction
+between them. Pushing on link i moves both of its objects, which also
+changes the length of links i-1 and i+1, by an amount depending on how
+heavy the shared object is, and how closely the two links line up. So,
+for inverse masses w, and link directions n:
+
+	diagonal[i]		= w[i] + w[i+1]
+	offDiagonal[i]	= -w[i+1] * dot(n[i], n[i+1])
+
+Links between two fixed objects can't be moved at all, so they just get a
+1 on the diagonal, and always solve to 0.
+
+If both ends of the chain are fixed further apart than the chain can
+reach (like the coursework bridge!), the matrix is singular, and there's
+no exact answer. Making the diagonal a tiny bit bigger still gives the
+closest answer there is, and doing the solve in doubles stops the rounding
+errors from blowing up along the way.
+*/
+void ChainConstraint::UpdateLinks() {
+	const double regularisation = 1e-6;
+	int numLinks = (int)distances.size();
+
+	directions.resize(numLinks);
+	lengths.resize(numLinks);
+	inverseMasses.resize(links.size());
+	diagonal.resize(numLinks);
+	offDiagonal.resize(numLinks);
+	rhs.resize(numLinks);
+	lambdas.resize(numLinks);
+	scratch.resize(numLinks);
+
+	for (size_t i = 0; i < links.size(); ++i) {
+		PhysicsObject* phys = links[i]->GetPhysicsObject();
+		inverseMasses[i] = phys ? phys->GetInverseMass() : 0.0f;
+	}
+
+	for (int i = 0; i < numLinks; ++i) {
+		Vector3 delta	= links[i + 1]->GetTransform().GetPosition() - links[i]->GetTransform().GetPosition();
+		lengths[i]		= delta.Length();
+		directions[i]	= lengths[i] > 0.0f ? delta / lengths[i] : Vector3(0, 1, 0);
+	}
+
+	for (int i = 0; i < numLinks; ++i) {
+		diagonal[i] = (inverseMasses[i] + inverseMasses[i + 1]) * (1.0 + regularisation);
+		if (diagonal[i] <= 0.0) {
+			diagonal[i] = 1.0;
+		}
+		offDiagonal[i] = 0.0;
+		if (i + 1 < numLinks) {
+			offDiagonal[i] = -inverseMasses[i + 1] * Vector3::Dot(directions[i], directions[i + 1]);
+		}
+	}
+}
+
+/*
+Moving the objects by w * lambda along each link changes the link lengths
+by (matrix * lambda), so to get every link back to its rest length in one
+go, we solve for (matrix * lambda = rest length - current length). The
+directions change a little as things move, so this is a single Newton step
+rather than completely exact, but is plenty close enough every substep.
+*/
+void ChainConstraint::SolvePositions() {
+	int numLinks = (int)distances.size();
+	for (int i = 0; i < numLinks; ++i) {
+		bool fixed = inverseMasses[i] + inverseMasses[i + 1] <= 0.0f;
+		rhs[i] = fixed ? 0.0 : distances[i] - lengths[i];
+	}
+	SolveTridiagonal();
+
+	for (size_t i = 0; i < links.size(); ++i) {
+		if (inverseMasses[i] <= 0.0f) {
+			continue;
+		}
+		Vector3 offset = GetLinkPush((int)i);
+		Transform& transform = links[i]->GetTransform();
+		transform.SetPosition(transform.GetPosition() + offset * inverseMasses[i]);
+	}
+}
+
+/*
+Same again, but for the velocities - we want the rate each link is
+changing length at to be zero, so the impulses cancel it out exactly.
+*/
+void ChainConstraint::SolveVelocities() {
+	int numLinks = (int)distances.size();
+	for (int i = 0; i < numLinks; ++i) {
+		bool fixed = inverseMasses[i] + inverseMasses[i + 1] <= 0.0f;
+		if (fixed) {
+			rhs[i] = 0.0;
+			continue;
+		}
+		Vector3 velA = links[i]->GetPhysicsObject()->GetLinearVelocity();
+		Vector3 velB = links[i + 1]->GetPhysicsObject()->GetLinearVelocity();
+		rhs[i] = -Vector3::Dot(velB - velA, directions[i]);
+	}
+	SolveTridiagonal();
+
+	for (size_t i = 0; i < links.size(); ++i) {
+		if (inverseMasses[i] <= 0.0f) {
+			continue;
+		}
+		Vector3 impulse = GetLinkPush((int)i);
+		links[i]->GetPhysicsObject()->ApplyLinearImpulse(impulse);
+	}
+}
+
+/*
+Adds up the push on an object from the links either side of it. The two
+lambdas can be huge and nearly cancel out when the chain is overstretched,
+so they're combined as doubles, before going back down to a float.
+*/
+Vector3 ChainConstraint::GetLinkPush(int i) const {
+	double push[3] = { 0.0, 0.0, 0.0 };
+	for (int axis = 0; axis < 3; ++axis) {
+		if (i > 0) {
+			push[axis] += directions[i - 1][axis] * lambdas[i - 1];
+		}
+		if (i < (int)distances.size()) {
+			push[axis] -= directions[i][axis] * lambdas[i];
+		}
+	}
+	return Vector3((float)push[0], (float)push[1], (float)push[2]);
+}
+
+/*
+The Thomas algorithm - Gaussian elimination, but only ever touching the
+3 diagonals that have anything in them. The matrix is symmetric, so the
+entry below the diagonal on row i is the same as the one above it on
+row i-1.
+*/
+void ChainConstraint::SolveTridiagonal() {
+	int n = (int)rhs.size();
+
+	scratch[0]	= offDiagonal[0] / diagonal[0];
+	lambdas[0]	= rhs[0] / diagonal[0];
+
+	for (int i = 1; i < n; ++i) {
+		double below = offDiagonal[i - 1];
+		double pivot = diagonal[i] - below * scratch[i - 1];
+		scratch[i]	= offDiagonal[i] / pivot;
+		lambdas[i]	= (rhs[i] - below * lambdas[i - 1]) / pivot;
+	}
+
+	for (int i = n - 2; i >= 0; --i) {
+		lambdas[i] -= scratch[i] * lambdas[i + 1];
+	}
+}
+
+/*
+Looks through the world's PositionConstraints for chains - runs of
+objects that each have exactly 2 constraints on them, and can move. Fixed
+objects, or objects with 3 or more constraints, end a chain, so a bridge
+hanging between 2 fixed blocks becomes one ChainConstraint. Loops can't be
+solved as a tridiagonal matrix, so they're left alone.
+*/
+int ChainConstraint::CollapseChains(GameWorld& world) {
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	world.GetConstraintIterators(first, last);
+
+	std::vector<PositionConstraint*> candidates;
+	std::map<GameObject*, std::vector<int>> objectConstraints;
+
+	for (auto i = first; i != last; ++i) {
+		PositionConstraint* p = dynamic_cast<PositionConstraint*>(*i);
+		if (!p) {
+			continue;
+		}
+		objectConstraints[p->GetObjectA()].push_back((int)candidates.size());
+		objectConstraints[p->GetObjectB()].push_back((int)candidates.size());
+		candidates.push_back(p);
+	}
+
+	auto isInterior = [&](GameObject* o) {
+		PhysicsObject* phys = o->GetPhysicsObject();
+		return phys && phys->GetInverseMass() > 0.0f && objectConstraints[o].size() == 2;
+	};
+	auto nextConstraint = [&](GameObject* o, int from) {
+		const std::vector<int>& c = objectConstraints[o];
+		return c[0] == from ? c[1] : c[0];
+	};
+	auto otherEnd = [&](int c, GameObject* o) {
+		return candidates[c]->GetObjectA() == o ? candidates[c]->GetObjectB() : candidates[c]->GetObjectA();
+	};
+
+	std::vector<bool> used(candidates.size(), false);
+	int numChains = 0;
+
+	for (int start = 0; start < (int)candidates.size(); ++start) {
+		if (used[start]) {
+			continue;
+		}
+		//Walk backwards from this constraint to the start of its chain
+		int c			= start;
+		GameObject* end	= candidates[c]->GetObjectA();
+		bool isLoop		= false;
+		while (isInterior(end)) {
+			c	= nextConstraint(end, c);
+			end	= otherEnd(c, end);
+			if (c == start) {
+				isLoop = true;
+				break;
+			}
+		}
+		if (isLoop) {
+			used[start] = true;
+			continue;
+		}
+		//...and then forwards along it, gathering up the links
+		std::vector<int> chain;
+		GameObject* current = end;
+		while (true) {
+			chain.push_back(c);
+			current = otherEnd(c, current);
+			if (!isInterior(current)) {
+				break;
+			}
+			c = nextConstraint(current, c);
+		}
+		for (int i : chain) {
+			used[i] = true;
+		}
+		if (chain.size() < 2) {
+			continue;
+		}
+		ChainConstraint* newChain = new ChainConstraint(end);
+		current = end;
+		for (int i : chain) {
+			current = otherEnd(i, current);
+			newChain->AddLink(current, candidates[i]->GetDistance());
+			world.RemoveConstraint(candidates[i], true);
+		}
+		world.AddConstraint(newChain);
+		numChains++;
+	}
+	return numChains;
+}
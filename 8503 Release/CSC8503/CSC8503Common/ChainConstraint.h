@@ -0,0 +1,86 @@
+#pragma once
+#include "Constraint.h"
+#include "../../Common/Vector3.h"
+#include <vector>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class GameWorld;
+
+		/*
+		A chain of objects, each held a fixed distance from the next - like
+		a rope bridge. Rather than solving each link on its own, over and
+		over again, every link is solved at once. Each link only shares an
+		object with the link either side of it, so the equations form a
+		tridiagonal matrix, which can be solved exactly in O(n) using the
+		Thomas algorithm.
+		*/
+		class ChainConstraint : public Constraint {
+		public:
+			ChainConstraint(GameObject* first);
+			~ChainConstraint() {};
+
+			void AddLink(GameObject* next, float distance);
+
+			void UpdateConstraint(float dt) override;
+
+			bool IsDirect() const override {
+				return true;
+			}
+
+			bool GetObjects(std::vector<GameObject*>& objects) const override {
+				objects.insert(objects.end(), links.begin(), links.end());
+				return true;
+			}
+
+			int GetNumLinks() const {
+				return (int)distances.size();
+			}
+
+			//There's one more object than there are links
+			GameObject* GetLink(int i) const {
+				return links[i];
+			}
+
+			float GetLinkDistance(int i) const {
+				return distances[i];
+			}
+
+			//Only used by the XPBD solver - the direct solve is always rigid
+			void SetCompliance(float c) {
+				compliance = c;
+			}
+
+			float GetCompliance() const {
+				return compliance;
+			}
+
+			//Finds runs of PositionConstraints that form a simple chain,
+			//and replaces each of them with a single ChainConstraint
+			static int CollapseChains(GameWorld& world);
+
+		protected:
+			void UpdateLinks();
+			void SolvePositions();
+			void SolveVelocities();
+			void SolveTridiagonal();
+			Vector3 GetLinkPush(int i) const;
+
+			std::vector<GameObject*>	links;
+			std::vector<float>			distances;
+			float						compliance;
+
+			//Working space, kept around so we don't allocate every step
+			std::vector<Vector3>		directions;
+			std::vector<float>			lengths;
+			std::vector<float>			inverseMasses;
+			std::vector<double>			diagonal;
+			std::vector<double>			offDiagonal;
+			std::vector<double>			rhs;
+			std::vector<double>			lambdas;
+			std::vector<double>			scratch;
+		};
+	}
+}
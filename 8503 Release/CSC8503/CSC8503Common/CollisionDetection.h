@@ -5,12 +5,14 @@
 
 #include "Transform.h"
 #include "GameObject.h"
+#include "GameObjectHandle.h"
 
 #include "AABBVolume.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
 #include "CapsuleVolume.h"
 #include "Ray.h"
+#include <cstdint>
 
 using NCL::Camera;
 using namespace NCL::Maths;
@@ -30,6 +32,11 @@ namespace NCL {
 			GameObject* b;		
 			mutable int		framesLeft;
 
+			//So pairs can still be found (and thrown away) once one of
+			//their objects has been removed from the world
+			GameObjectHandle handleA;
+			GameObjectHandle handleB;
+
 			ContactPoint point;
 
 			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
@@ -41,8 +48,9 @@ namespace NCL {
 
 			//Advanced collision detection / resolution
 			bool operator < (const CollisionInfo& other) const {
-				size_t otherHash = (size_t)other.a->GetWorldID() + ((size_t)other.b->GetWorldID() << 32);
-				size_t thisHash  = (size_t)a->GetWorldID()		 + ((size_t)b-> GetWorldID() << 32);
+				//64 bits even on 32 bit builds, so pairs always sort the same way
+				uint64_t otherHash	= (uint64_t)other.handleA.index + ((uint64_t)other.handleB.index << 32);
+				uint64_t thisHash	= (uint64_t)handleA.index		+ ((uint64_t)handleB.index << 32);
 
 				if (thisHash < otherHash) {
 					return true;
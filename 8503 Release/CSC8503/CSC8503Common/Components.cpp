@@ -0,0 +1,27 @@
+#include "Components.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "../../Common/Matrix3.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+void ColliderComponent::UpdateBroadphaseAABB(const Quaternion& orientation) {
+	if (!volume || !enabled) {
+		return;
+	}
+	if (volume->type == VolumeType::AABB) {
+		broadphaseAABB = ((AABBVolume&)*volume).GetHalfDimensions();
+	}
+	else if (volume->type == VolumeType::Sphere) {
+		float r = ((SphereVolume&)*volume).GetRadius();
+		broadphaseAABB = Vector3(r, r, r);
+	}
+	else if (volume->type == VolumeType::OBB) {
+		Matrix3 mat = Matrix3(orientation);
+		mat = mat.Absolute();
+		Vector3 halfSizes = ((OBBVolume&)*volume).GetHalfDimensions();
+		broadphaseAABB = mat * halfSizes;
+	}
+}
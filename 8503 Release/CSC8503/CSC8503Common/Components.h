@@ -0,0 +1,82 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include "../../Common/Quaternion.h"
+#include <cstdint>
+
+namespace NCL {
+	class CollisionVolume;
+	using namespace Maths;
+
+	namespace CSC8503 {
+		class GameObject;
+		class Transform;
+		class PhysicsObject;
+		class RenderObject;
+
+		/*
+		All of the kinds of data an object can have. Objects with the same
+		set of components share an archetype, and are stored next to each
+		other (see EntityRegistry), so a system that only cares about, say,
+		transforms and rigid bodies can walk straight through them.
+
+		Transforms, rigid bodies and renderables are just the Transform,
+		PhysicsObject and RenderObject classes, stored by value.
+		*/
+		enum class ComponentType {
+			Transform,
+			RigidBody,
+			Collider,
+			Renderable,
+			AIAgent,
+			Score,
+			MAX_COMPONENTS
+		};
+
+		typedef uint32_t ComponentMask;
+
+		inline ComponentMask ComponentBit(ComponentType type) {
+			return 1u << (uint32_t)type;
+		}
+
+		struct ColliderComponent {
+			CollisionVolume*	volume	= nullptr;
+			Vector3				broadphaseAABB;
+			//Turned off colliders keep their volume, so they can be turned back on
+			bool				enabled	= true;
+
+			void UpdateBroadphaseAABB(const Quaternion& orientation);
+		};
+
+		//Anything with its own game logic, that wants Update calling
+		struct AIAgentComponent {
+			GameObject* agent = nullptr;
+		};
+
+		struct ScoreComponent {
+			int		score		= 1000;
+			bool	grounded	= false;
+		};
+
+		//Which ComponentType each type is stored as
+		template <typename T> struct ComponentTraits;
+
+		template <> struct ComponentTraits<Transform> {
+			static const ComponentType type = ComponentType::Transform;
+		};
+		template <> struct ComponentTraits<PhysicsObject> {
+			static const ComponentType type = ComponentType::RigidBody;
+		};
+		template <> struct ComponentTraits<ColliderComponent> {
+			static const ComponentType type = ComponentType::Collider;
+		};
+		template <> struct ComponentTraits<RenderObject> {
+			static const ComponentType type = ComponentType::Renderable;
+		};
+		template <> struct ComponentTraits<AIAgentComponent> {
+			static const ComponentType type = ComponentType::AIAgent;
+		};
+		template <> struct ComponentTraits<ScoreComponent> {
+			static const ComponentType type = ComponentType::Score;
+		};
+	}
+}
@@ -1,13 +1,34 @@
 #pragma once
+#include <vector>
 
 namespace NCL {
 	namespace CSC8503 {
+		class GameObject;
+
 		class Constraint	{
 		public:
 			Constraint() {}
 			virtual ~Constraint() {}
 
 			virtual void UpdateConstraint(float dt) = 0;
+
+			/*
+			Constraints that can say which objects they touch can be batched
+			up with others that don't share any of them, and solved at the
+			same time. Those that can't are always solved on their own.
+			*/
+			virtual bool GetObjects(std::vector<GameObject*>& objects) const {
+				return false;
+			}
+
+			/*
+			Direct constraints solve themselves exactly, so they only need
+			running once per step, rather than over and over again along
+			with the iterative ones.
+			*/
+			virtual bool IsDirect() const {
+				return false;
+			}
 		};
 	}
 }
\ No newline at end of file
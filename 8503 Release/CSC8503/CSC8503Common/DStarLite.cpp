@@ -0,0 +1,279 @@
+#include "DStarLite.h"
+#include <cstdlib>
+#include <limits>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+//Up, down, left, right - the same as NavigationGrid's neighbours
+const int NEIGHBOUR_X[4] = { 0, 0, -1, 1 };
+const int NEIGHBOUR_Y[4] = { -1, 1, 0, 0 };
+
+DStarLite::DStarLite(const NavigationGrid& grid) : grid(grid) {
+	width			= grid.GetWidth();
+	height			= grid.GetHeight();
+	startCell		= -1;
+	goalCell		= -1;
+	lastStartCell	= -1;
+	keyModifier		= 0;
+	nodesExpanded	= 0;
+
+	costs.assign(width * height, 1.0f);
+	Reset();
+}
+
+DStarLite::~DStarLite() {
+}
+
+void DStarLite::Reset() {
+	g.assign(width * height, UNREACHABLE);
+	rhs.assign(width * height, UNREACHABLE);
+	openList.Reset(width * height);
+	keyModifier		= 0;
+	lastStartCell	= startCell;
+	if (goalCell >= 0) {
+		rhs[goalCell] = 0;
+		openList.Push(goalCell, CalculateKey(goalCell));
+	}
+}
+
+bool DStarLite::SetGoal(const Vector3& goal) {
+	int x, y;
+	if (!grid.GetCell(goal, x, y)) {
+		goalCell = -1;
+		return false;
+	}
+	int cell = (y * width) + x;
+	if (cell != goalCell) {
+		goalCell = cell;
+		Reset();
+	}
+	return true;
+}
+
+/*
+Moving doesn't change how far anything is from the goal - just the keys,
+which are partly based on how far things are from the agent. Rather than
+working all the keys out again, keyModifier goes up by how far the agent
+has moved, which keeps any new keys in line with the old ones.
+
+Like the flow field, an agent that's ended up slightly inside a wall
+starts from the open cell next to it.
+*/
+bool DStarLite::SetStart(const Vector3& start) {
+	int x, y;
+	if (!grid.GetCell(start, x, y)) {
+		return false;
+	}
+	for (int i = 0; i < 4 && !IsOpen(x, y); ++i) {
+		if (IsOpen(x + NEIGHBOUR_X[i], y + NEIGHBOUR_Y[i])) {
+			x += NEIGHBOUR_X[i];
+			y += NEIGHBOUR_Y[i];
+		}
+	}
+	int cell = (y * width) + x;
+	if (cell != startCell) {
+		if (lastStartCell >= 0) {
+			keyModifier += Heuristic(lastStartCell, cell);
+		}
+		lastStartCell	= cell;
+		startCell		= cell;
+	}
+	return true;
+}
+
+//Changing what it costs to get into a cell changes the distances of everything next to it
+void DStarLite::SetCellCost(int x, int y, float cost) {
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return;
+	}
+	int cell = (y * width) + x;
+	cost = cost < 1.0f ? 1.0f : cost; //or the heuristic could overestimate
+	if (costs[cell] == cost) {
+		return;
+	}
+	costs[cell] = cost;
+	for (int i = 0; i < 4; ++i) {
+		int nx = x + NEIGHBOUR_X[i];
+		int ny = y + NEIGHBOUR_Y[i];
+		if (IsOpen(nx, ny)) {
+			int neighbour = (ny * width) + nx;
+			UpdateRHS(neighbour);
+			UpdateCell(neighbour);
+		}
+	}
+}
+
+void DStarLite::SetBlocked(int x, int y, bool blocked) {
+	SetCellCost(x, y, blocked ? UNREACHABLE : 1.0f);
+}
+
+float DStarLite::Heuristic(int a, int b) const {
+	if (a < 0 || b < 0) {
+		return 0;
+	}
+	return (float)(std::abs((a % width) - (b % width)) + std::abs((a / width) - (b / width)));
+}
+
+DStarKey DStarLite::CalculateKey(int cell) const {
+	float best = g[cell] < rhs[cell] ? g[cell] : rhs[cell];
+	return { best + Heuristic(startCell, cell) + keyModifier, best };
+}
+
+//The cheapest way to the goal through any of a cell's neighbours
+void DStarLite::UpdateRHS(int cell) {
+	if (cell == goalCell) {
+		return;
+	}
+	int x = cell % width;
+	int y = cell / width;
+	float best = UNREACHABLE;
+	for (int i = 0; i < 4; ++i) {
+		int nx = x + NEIGHBOUR_X[i];
+		int ny = y + NEIGHBOUR_Y[i];
+		if (!IsOpen(nx, ny)) {
+			continue;
+		}
+		int neighbour = (ny * width) + nx;
+		float d = costs[neighbour] + g[neighbour];
+		if (d < best) {
+			best = d;
+		}
+	}
+	rhs[cell] = best;
+}
+
+//Anything whose distance doesn't match its neighbours needs looking at again
+void DStarLite::UpdateCell(int cell) {
+	bool inOpen = openList.Contains(cell);
+	if (g[cell] != rhs[cell]) {
+		if (inOpen) {
+			openList.UpdateKey(cell, CalculateKey(cell));
+		}
+		else {
+			openList.Push(cell, CalculateKey(cell));
+		}
+	}
+	else if (inOpen) {
+		openList.Remove(cell);
+	}
+}
+
+/*
+Cells are looked at in key order until the agent's own cell is settled.
+A cell that's got closer to the goal just passes that on to its
+neighbours; one that's got further away has to be reset, and has its
+neighbours work out their best route again.
+*/
+bool DStarLite::Replan() {
+	nodesExpanded = 0;
+	if (startCell < 0 || goalCell < 0) {
+		return false;
+	}
+	while (!openList.IsEmpty() &&
+		(openList.GetTopKey() < CalculateKey(startCell) || rhs[startCell] > g[startCell])) {
+		int current		= openList.GetTop();
+		DStarKey oldKey = openList.GetTopKey();
+		DStarKey newKey = CalculateKey(current);
+		if (oldKey < newKey) { //the agent's moved since this went in
+			openList.UpdateKey(current, newKey);
+			continue;
+		}
+		nodesExpanded++;
+		int x = current % width;
+		int y = current / width;
+		if (g[current] > rhs[current]) {
+			g[current] = rhs[current];
+			openList.Remove(current);
+			for (int i = 0; i < 4; ++i) {
+				int nx = x + NEIGHBOUR_X[i];
+				int ny = y + NEIGHBOUR_Y[i];
+				if (!IsOpen(nx, ny)) {
+					continue;
+				}
+				int neighbour = (ny * width) + nx;
+				if (neighbour != goalCell) {
+					float d = costs[current] + g[current];
+					if (d < rhs[neighbour]) {
+						rhs[neighbour] = d;
+					}
+				}
+				UpdateCell(neighbour);
+			}
+		}
+		else {
+			g[current] = UNREACHABLE;
+			UpdateRHS(current);
+			UpdateCell(current);
+			for (int i = 0; i < 4; ++i) {
+				int nx = x + NEIGHBOUR_X[i];
+				int ny = y + NEIGHBOUR_Y[i];
+				if (!IsOpen(nx, ny)) {
+					continue;
+				}
+				int neighbour = (ny * width) + nx;
+				UpdateRHS(neighbour);
+				UpdateCell(neighbour);
+			}
+		}
+	}
+	return rhs[startCell] < UNREACHABLE;
+}
+
+//The neighbour that's cheapest to get to the goal through, or -1 if none of them can
+int DStarLite::GetNextCell(int cell) const {
+	int x = cell % width;
+	int y = cell / width;
+	int best = -1;
+	float bestDistance = UNREACHABLE;
+	for (int i = 0; i < 4; ++i) {
+		int nx = x + NEIGHBOUR_X[i];
+		int ny = y + NEIGHBOUR_Y[i];
+		if (!IsOpen(nx, ny)) {
+			continue;
+		}
+		int neighbour = (ny * width) + nx;
+		float d = costs[neighbour] + g[neighbour];
+		if (d < bestDistance) {
+			bestDistance	= d;
+			best			= neighbour;
+		}
+	}
+	return best;
+}
+
+bool DStarLite::GetWaypoint(Vector3& waypoint, int stepsAhead) const {
+	if (startCell < 0 || goalCell < 0 || rhs[startCell] == UNREACHABLE) {
+		return false;
+	}
+	int cell = startCell;
+	for (int i = 0; i < stepsAhead && cell != goalCell; ++i) {
+		int next = GetNextCell(cell);
+		if (next < 0) {
+			break;
+		}
+		cell = next;
+	}
+	waypoint = grid.GetCellPosition(cell % width, cell / width);
+	return true;
+}
+
+bool DStarLite::GetPath(NavigationPath& outPath) const {
+	if (startCell < 0 || goalCell < 0 || rhs[startCell] == UNREACHABLE) {
+		return false;
+	}
+	std::vector<int> cells(1, startCell);
+	while (cells.back() != goalCell) {
+		int next = GetNextCell(cells.back());
+		if (next < 0 || (int)cells.size() > width * height) {
+			return false; //only if Replan hasn't been called since something changed
+		}
+		cells.emplace_back(next);
+	}
+	for (auto i = cells.rbegin(); i != cells.rend(); ++i) {
+		outPath.PushWaypoint(grid.GetCellPosition(*i % width, *i / width));
+	}
+	return true;
+}
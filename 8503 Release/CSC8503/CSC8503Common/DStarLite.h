@@ -0,0 +1,89 @@
+#pragma once
+#include "NavigationGrid.h"
+#include "NodeHeap.h"
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		struct DStarKey {
+			float primary;
+			float secondary;
+
+			bool operator<(const DStarKey& other) const {
+				return primary < other.primary || (primary == other.primary && secondary < other.secondary);
+			}
+		};
+
+		/*
+		D* Lite - a search that can be kept up to date as things move about,
+		rather than being started again from scratch. It searches backwards,
+		from the goal out towards the agent, and remembers how far every cell
+		it's looked at is from the goal. When a cell gets more expensive (or
+		blocked, or unblocked), only the cells whose distances that changes
+		get looked at again - and the agent moving along its path doesn't
+		throw anything away at all.
+
+		Each agent needs its own planner, on top of the shared grid's walls.
+		Entering a cell normally costs 1; SetCellCost makes it cost more
+		(moving obstacles, say), and a blocked cell can't be entered at all.
+		*/
+		class DStarLite {
+		public:
+			DStarLite(const NavigationGrid& grid);
+			~DStarLite();
+
+			//A new goal means starting the search again from scratch
+			bool SetGoal(const Vector3& goal);
+			bool SetStart(const Vector3& start);
+
+			void SetCellCost(int x, int y, float cost);
+			void SetBlocked(int x, int y, bool blocked);
+
+			float GetCellCost(int x, int y) const {
+				return costs[(y * width) + x];
+			}
+
+			//Brings the search up to date with any changes - false if there's no way to the goal
+			bool Replan();
+
+			//Where to head for, stepsAhead cells along the current best path
+			bool GetWaypoint(Vector3& waypoint, int stepsAhead = 1) const;
+
+			//The whole path, a waypoint on every cell, like NavigationGrid's
+			bool GetPath(NavigationPath& outPath) const;
+
+			//How many cells the last Replan had to look at
+			int GetNodesExpanded() const {
+				return nodesExpanded;
+			}
+
+		protected:
+			void		Reset();
+			DStarKey	CalculateKey(int cell) const;
+			void		UpdateCell(int cell);
+			void		UpdateRHS(int cell);
+			int			GetNextCell(int cell) const;
+
+			float Heuristic(int a, int b) const;
+
+			bool IsOpen(int x, int y) const {
+				return !grid.IsWall(x, y);
+			}
+
+			const NavigationGrid&	grid;
+			int						width;
+			int						height;
+
+			std::vector<float>	costs;	//to move into each cell
+			std::vector<float>	g;		//how far each cell is from the goal, as of the last time it was looked at
+			std::vector<float>	rhs;	//how far it should be, going by its neighbours
+			BasicNodeHeap<DStarKey> openList;
+
+			int		startCell;
+			int		goalCell;
+			int		lastStartCell;	//where the agent was when the keys were last worked out
+			float	keyModifier;	//how far it's moved since the search began
+			int		nodesExpanded;
+		};
+	}
+}
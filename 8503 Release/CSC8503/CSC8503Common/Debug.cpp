@@ -2,10 +2,10 @@
 #include "../../Common/Matrix4.h"
 using namespace NCL;
 
-OGLRenderer* Debug::renderer = nullptr;
+thread_local OGLRenderer* Debug::renderer = nullptr;
 
-std::vector<Debug::DebugStringEntry>	Debug::stringEntries;
-std::vector<Debug::DebugLineEntry>		Debug::lineEntries;
+thread_local std::vector<Debug::DebugStringEntry>	Debug::stringEntries;
+thread_local std::vector<Debug::DebugLineEntry>		Debug::lineEntries;
 
 const Vector4 Debug::RED	= Vector4(1, 0, 0, 1);
 const Vector4 Debug::GREEN	= Vector4(0, 1, 0, 1);
@@ -20,6 +20,9 @@ const Vector4 Debug::CYAN		= Vector4(0, 1, 1, 1);
 
 
 void Debug::Print(const std::string& text, const Vector2&pos, const Vector4& colour) {
+	if (!renderer) {
+		return;
+	}
 	DebugStringEntry newEntry;
 
 	newEntry.data		= text;
@@ -30,6 +33,9 @@ void Debug::Print(const std::string& text, const Vector2&pos, const Vector4& col
 }
 
 void Debug::DrawLine(const Vector3& startpoint, const Vector3& endpoint, const Vector4& colour, float time) {
+	if (!renderer) {
+		return;
+	}
 	DebugLineEntry newEntry;
 
 	newEntry.start	= startpoint;
@@ -4,6 +4,12 @@
 #include <string>
 
 namespace NCL {
+	/*
+	Lines and text are stored per thread, and only for threads that have
+	been given a renderer - so simulations being stepped on other threads
+	can call into Debug without fighting over the lists, and without
+	filling them up with lines nobody will ever draw.
+	*/
 	class Debug
 	{
 	public:
@@ -47,10 +53,10 @@ namespace NCL {
 		Debug() {}
 		~Debug() {}
 
-		static std::vector<DebugStringEntry>	stringEntries;
-		static std::vector<DebugLineEntry>	lineEntries;
+		static thread_local std::vector<DebugStringEntry>	stringEntries;
+		static thread_local std::vector<DebugLineEntry>	lineEntries;
 
-		static OGLRenderer* renderer;
+		static thread_local OGLRenderer* renderer;
 	};
 }
 
@@ -0,0 +1,189 @@
+#include "EntityRegistry.h"
+#include "GameObject.h"
+#include <new>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Chunks just hold raw memory, so these are how each type of component gets
+copied in and out of it.
+*/
+struct ComponentInfo {
+	size_t size;
+	void (*copy)(void* to, const void* from);
+	void (*destroy)(void* component);
+};
+
+template <typename T>
+static ComponentInfo MakeComponentInfo() {
+	return {
+		sizeof(T),
+		[](void* to, const void* from) { new (to) T(*(const T*)from); },
+		[](void* component) { ((T*)component)->~T(); }
+	};
+}
+
+static const ComponentInfo componentInfo[(int)ComponentType::MAX_COMPONENTS] = {
+	MakeComponentInfo<Transform>(),
+	MakeComponentInfo<PhysicsObject>(),
+	MakeComponentInfo<ColliderComponent>(),
+	MakeComponentInfo<RenderObject>(),
+	MakeComponentInfo<AIAgentComponent>(),
+	MakeComponentInfo<ScoreComponent>()
+};
+
+ArchetypeChunk::ArchetypeChunk(ComponentMask mask, int archetype) {
+	this->mask		= mask;
+	this->archetype = archetype;
+	this->count		= 0;
+	for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+		columns[i] = (mask & ComponentBit((ComponentType)i)) ? new char[componentInfo[i].size * CAPACITY] : nullptr;
+	}
+}
+
+ArchetypeChunk::~ArchetypeChunk() {
+	for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+		delete[] columns[i];
+	}
+}
+
+void* ArchetypeChunk::GetComponent(ComponentType type, int row) const {
+	return columns[(int)type] + componentInfo[(int)type].size * row;
+}
+
+EntityRegistry::EntityRegistry() {
+}
+
+EntityRegistry::~EntityRegistry() {
+	for (Archetype* a : archetypes) {
+		for (ArchetypeChunk* c : a->chunks) {
+			delete c;
+		}
+		delete a;
+	}
+}
+
+EntityRegistry::Archetype* EntityRegistry::GetArchetype(ComponentMask mask) {
+	for (Archetype* a : archetypes) {
+		if (a->mask == mask) {
+			return a;
+		}
+	}
+	Archetype* a	= new Archetype();
+	a->mask			= mask;
+	a->index		= (int)archetypes.size();
+	a->count		= 0;
+	archetypes.push_back(a);
+	return a;
+}
+
+void EntityRegistry::Add(GameObject* o) {
+	ComponentMask mask	= o->GetComponentMask();
+	Archetype* a		= GetArchetype(mask);
+
+	int chunkIndex = a->count / ArchetypeChunk::CAPACITY;
+	if (chunkIndex == (int)a->chunks.size()) {
+		a->chunks.push_back(new ArchetypeChunk(mask, a->index));
+	}
+	ArchetypeChunk* c	= a->chunks[chunkIndex];
+	int row				= c->count;
+
+	for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+		if (mask & ComponentBit((ComponentType)i)) {
+			componentInfo[i].copy(c->GetComponent((ComponentType)i, row), o->GetComponentData((ComponentType)i));
+		}
+	}
+	c->owners[row] = o;
+	c->count++;
+	a->count++;
+
+	o->BindComponents(this, c, row);
+}
+
+void EntityRegistry::AddBatch(ComponentMask mask, const void* const* data, GameObject* const* objects, int count) {
+	Archetype* a = GetArchetype(mask);
+
+	int added = 0;
+	while (added < count) {
+		int chunkIndex = a->count / ArchetypeChunk::CAPACITY;
+		if (chunkIndex == (int)a->chunks.size()) {
+			a->chunks.push_back(new ArchetypeChunk(mask, a->index));
+		}
+		ArchetypeChunk* c	= a->chunks[chunkIndex];
+		int space			= ArchetypeChunk::CAPACITY - c->count;
+		int n				= count - added < space ? count - added : space;
+
+		for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+			if (!(mask & ComponentBit((ComponentType)i))) {
+				continue;
+			}
+			const ComponentInfo& info = componentInfo[i];
+			for (int j = 0; j < n; ++j) {
+				const void* from = data[i] ? data[i] : objects[added + j]->GetComponentData((ComponentType)i);
+				info.copy(c->GetComponent((ComponentType)i, c->count + j), from);
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			c->owners[c->count + j] = objects[added + j];
+			objects[added + j]->BindComponents(this, c, c->count + j);
+		}
+		c->count	+= n;
+		a->count	+= n;
+		added		+= n;
+	}
+}
+
+void EntityRegistry::Clear() {
+	for (Archetype* a : archetypes) {
+		for (ArchetypeChunk* c : a->chunks) {
+			for (int row = 0; row < c->count; ++row) {
+				c->owners[row]->UnbindComponents(false);
+				for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+					if (c->mask & ComponentBit((ComponentType)i)) {
+						componentInfo[i].destroy(c->GetComponent((ComponentType)i, row));
+					}
+				}
+			}
+			c->count = 0;
+		}
+		a->count = 0;
+	}
+}
+
+/*
+To keep each archetype's objects packed together, the archetype's last
+object is moved into the gap.
+*/
+void EntityRegistry::Remove(GameObject* o, bool keepData) {
+	ArchetypeChunk* c = o->GetChunk();
+	if (!c) {
+		return;
+	}
+	int row			= o->GetChunkRow();
+	Archetype* a	= archetypes[c->archetype];
+
+	o->UnbindComponents(keepData);
+
+	int last				= a->count - 1;
+	ArchetypeChunk* lastC	= a->chunks[last / ArchetypeChunk::CAPACITY];
+	int lastRow				= last % ArchetypeChunk::CAPACITY;
+
+	for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+		if (!(c->mask & ComponentBit((ComponentType)i))) {
+			continue;
+		}
+		const ComponentInfo& info = componentInfo[i];
+		info.destroy(c->GetComponent((ComponentType)i, row));
+		if (lastC != c || lastRow != row) {
+			info.copy(c->GetComponent((ComponentType)i, row), lastC->GetComponent((ComponentType)i, lastRow));
+			info.destroy(lastC->GetComponent((ComponentType)i, lastRow));
+		}
+	}
+	if (lastC != c || lastRow != row) {
+		c->owners[row] = lastC->owners[lastRow];
+		c->owners[row]->BindComponents(this, c, row);
+	}
+	lastC->count--;
+	a->count--;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "Components.h"
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A fixed size block of objects that all have the same components.
+		Each component gets its own array, so (for example) every transform
+		in a chunk is right next to the one before it. The first GetCount()
+		entries of each array are in use - there are never any gaps.
+		*/
+		class ArchetypeChunk {
+		public:
+			static const int CAPACITY = 64;
+
+			int GetCount() const {
+				return count;
+			}
+
+			ComponentMask GetMask() const {
+				return mask;
+			}
+
+			GameObject* const* GetOwners() const {
+				return owners;
+			}
+
+			//nullptr if objects in this chunk don't have that component
+			template <typename T>
+			T* Get() const {
+				return (T*)columns[(int)ComponentTraits<T>::type];
+			}
+
+		protected:
+			friend class EntityRegistry;
+
+			ArchetypeChunk(ComponentMask mask, int archetype);
+			~ArchetypeChunk();
+
+			void* GetComponent(ComponentType type, int row) const;
+
+			ComponentMask	mask;
+			int				archetype;
+			int				count;
+			GameObject*		owners[CAPACITY];
+			char*			columns[(int)ComponentType::MAX_COMPONENTS];
+		};
+
+		/*
+		Stores the data of every object in a GameWorld, grouped up by
+		archetype. GameObjects are just a front end onto this - once an
+		object has been added, its getters point into the chunks, and if
+		an object gets moved about (when something else is removed), it's
+		told where its data has gone.
+
+		Chunks are never given back, so adding an object into a gap that
+		an old one left doesn't need any allocating.
+		*/
+		class EntityRegistry {
+		public:
+			EntityRegistry();
+			~EntityRegistry();
+
+			//The object's current components are copied in, and from then on
+			//it uses the registry's copies
+			void Add(GameObject* o);
+
+			/*
+			Adds a whole batch of objects that all have the same components,
+			filling up each chunk a column at a time. Where data[type] isn't
+			nullptr, every object gets a copy of it, rather than of its own.
+			*/
+			void AddBatch(ComponentMask mask, const void* const* data, GameObject* const* objects, int count);
+
+			//Objects that are about to be deleted don't need their data
+			//copying back out of the registry first
+			void Remove(GameObject* o, bool keepData = true);
+
+			//Lets go of every object at once, without copying anything back
+			//out - for when they're all about to be deleted anyway
+			void Clear();
+
+			/*
+			Calls func on every chunk of objects that have all of the
+			required components (and maybe more besides). Nothing should
+			be added or removed while this is running.
+			*/
+			template <typename Func>
+			void ForEachChunk(ComponentMask required, Func func) const {
+				for (const Archetype* a : archetypes) {
+					if ((a->mask & required) != required) {
+						continue;
+					}
+					for (ArchetypeChunk* c : a->chunks) {
+						if (c->count == 0) {
+							break; //only the last chunk in use is ever partly full
+						}
+						func(*c);
+					}
+				}
+			}
+
+			int GetNumArchetypes() const {
+				return (int)archetypes.size();
+			}
+
+		protected:
+			struct Archetype {
+				ComponentMask					mask;
+				std::vector<ArchetypeChunk*>	chunks;
+				int								index;
+				int								count;
+			};
+
+			Archetype* GetArchetype(ComponentMask mask);
+
+			std::vector<Archetype*> archetypes;
+		};
+	}
+}
@@ -0,0 +1,132 @@
+#include "FlowField.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const uint8_t NO_DIRECTION = 255;
+
+//Up, down, left, right - the same as NavigationGrid's neighbours
+const int NEIGHBOUR_X[4] = { 0, 0, -1, 1 };
+const int NEIGHBOUR_Y[4] = { -1, 1, 0, 0 };
+
+FlowField::FlowField(const NavigationGrid& grid) : grid(grid) {
+	goalX	= 0;
+	goalY	= 0;
+	hasGoal = false;
+}
+
+FlowField::FlowField(const NavigationGrid& grid, const Vector3& goal) : FlowField(grid) {
+	SetGoal(goal);
+}
+
+FlowField::~FlowField() {
+}
+
+void FlowField::SetGoal(const Vector3& goal) {
+	int x, y;
+	if (!grid.GetCell(goal, x, y)) {
+		hasGoal = false;
+		distances.clear();
+		directions.clear();
+		return;
+	}
+	if (hasGoal && x == goalX && y == goalY) {
+		return; //same cell, so the field's still right
+	}
+	goalX	= x;
+	goalY	= y;
+	hasGoal = true;
+	Rebuild();
+}
+
+/*
+Every move costs the same, so this is just a breadth first flood out from
+the goal - the first time a cell is reached is the shortest way to it, and
+the cell it was reached from is the way back.
+*/
+void FlowField::Rebuild() {
+	int width	= grid.GetWidth();
+	int height	= grid.GetHeight();
+	distances.assign(width * height, -1);
+	directions.assign(width * height, NO_DIRECTION);
+	if (!hasGoal || grid.IsWall(goalX, goalY)) {
+		return;
+	}
+	std::vector<int> frontier;
+	frontier.reserve(width * height);
+
+	int goalCell = (goalY * width) + goalX;
+	distances[goalCell] = 0;
+	frontier.emplace_back(goalCell);
+
+	for (size_t next = 0; next < frontier.size(); ++next) {
+		int cell	= frontier[next];
+		int x		= cell % width;
+		int y		= cell / width;
+		for (int i = 0; i < 4; ++i) {
+			int nx = x + NEIGHBOUR_X[i];
+			int ny = y + NEIGHBOUR_Y[i];
+			if (grid.IsWall(nx, ny)) {
+				continue;
+			}
+			int neighbour = (ny * width) + nx;
+			if (distances[neighbour] >= 0) {
+				continue;
+			}
+			distances[neighbour]	= distances[cell] + 1;
+			directions[neighbour]	= (uint8_t)(i ^ 1); //back the way we came
+			frontier.emplace_back(neighbour);
+		}
+	}
+}
+
+/*
+Agents can end up slightly inside a wall cell - if so, they just head for
+whichever open cell next to them is closest to the goal, like A* would.
+*/
+int FlowField::GetStartCell(const Vector3& from) const {
+	int x, y;
+	if (distances.empty() || !grid.GetCell(from, x, y)) {
+		return -1;
+	}
+	int width	= grid.GetWidth();
+	int cell	= (y * width) + x;
+	if (distances[cell] >= 0) {
+		return cell;
+	}
+	int best = -1;
+	for (int i = 0; i < 4; ++i) {
+		int nx = x + NEIGHBOUR_X[i];
+		int ny = y + NEIGHBOUR_Y[i];
+		if (grid.IsWall(nx, ny)) {
+			continue;
+		}
+		int neighbour = (ny * width) + nx;
+		if (distances[neighbour] >= 0 && (best < 0 || distances[neighbour] < distances[best])) {
+			best = neighbour;
+		}
+	}
+	return best;
+}
+
+bool FlowField::GetWaypoint(const Vector3& from, Vector3& waypoint, int stepsAhead) const {
+	int cell = GetStartCell(from);
+	if (cell < 0) {
+		return false;
+	}
+	int width	= grid.GetWidth();
+	int x		= cell % width;
+	int y		= cell / width;
+	for (int i = 0; i < stepsAhead && directions[(y * width) + x] != NO_DIRECTION; ++i) {
+		int d = directions[(y * width) + x];
+		x += NEIGHBOUR_X[d];
+		y += NEIGHBOUR_Y[d];
+	}
+	waypoint = grid.GetCellPosition(x, y);
+	return true;
+}
+
+int FlowField::GetDistance(const Vector3& from) const {
+	int cell = GetStartCell(from);
+	return cell < 0 ? -1 : distances[cell];
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A 'Dijkstra map' for everyone heading to the same place. Every
+		cell's distance from the goal is worked out in one go, along with
+		which way to step to get closer to it - so asking how to get to the
+		goal from anywhere is just a lookup, however many agents ask.
+
+		The field is only rebuilt when the goal moves to a different cell,
+		or when Rebuild is called (if the map itself has changed). Lookups
+		don't change anything, so any number of agents can use it at once,
+		as long as nothing is rebuilding it at the time.
+		*/
+		class FlowField {
+		public:
+			FlowField(const NavigationGrid& grid);
+			FlowField(const NavigationGrid& grid, const Vector3& goal);
+			~FlowField();
+
+			void SetGoal(const Vector3& goal);
+			void Rebuild();
+
+			/*
+			Where to head for, stepsAhead cells along the way to the goal
+			(or the goal itself, if that's closer). False if the goal can't
+			be reached from there at all.
+			*/
+			bool GetWaypoint(const Vector3& from, Vector3& waypoint, int stepsAhead = 1) const;
+
+			//How many steps from the goal a position is, or -1 if it can't get there
+			int GetDistance(const Vector3& from) const;
+
+		protected:
+			int GetStartCell(const Vector3& from) const;
+
+			const NavigationGrid&	grid;
+			int						goalX;
+			int						goalY;
+			bool					hasGoal;
+
+			std::vector<int>		distances;	//-1 for unreachable
+			std::vector<uint8_t>	directions;	//which neighbour is one step closer
+		};
+	}
+}
@@ -1,46 +1,226 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
+#include "PhysicsCommandQueue.h"
+#include "EntityRegistry.h"
+#include "LevelArena.h"
 
 using namespace NCL::CSC8503;
 
+template <typename T>
+static void ReleasePart(LevelArena* arena, T* part) {
+	if (arena && arena->Owns(part)) {
+		arena->Delete(part);
+	}
+	else {
+		delete part;
+	}
+}
+
 GameObject::GameObject(string objectName)	{
 	name			= objectName;
 	worldID			= -1;
 	isActive		= true;
-	boundingVolume	= nullptr;
+	isAgent			= false;
 	physicsObject	= nullptr;
 	renderObject	= nullptr;
+	agentData.agent	= this;
+
+	transformData	= &transform;
+	collider		= &localCollider;
+	scoreData		= &localScore;
+	registry		= nullptr;
+	chunk			= nullptr;
+	chunkRow		= -1;
+	arena			= nullptr;
 }
 
 GameObject::~GameObject()	{
-	delete boundingVolume;
-	delete physicsObject;
-	delete renderObject;
+	CollisionVolume* volume = collider->volume;
+	if (registry) {
+		registry->Remove(this, false);
+	}
+	else {
+		ReleasePart(arena, physicsObject);
+		ReleasePart(arena, renderObject);
+	}
+	ReleasePart(arena, volume);
+}
+
+/*
+Changing which components an object has means moving it to a different
+archetype, so it's just taken out of the registry and put back in again.
+*/
+void GameObject::SetBoundingVolume(CollisionVolume* vol) {
+	EntityRegistry* r = registry;
+	if (r) {
+		r->Remove(this);
+	}
+	collider->volume = vol;
+	if (r) {
+		r->Add(this);
+	}
+}
+
+void GameObject::SetPhysicsObject(PhysicsObject* newObject) {
+	EntityRegistry* r = registry;
+	if (r) {
+		r->Remove(this);
+		delete physicsObject; //the copy the registry handed back
+	}
+	physicsObject = newObject;
+	if (physicsObject) {
+		physicsObject->SetOwner(this);
+	}
+	if (r) {
+		r->Add(this);
+	}
+}
+
+void GameObject::SetRenderObject(RenderObject* newObject) {
+	EntityRegistry* r = registry;
+	if (r) {
+		r->Remove(this);
+		delete renderObject;
+	}
+	renderObject = newObject;
+	if (r) {
+		r->Add(this);
+	}
+}
+
+void GameObject::SetAIAgent(bool state) {
+	EntityRegistry* r = registry;
+	if (r) {
+		r->Remove(this);
+	}
+	isAgent = state;
+	if (r) {
+		r->Add(this);
+	}
+}
+
+ComponentMask GameObject::GetComponentMask() const {
+	ComponentMask mask = ComponentBit(ComponentType::Transform) | ComponentBit(ComponentType::Score);
+	if (physicsObject) {
+		mask |= ComponentBit(ComponentType::RigidBody);
+	}
+	if (collider->volume) {
+		mask |= ComponentBit(ComponentType::Collider);
+	}
+	if (renderObject) {
+		mask |= ComponentBit(ComponentType::Renderable);
+	}
+	if (isAgent) {
+		mask |= ComponentBit(ComponentType::AIAgent);
+	}
+	return mask;
+}
+
+const void* GameObject::GetComponentData(ComponentType type) const {
+	switch (type) {
+		case ComponentType::Transform:	return transformData;
+		case ComponentType::RigidBody:	return physicsObject;
+		case ComponentType::Collider:	return collider;
+		case ComponentType::Renderable:	return renderObject;
+		case ComponentType::AIAgent:	return &agentData;
+		case ComponentType::Score:		return scoreData;
+		default:						return nullptr;
+	}
+}
+
+/*
+The first time an object is bound, the registry has just taken copies of
+its physics and render objects, so the originals can go.
+*/
+void GameObject::BindComponents(EntityRegistry* r, ArchetypeChunk* c, int row) {
+	if (!registry) {
+		ReleasePart(arena, physicsObject);
+		ReleasePart(arena, renderObject);
+	}
+	registry	= r;
+	chunk		= c;
+	chunkRow	= row;
+
+	transformData	= &c->Get<Transform>()[row];
+	scoreData		= &c->Get<ScoreComponent>()[row];
+	collider		= c->Get<ColliderComponent>()	? &c->Get<ColliderComponent>()[row] : &localCollider;
+	physicsObject	= c->Get<PhysicsObject>()		? &c->Get<PhysicsObject>()[row]		: nullptr;
+	renderObject	= c->Get<RenderObject>()		? &c->Get<RenderObject>()[row]		: nullptr;
+
+	if (physicsObject) {
+		physicsObject->SetTransform(transformData);
+		physicsObject->SetOwner(this);
+	}
+	if (renderObject) {
+		renderObject->SetTransform(transformData);
+	}
+}
+
+void GameObject::UnbindComponents(bool keepData) {
+	if (keepData) {
+		transform		= *transformData;
+		localCollider	= *collider;
+		localScore		= *scoreData;
+		physicsObject	= physicsObject ? new PhysicsObject(*physicsObject) : nullptr;
+		renderObject	= renderObject	? new RenderObject(*renderObject)	: nullptr;
+		if (physicsObject) {
+			physicsObject->SetTransform(&transform);
+		}
+		if (renderObject) {
+			renderObject->SetTransform(&transform);
+		}
+	}
+	else {
+		localCollider.volume = collider->volume; //still needs cleaning up
+		physicsObject	= nullptr;
+		renderObject	= nullptr;
+	}
+	transformData	= &transform;
+	collider		= &localCollider;
+	scoreData		= &localScore;
+	registry		= nullptr;
+	chunk			= nullptr;
+	chunkRow		= -1;
 }
 
 bool GameObject::GetBroadphaseAABB(Vector3&outSize) const {
-	if (!boundingVolume) {
+	if (!GetBoundingVolume()) {
 		return false;
 	}
-	outSize = broadphaseAABB;
+	outSize = collider->broadphaseAABB;
 	return true;
 }
 
 void GameObject::UpdateBroadphaseAABB() {
-	if (!boundingVolume) {
-		return;
-	}
-	if (boundingVolume->type == VolumeType::AABB) {
-		broadphaseAABB = ((AABBVolume&)*boundingVolume).GetHalfDimensions();
+	collider->UpdateBroadphaseAABB(transformData->GetOrientation());
+}
+Vector3 GameObject::GetGamePosition() const {
+	return hasPublishedState ? publishedPosition : transformData->GetPosition();
+}
+
+Quaternion GameObject::GetGameOrientation() const {
+	return hasPublishedState ? publishedOrientation : transformData->GetOrientation();
+}
+
+Vector3 GameObject::GetGameLinearVelocity() const {
+	if (hasPublishedState) {
+		return publishedVelocity;
 	}
-	else if (boundingVolume->type == VolumeType::Sphere) {
-		float r = ((SphereVolume&)*boundingVolume).GetRadius();
-		broadphaseAABB = Vector3(r, r, r);
+	return physicsObject ? physicsObject->GetLinearVelocity() : Vector3();
+}
+
+void GameObject::MoveTo(const Vector3& position) {
+	if (physicsObject && physicsObject->GetCommandQueue()) {
+		physicsObject->GetCommandQueue()->Push({ PhysicsCommandType::SetPosition, this, position, Vector3() });
+		return;
 	}
-	else if (boundingVolume->type == VolumeType::OBB) {
-		Matrix3 mat = Matrix3(transform.GetOrientation());
-		mat = mat.Absolute();
-		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
-		broadphaseAABB = mat * halfSizes;
+	transformData->SetPosition(position);
+}
+
+void GameObject::DisableCollisions() {
+	if (physicsObject && physicsObject->GetCommandQueue()) {
+		physicsObject->GetCommandQueue()->Push({ PhysicsCommandType::DisableCollisions, this, Vector3(), Vector3() });
+		return;
 	}
-}
\ No newline at end of file
+	SetCollisionsEnabled(false);
+}
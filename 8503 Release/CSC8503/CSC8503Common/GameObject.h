@@ -4,25 +4,48 @@
 
 #include "PhysicsObject.h"
 #include "RenderObject.h"
+#include "Components.h"
 
 #include <vector>
+#include <atomic>
 
 using std::vector;
 
 namespace NCL {
 	namespace CSC8503 {
-
+		class EntityRegistry;
+		class ArchetypeChunk;
+		class LevelArena;
+
+		/*
+		Until it's added to a world, an object keeps all of its own data.
+		After that, its data lives in the world's EntityRegistry, alongside
+		every other object with the same components, and the object just
+		points at it - so everything here still works the same either way.
+
+		Adding or removing a physics object, render object, bounding volume
+		or AI once the object is in a world moves it to another archetype,
+		so it's best to set them all up first.
+		*/
 		class GameObject {
 		public:
 			GameObject(string name = "");
-			~GameObject();
+			virtual ~GameObject();
 
-			void SetBoundingVolume(CollisionVolume* vol) {
-				boundingVolume = vol;
-			}
+			void SetBoundingVolume(CollisionVolume* vol);
 
+			//Objects with collisions turned off keep hold of their volume,
+			//so that they can be turned back on again (by a snapshot restore)
 			const CollisionVolume* GetBoundingVolume() const {
-				return boundingVolume;
+				return collider->enabled ? collider->volume : nullptr;
+			}
+
+			void SetCollisionsEnabled(bool state) {
+				collider->enabled = state;
+			}
+
+			bool AreCollisionsEnabled() const {
+				return collider->enabled;
 			}
 
 			bool IsActive() const {
@@ -38,7 +61,7 @@ namespace NCL {
 			}
 
 			Transform& GetTransform() {
-				return transform;
+				return *transformData;
 			}
 
 			RenderObject* GetRenderObject() const {
@@ -49,42 +72,98 @@ namespace NCL {
 				return physicsObject;
 			}
 
-			void SetRenderObject(RenderObject* newObject) {
-				renderObject = newObject;
-			}
+			/*
+			The object takes ownership of whatever it's given. Once it's in
+			a world, the registry takes a copy, and the one passed in here
+			is deleted straight away - so use GetPhysicsObject afterwards,
+			rather than holding on to the pointer.
+
+			The same goes for what the getters return: that's a pointer
+			into the registry, which is only good until something is next
+			added to or removed from the world, or has its components
+			changed, as that can move this object's data. Anything that
+			needs to hold on to an object for longer should keep the
+			GameObject (or better, its handle) and ask it each time.
+			*/
+			void SetRenderObject(RenderObject* newObject);
+			void SetPhysicsObject(PhysicsObject* newObject);
 
-			void SetPhysicsObject(PhysicsObject* newObject) {
-				physicsObject = newObject;
+			//Agents get Update called on them by whatever runs the game's AI
+			void SetAIAgent(bool state);
+
+			bool IsAIAgent() const {
+				return isAgent;
 			}
 
 			const string& GetName() const {
 				return name;
 			}
 
+			//Game logic / AI, for objects that have any
+			virtual void Update(float dt) {
+			}
+
+			/*
+			With physics on its own thread, these are called on the game
+			thread (by PhysicsThread::ApplySnapshot) while physics carries on
+			stepping. Only the physics thread may change anything physics
+			can see, so collisions, positions and forces must be changed
+			through DisableCollisions, MoveTo and AddForce, which queue it up
+			- never directly. Scores and the active flag are the game's own.
+			*/
 			virtual void OnCollisionBegin(GameObject* otherObject) {
 				//std::cout << "OnCollisionBegin event occured!\n";
 				//Is currently in collision with a 0 invmass (fixed) object and therefore can jump
-				if (otherObject->GetTransform().GetPosition().y < GetTransform().GetPosition().y && otherObject->GetName() == "World") {
-					grounded = true;
+				if (otherObject->GetGamePosition().y < GetGamePosition().y && otherObject->GetName() == "World") {
+					scoreData->grounded = true;
 				}
 				if ((name == "Player" || name == "Enemy") && otherObject->GetName() == "Coin") {
 					IncrementScore();
 					otherObject->Deactivate();
-					otherObject->SetBoundingVolume(nullptr);
+					otherObject->DisableCollisions();
 				}
 				if ((otherObject->GetName() == "Player" || otherObject->GetName() == "Enemy") && name == "Coin") {
 					otherObject->IncrementScore();
 					Deactivate();
-					SetBoundingVolume(nullptr);
+					DisableCollisions();
 				}
 			}
 
+			//otherObject is nullptr if it's just been removed from the world
 			virtual void OnCollisionEnd(GameObject* otherObject) {
-				grounded = false;
+				scoreData->grounded = false;
 			}
 
 			bool IsGrounded() {
-				return grounded;
+				return scoreData->grounded;
+			}
+
+			void SetGrounded(bool state) {
+				scoreData->grounded = state;
+			}
+
+			/*
+			When physics is running on its own thread, the transform and
+			velocities belong to it. The game should use these instead,
+			which read the state that physics last published, and queue
+			up any changes for the physics thread to make.
+			*/
+			Vector3		GetGamePosition() const;
+			Quaternion	GetGameOrientation() const;
+			Vector3		GetGameLinearVelocity() const;
+
+			void MoveTo(const Vector3& position);
+			void DisableCollisions();
+
+			void SetPublishedState(const Vector3& position, const Quaternion& orientation, const Vector3& linearVelocity) {
+				publishedPosition		= position;
+				publishedOrientation	= orientation;
+				publishedVelocity		= linearVelocity;
+				hasPublishedState		= true;
+			}
+
+			void ClearPublishedState() {
+				hasPublishedState = false;
 			}
 
 			bool GetBroadphaseAABB(Vector3&outsize) const;
@@ -100,36 +179,76 @@ namespace NCL {
 			}
 
 			int		GetScore() const {
-				return score;
+				return scoreData->score;
 			}
 
 			void	SetScore(int s) {
-				score = abs(s);
+				scoreData->score = abs(s);
 			}
 
 			void	DecrementScore() {
-				score = score - 10 < 0 ? 0 : score - 10;
+				scoreData->score = scoreData->score - 10 < 0 ? 0 : scoreData->score - 10;
 			}
 
 			void	IncrementScore() {
-				score = score + 25;
+				scoreData->score = scoreData->score + 25;
 			}
 
-		protected:
-			Transform			transform;
+			//For the EntityRegistry to move the object's data in and out
+			ComponentMask	GetComponentMask() const;
+			const void*		GetComponentData(ComponentType type) const;
+			void			BindComponents(EntityRegistry* registry, ArchetypeChunk* chunk, int row);
+			void			UnbindComponents(bool keepData);
+
+			ArchetypeChunk* GetChunk() const {
+				return chunk;
+			}
 
-			bool grounded = false;
+			/*
+			Objects made in a GameWorld's arena are never deleted, just
+			destructed. Their volume, physics and render objects can come
+			from the same arena, or from new, and are cleaned up to match.
+			*/
+			void SetArena(LevelArena* a) {
+				arena = a;
+			}
 
-			CollisionVolume*	boundingVolume;
+			LevelArena* GetArena() const {
+				return arena;
+			}
+
+			int GetChunkRow() const {
+				return chunkRow;
+			}
+
+		protected:
+			//Only used while the object isn't in a world
+			Transform			transform;
+			ColliderComponent	localCollider;
+			ScoreComponent		localScore;
+			AIAgentComponent	agentData;
+
+			//Either the local copies, or the registry's
+			Transform*			transformData;
+			ColliderComponent*	collider;
+			ScoreComponent*		scoreData;
 			PhysicsObject*		physicsObject;
 			RenderObject*		renderObject;
 
-			bool	isActive;
-			int		score = 1000;
+			EntityRegistry*		registry;
+			ArchetypeChunk*		chunk;
+			int					chunkRow;
+			LevelArena*			arena;
+
+			std::atomic<bool>	isActive; //set from collision callbacks
+			bool	isAgent;
 			int		worldID;
 			string	name;
 
-			Vector3 broadphaseAABB;
+			bool		hasPublishedState = false;
+			Vector3		publishedPosition;
+			Quaternion	publishedOrientation;
+			Vector3		publishedVelocity;
 		};
 	}
 }
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A safe way of holding on to an object in a GameWorld. The index is
+		the object's world ID (its slot in the world), and the generation
+		counts how many times that slot has been reused - once an object is
+		removed, any handles to it stop working, rather than pointing at
+		whatever ends up in its slot next.
+		*/
+		struct GameObjectHandle {
+			static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+			uint32_t index		= INVALID_INDEX;
+			uint32_t generation	= 0;
+
+			bool IsNull() const {
+				return index == INVALID_INDEX;
+			}
+
+			bool operator==(const GameObjectHandle& other) const {
+				return index == other.index && generation == other.generation;
+			}
+
+			bool operator!=(const GameObjectHandle& other) const {
+				return !(*this == other);
+			}
+		};
+	}
+}
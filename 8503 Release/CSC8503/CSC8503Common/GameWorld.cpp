@@ -2,6 +2,7 @@
 #include "GameObject.h"
 #include "Constraint.h"
 #include "CollisionDetection.h"
+#include "WorldSnapshot.h"
 #include "../../Common/Camera.h"
 #include <algorithm>
 
@@ -13,36 +14,180 @@ GameWorld::GameWorld()	{
 
 	shuffleConstraints	= false;
 	shuffleObjects		= false;
-	worldIDCounter		= 0;
+	constraintVersion	= 0;
+	removalVersion		= 0;
+	randomState			= 0;
 }
 
+/*
+The world is going away, so nothing is copied back out of the registry -
+whatever's still in it is left without any physics or render data.
+*/
 GameWorld::~GameWorld()	{
+	entities.Clear();
+	Clear();
 }
 
+/*
+The objects are still alive afterwards, so they each get their data handed
+back. Every slot is freed, but keeps its generation, so handles from before
+the clear don't suddenly start pointing at the new objects.
+*/
 void GameWorld::Clear() {
+	for (GameObject* o : gameObjects) {
+		entities.Remove(o);
+		o->SetWorldID(-1);
+	}
 	gameObjects.clear();
+	freeSlots.clear();
+	for (int i = (int)slots.size() - 1; i >= 0; --i) {
+		if (slots[i].denseIndex >= 0) {
+			slots[i].generation++;
+			slots[i].denseIndex = -1;
+		}
+		freeSlots.emplace_back(i);
+	}
+	pendingRemovals.clear();
+	removalVersion++;
 	constraints.clear();
+	addedConstraints.clear();
+	constraintVersion++;
 }
 
+/*
+The registry lets go of everything in one pass first, so that removing
+each object doesn't shuffle the others around. Anything that came from
+the arena just gets its destructor called, and the arena is then reset.
+*/
 void GameWorld::ClearAndErase() {
+	entities.Clear();
 	for (auto& i : gameObjects) {
-		delete i;
+		DeleteObject(i);
 	}
 	for (auto& i : constraints) {
-		delete i;
+		DeleteConstraint(i);
 	}
+	gameObjects.clear();
 	Clear();
+	arena.Reset();
+}
+
+void GameWorld::DeleteObject(GameObject* o) {
+	if (o->GetArena() == &arena) {
+		arena.Delete(o);
+	}
+	else {
+		delete o;
+	}
+}
+
+void GameWorld::DeleteConstraint(Constraint* c) {
+	if (arena.Owns(c)) {
+		arena.Delete(c);
+	}
+	else {
+		delete c;
+	}
+}
+
+GameObjectHandle GameWorld::AddGameObject(GameObject* o) {
+	GameObjectHandle h = AssignSlot(o);
+	entities.Add(o);
+	return h;
 }
 
-void GameWorld::AddGameObject(GameObject* o) {
+void GameWorld::AddPrefabInstances(const Prefab& prefab, const Vector3* positions) {
+	int count = (int)spawnedObjects.size();
+	gameObjects.reserve(gameObjects.size() + count);
+	for (GameObject* o : spawnedObjects) {
+		AssignSlot(o);
+	}
+	const void* data[(int)ComponentType::MAX_COMPONENTS];
+	for (int i = 0; i < (int)ComponentType::MAX_COMPONENTS; ++i) {
+		data[i] = prefab.GetComponentData((ComponentType)i);
+	}
+	//The collider and AI come from the objects themselves
+	ComponentMask mask = prefab.GetComponentMask() | spawnedObjects[0]->GetComponentMask();
+	entities.AddBatch(mask, data, spawnedObjects.data(), count);
+
+	for (int i = 0; i < count; ++i) {
+		spawnedObjects[i]->GetTransform().SetPosition(positions[i]);
+	}
+	spawnedObjects.clear();
+}
+
+GameObjectHandle GameWorld::AssignSlot(GameObject* o) {
+	uint32_t index;
+	if (freeSlots.empty()) {
+		index = (uint32_t)slots.size();
+		slots.push_back({ 0, -1 });
+	}
+	else {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	slots[index].denseIndex = (int)gameObjects.size();
 	gameObjects.emplace_back(o);
-	o->SetWorldID(worldIDCounter++);
+	o->SetWorldID((int)index);
+	return { index, slots[index].generation };
 }
 
 void GameWorld::RemoveGameObject(GameObject* o, bool andDelete) {
-	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+	GameObjectHandle h = GetHandle(o);
+	if (h.IsNull()) {
+		return;
+	}
+	int dense = slots[h.index].denseIndex;
+	GameObject* last = gameObjects.back();
+	gameObjects[dense] = last;
+	slots[last->GetWorldID()].denseIndex = dense;
+	gameObjects.pop_back();
+
+	slots[h.index].denseIndex = -1;
+	slots[h.index].generation++;
+	freeSlots.emplace_back(h.index);
+	o->SetWorldID(-1);
+	removalVersion++;
+
 	if (andDelete) {
-		delete o;
+		DeleteObject(o);
+	}
+	else {
+		entities.Remove(o);
+	}
+}
+
+void GameWorld::DestroyGameObject(GameObjectHandle h) {
+	if (IsValid(h)) {
+		pendingRemovals.emplace_back(h);
+	}
+}
+
+void GameWorld::FlushRemovals() {
+	for (GameObjectHandle h : pendingRemovals) {
+		//Might have been queued up twice
+		if (GameObject* o = GetGameObject(h)) {
+			RemoveGameObject(o, true);
+		}
+	}
+	pendingRemovals.clear();
+}
+
+GameObject* GameWorld::GetGameObject(GameObjectHandle h) const {
+	return IsValid(h) ? gameObjects[slots[h.index].denseIndex] : nullptr;
+}
+
+GameObjectHandle GameWorld::GetHandle(const GameObject* o) const {
+	int id = o ? o->GetWorldID() : -1;
+	if (id < 0 || id >= (int)slots.size() || slots[id].denseIndex < 0 || gameObjects[slots[id].denseIndex] != o) {
+		return GameObjectHandle();
+	}
+	return { (uint32_t)id, slots[id].generation };
+}
+
+void GameWorld::UpdateDenseIndices() {
+	for (int i = 0; i < (int)gameObjects.size(); ++i) {
+		slots[gameObjects[i]->GetWorldID()].denseIndex = i;
 	}
 }
 
@@ -60,16 +205,184 @@ void GameWorld::OperateOnContents(GameObjectFunc f) {
 	}
 }
 
+GameObject* GameWorld::GetObjectByID(int id) const {
+	if (id < 0 || id >= (int)slots.size() || slots[id].denseIndex < 0) {
+		return nullptr;
+	}
+	return gameObjects[slots[id].denseIndex];
+}
+
+uint32_t GameWorld::NextRandom() {
+	uint64_t z = (randomState += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+/*
+std::shuffle is free to do things differently on each compiler, so the
+shuffle is written out here (Fisher-Yates) to keep lockstep games in step.
+*/
+template <typename T>
+void GameWorld::Shuffle(std::vector<T>& items) {
+	for (size_t i = items.size(); i > 1; --i) {
+		size_t j = NextRandom() % i;
+		std::swap(items[i - 1], items[j]);
+	}
+}
+
 void GameWorld::UpdateWorld(float dt) {
 	if (shuffleObjects) {
-		std::random_shuffle(gameObjects.begin(), gameObjects.end());
+		Shuffle(gameObjects);
+		UpdateDenseIndices();
 	}
 
 	if (shuffleConstraints) {
-		std::random_shuffle(constraints.begin(), constraints.end());
+		//Always shuffled from the order they were added in, so the order
+		//only depends on the random state, which snapshots keep hold of
+		constraints = addedConstraints;
+		Shuffle(constraints);
+		constraintVersion++;
+	}
+}
+
+void GameWorld::Snapshot(WorldSnapshot& snapshot) const {
+	int count = (int)gameObjects.size();
+	snapshot.SetNumObjects(count);
+	snapshot.GetHeader().numSlots		= (int)slots.size();
+	snapshot.GetHeader().randomState	= randomState;
+
+	int32_t*	ids		= snapshot.GetObjectIDs();
+	uint8_t*	flags	= snapshot.GetObjectFlags();
+	int32_t*	scores	= snapshot.GetObjectScores();
+	float*		values[WorldSnapshot::NUM_OBJECT_VALUES];
+	for (int v = 0; v < WorldSnapshot::NUM_OBJECT_VALUES; ++v) {
+		values[v] = snapshot.GetObjectValues(v);
+	}
+
+	for (int i = 0; i < count; ++i) {
+		GameObject* o		= gameObjects[i];
+		const Transform& t	= o->GetTransform();
+		const PhysicsObject* phys = o->GetPhysicsObject();
+
+		ids[i]		= o->GetWorldID();
+		scores[i]	= o->GetScore();
+		flags[i]	= (o->IsActive()				? WorldSnapshot::FlagActive		: 0) |
+					  (o->AreCollisionsEnabled()	? WorldSnapshot::FlagCollisions	: 0) |
+					  (o->IsGrounded()				? WorldSnapshot::FlagGrounded	: 0) |
+					  (phys							? WorldSnapshot::FlagPhysics	: 0);
+
+		Vector3		position	= t.GetPosition();
+		Quaternion	orientation = t.GetOrientation();
+		Vector3		scale		= t.GetScale();
+		values[WorldSnapshot::PositionX][i] = position.x;
+		values[WorldSnapshot::PositionY][i] = position.y;
+		values[WorldSnapshot::PositionZ][i] = position.z;
+		values[WorldSnapshot::OrientationX][i] = orientation.x;
+		values[WorldSnapshot::OrientationY][i] = orientation.y;
+		values[WorldSnapshot::OrientationZ][i] = orientation.z;
+		values[WorldSnapshot::OrientationW][i] = orientation.w;
+		values[WorldSnapshot::ScaleX][i] = scale.x;
+		values[WorldSnapshot::ScaleY][i] = scale.y;
+		values[WorldSnapshot::ScaleZ][i] = scale.z;
+
+		if (!phys) {
+			for (int v = WorldSnapshot::InverseMass; v < WorldSnapshot::NUM_OBJECT_VALUES; ++v) {
+				values[v][i] = 0.0f;
+			}
+			continue;
+		}
+		Vector3 linear	= phys->GetLinearVelocity();
+		Vector3 force	= phys->GetForce();
+		Vector3 angular = phys->GetAngularVelocity();
+		Vector3 torque	= phys->GetTorque();
+		Vector3 inertia = phys->GetLocalInverseInertia();
+		values[WorldSnapshot::InverseMass][i]	= phys->GetInverseMass();
+		values[WorldSnapshot::Elasticity][i]	= phys->GetElasticity();
+		values[WorldSnapshot::Friction][i]		= phys->GetFriction();
+		values[WorldSnapshot::LinearVelocityX][i] = linear.x;
+		values[WorldSnapshot::LinearVelocityY][i] = linear.y;
+		values[WorldSnapshot::LinearVelocityZ][i] = linear.z;
+		values[WorldSnapshot::ForceX][i] = force.x;
+		values[WorldSnapshot::ForceY][i] = force.y;
+		values[WorldSnapshot::ForceZ][i] = force.z;
+		values[WorldSnapshot::AngularVelocityX][i] = angular.x;
+		values[WorldSnapshot::AngularVelocityY][i] = angular.y;
+		values[WorldSnapshot::AngularVelocityZ][i] = angular.z;
+		values[WorldSnapshot::TorqueX][i] = torque.x;
+		values[WorldSnapshot::TorqueY][i] = torque.y;
+		values[WorldSnapshot::TorqueZ][i] = torque.z;
+		values[WorldSnapshot::InverseInertiaX][i] = inertia.x;
+		values[WorldSnapshot::InverseInertiaY][i] = inertia.y;
+		values[WorldSnapshot::InverseInertiaZ][i] = inertia.z;
 	}
 }
 
+/*
+Objects are matched up by their world ID, and put back in the order they
+were in when the snapshot was taken - if objects are being shuffled, the
+order they're updated in is part of the state too. Usually nothing has
+moved, so the lookup table is only built if it's needed.
+*/
+bool GameWorld::Restore(const WorldSnapshot& snapshot) {
+	int count = snapshot.GetNumObjects();
+	if (snapshot.IsEmpty() || count != (int)gameObjects.size()) {
+		return false;
+	}
+	const int32_t*	ids		= snapshot.GetObjectIDs();
+	const uint8_t*	flags	= snapshot.GetObjectFlags();
+	const int32_t*	scores	= snapshot.GetObjectScores();
+	const float*	values[WorldSnapshot::NUM_OBJECT_VALUES];
+	for (int v = 0; v < WorldSnapshot::NUM_OBJECT_VALUES; ++v) {
+		values[v] = snapshot.GetObjectValues(v);
+	}
+
+	bool inOrder = true;
+	for (int i = 0; i < count && inOrder; ++i) {
+		inOrder = gameObjects[i]->GetWorldID() == ids[i];
+	}
+	if (!inOrder) {
+		std::vector<GameObject*> ordered(count);
+		for (int i = 0; i < count; ++i) {
+			ordered[i] = GetObjectByID(ids[i]);
+			if (!ordered[i]) {
+				return false;
+			}
+		}
+		gameObjects.swap(ordered);
+		UpdateDenseIndices();
+	}
+
+	for (int i = 0; i < count; ++i) {
+		GameObject* o = gameObjects[i];
+
+		(flags[i] & WorldSnapshot::FlagActive) ? o->Activate() : o->Deactivate();
+		o->SetCollisionsEnabled((flags[i] & WorldSnapshot::FlagCollisions) != 0);
+		o->SetGrounded((flags[i] & WorldSnapshot::FlagGrounded) != 0);
+		o->SetScore(scores[i]);
+
+		o->GetTransform().Set(
+			Vector3(values[WorldSnapshot::PositionX][i], values[WorldSnapshot::PositionY][i], values[WorldSnapshot::PositionZ][i]),
+			Quaternion(values[WorldSnapshot::OrientationX][i], values[WorldSnapshot::OrientationY][i], values[WorldSnapshot::OrientationZ][i], values[WorldSnapshot::OrientationW][i]),
+			Vector3(values[WorldSnapshot::ScaleX][i], values[WorldSnapshot::ScaleY][i], values[WorldSnapshot::ScaleZ][i]));
+
+		PhysicsObject* phys = o->GetPhysicsObject();
+		if (!phys || !(flags[i] & WorldSnapshot::FlagPhysics)) {
+			continue;
+		}
+		phys->SetInverseMass(values[WorldSnapshot::InverseMass][i]);
+		phys->SetElasticity(values[WorldSnapshot::Elasticity][i]);
+		phys->SetFriction(values[WorldSnapshot::Friction][i]);
+		phys->SetLinearVelocity(Vector3(values[WorldSnapshot::LinearVelocityX][i], values[WorldSnapshot::LinearVelocityY][i], values[WorldSnapshot::LinearVelocityZ][i]));
+		phys->SetForce(Vector3(values[WorldSnapshot::ForceX][i], values[WorldSnapshot::ForceY][i], values[WorldSnapshot::ForceZ][i]));
+		phys->SetAngularVelocity(Vector3(values[WorldSnapshot::AngularVelocityX][i], values[WorldSnapshot::AngularVelocityY][i], values[WorldSnapshot::AngularVelocityZ][i]));
+		phys->SetTorque(Vector3(values[WorldSnapshot::TorqueX][i], values[WorldSnapshot::TorqueY][i], values[WorldSnapshot::TorqueZ][i]));
+		phys->SetLocalInverseInertia(Vector3(values[WorldSnapshot::InverseInertiaX][i], values[WorldSnapshot::InverseInertiaY][i], values[WorldSnapshot::InverseInertiaZ][i]));
+	}
+	randomState = snapshot.GetHeader().randomState;
+	return true;
+}
+
 bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject) const {
 	//The simplest raycast just goes through each object and sees if there's a collision
 	RayCollision collision;
@@ -109,12 +422,16 @@ Constraint Tutorial Stuff
 
 void GameWorld::AddConstraint(Constraint* c) {
 	constraints.emplace_back(c);
+	addedConstraints.emplace_back(c);
+	constraintVersion++;
 }
 
 void GameWorld::RemoveConstraint(Constraint* c, bool andDelete) {
 	constraints.erase(std::remove(constraints.begin(), constraints.end(), c), constraints.end());
+	addedConstraints.erase(std::remove(addedConstraints.begin(), addedConstraints.end(), c), addedConstraints.end());
+	constraintVersion++;
 	if (andDelete) {
-		delete c;
+		DeleteConstraint(c);
 	}
 }
 
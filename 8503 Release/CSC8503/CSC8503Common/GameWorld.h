@@ -1,18 +1,32 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "GameObjectHandle.h"
+#include "EntityRegistry.h"
+#include "LevelArena.h"
+#include "Prefab.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
 	namespace CSC8503 {
 		class GameObject;
 		class Constraint;
+		class WorldSnapshot;
 
 		typedef std::function<void(GameObject*)> GameObjectFunc;
 		typedef std::vector<GameObject*>::const_iterator GameObjectIterator;
 
+		/*
+		Objects are kept in a slot map - gameObjects is a tightly packed list
+		that's quick to loop over, and each object's world ID is the index of
+		a slot that says where in that list it is. Adding and removing are
+		both O(1): removing swaps the last object into the gap, and the
+		slot goes on a free list to be reused, with its generation bumped so
+		old handles to it no longer work.
+		*/
 		class GameWorld	{
 		public:
 			GameWorld();
@@ -21,9 +35,84 @@ namespace NCL {
 			void Clear();
 			void ClearAndErase();
 
-			void AddGameObject(GameObject* o);
+			/*
+			Makes an object (or volume, physics object, constraint, etc) in
+			the world's arena, rather than with new. They all disappear in one
+			go when ClearAndErase is called, so there's nothing to delete one
+			by one at the end of a level - they must not be deleted by hand.
+			*/
+			template <typename T, typename... Args>
+			T* Create(Args&&... args) {
+				T* t = arena.New<T>(std::forward<Args>(args)...);
+				AdoptArenaObject(t);
+				return t;
+			}
+
+			const LevelArena& GetArena() const {
+				return arena;
+			}
+
+			GameObjectHandle AddGameObject(GameObject* o);
+
+			/*
+			Makes count copies of a prefab, one at each position, in one go.
+			The objects are made side by side in the arena (so the result can
+			be indexed like an array), and their components are copied
+			straight out of the prefab into the registry, rather than each
+			one being built up on its own and then moved in. Any extra
+			arguments are passed to every object's constructor, after its name.
+			*/
+			template <typename T = GameObject, typename... Args>
+			T* SpawnPrefab(const Prefab& prefab, const Vector3* positions, int count, const Args&... args) {
+				if (count <= 0) {
+					return nullptr;
+				}
+				T* objects = (T*)arena.Allocate(sizeof(T) * count, alignof(T));
+				spawnedObjects.clear();
+				for (int i = 0; i < count; ++i) {
+					T* o = new (&objects[i]) T(prefab.GetName(), args...);
+					o->SetArena(&arena);
+					o->SetBoundingVolume(prefab.CloneVolume(arena));
+					spawnedObjects.emplace_back(o);
+				}
+				AddPrefabInstances(prefab, positions);
+				return objects;
+			}
 			void RemoveGameObject(GameObject* o, bool andDelete = false);
 
+			/*
+			Objects can't be deleted while something might be looping over
+			them (like in the middle of a collision callback), so this just
+			queues them up - they're actually removed and deleted when
+			FlushRemovals is called, at the end of the frame.
+			*/
+			void DestroyGameObject(GameObjectHandle h);
+			void FlushRemovals();
+
+			//nullptr if the object has been removed
+			GameObject*			GetGameObject(GameObjectHandle h) const;
+			GameObjectHandle	GetHandle(const GameObject* o) const;
+
+			bool IsValid(GameObjectHandle h) const {
+				return h.index < slots.size() && slots[h.index].generation == h.generation && slots[h.index].denseIndex >= 0;
+			}
+
+			//Changes whenever objects are removed, so anything holding on
+			//to objects knows when to check its handles
+			int GetRemovalVersion() const {
+				return removalVersion;
+			}
+
+			int GetNumObjects() const {
+				return (int)gameObjects.size();
+			}
+
+			//Where every object's data actually lives, for systems that
+			//want to walk through it one component type at a time
+			const EntityRegistry& GetEntities() const {
+				return entities;
+			}
+
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c, bool andDelete = false);
 
@@ -39,12 +128,28 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
+			//Two worlds with the same seed shuffle things in the same order
+			void SetRandomSeed(uint64_t seed) {
+				randomState = seed;
+			}
+
+			GameObject* GetObjectByID(int id) const;
+
 			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false) const;
 
 			virtual void UpdateWorld(float dt);
 
 			void OperateOnContents(GameObjectFunc f);
 
+			/*
+			Saves every object's transform, physics state, flags and score,
+			and puts them all back again. Restoring only works on the same
+			set of objects the snapshot was taken from - it returns false,
+			and leaves the world alone, if any are missing.
+			*/
+			void Snapshot(WorldSnapshot& snapshot) const;
+			bool Restore(const WorldSnapshot& snapshot);
+
 			void GetObjectIterators(
 				GameObjectIterator& first,
 				GameObjectIterator& last) const;
@@ -53,15 +158,59 @@ namespace NCL {
 				std::vector<Constraint*>::const_iterator& first,
 				std::vector<Constraint*>::const_iterator& last) const;
 
+			//Changes whenever constraints are added, removed or reordered
+			int GetConstraintVersion() const {
+				return constraintVersion;
+			}
+
 		protected:
+			struct ObjectSlot {
+				uint32_t	generation;
+				int			denseIndex;	//-1 if the slot is free
+			};
+
+			void UpdateDenseIndices();
+
+			GameObjectHandle AssignSlot(GameObject* o);
+			void AddPrefabInstances(const Prefab& prefab, const Vector3* positions);
+
+			void AdoptArenaObject(GameObject* o) {
+				o->SetArena(&arena);
+			}
+
+			void AdoptArenaObject(const void* o) {
+			}
+
+			void DeleteObject(GameObject* o);
+			void DeleteConstraint(Constraint* c);
+
 			std::vector<GameObject*> gameObjects;
+			std::vector<ObjectSlot>			slots;
+			std::vector<uint32_t>			freeSlots;
+			std::vector<GameObjectHandle>	pendingRemovals;
+			std::vector<GameObject*>		spawnedObjects;
+			int								removalVersion;
+			EntityRegistry					entities;
+			LevelArena						arena;
+
 			std::vector<Constraint*> constraints;
+			std::vector<Constraint*> addedConstraints;
 
 			Camera* mainCamera;
 
 			bool	shuffleConstraints;
 			bool	shuffleObjects;
-			int		worldIDCounter;
+			int		constraintVersion;
+
+			//Each world shuffles with its own generator, rather than rand(),
+			//so that worlds on different threads don't share any state. It's
+			//a simple one (splitmix64), so it gives the same numbers with any
+			//compiler, and its state fits in a snapshot
+			uint32_t NextRandom();
+			template <typename T>
+			void Shuffle(std::vector<T>& items);
+
+			uint64_t	randomState;
 		};
 	}
 }
@@ -0,0 +1,563 @@
+#include "HierarchicalGrid.h"
+#include "JobSystem.h"
+#include <cstdlib>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+//Gaps along a cluster's edge this long or longer get an entrance at each end, rather than one in the middle
+const int LONG_ENTRANCE = 6;
+
+//Up, down, left, right - the same as NavigationGrid's neighbours
+const int NEIGHBOUR_X[4] = { 0, 0, -1, 1 };
+const int NEIGHBOUR_Y[4] = { -1, 1, 0, 0 };
+
+HierarchicalGrid::HierarchicalGrid(const NavigationGrid& grid, int clusterSize, JobSystem* jobSystem) : grid(grid) {
+	this->clusterSize	= clusterSize < 2 ? 2 : clusterSize;
+	width				= grid.GetWidth();
+	height				= grid.GetHeight();
+	rowWords			= grid.GetRowWords();
+	clustersX			= (width + this->clusterSize - 1) / this->clusterSize;
+	clustersY			= (height + this->clusterSize - 1) / this->clusterSize;
+
+	walls.resize(rowWords * height);
+	for (int y = 0; y < height; ++y) {
+		std::copy(grid.GetWallRow(y), grid.GetWallRow(y) + rowWords, &walls[y * rowWords]);
+	}
+	if (clustersX == 0 || clustersY == 0) {
+		return;
+	}
+	verticalBorders.resize((clustersX - 1) * clustersY);
+	horizontalBorders.resize(clustersX * (clustersY - 1));
+	clusterNodes.resize(clustersX * clustersY);
+
+	for (int cy = 0; cy < clustersY; ++cy) {
+		for (int cx = 0; cx < clustersX; ++cx) {
+			BuildVerticalBorder(cx, cy);
+			BuildHorizontalBorder(cx, cy);
+		}
+	}
+	//Clusters only ever touch their own nodes' edges, so they can all be done at once
+	auto buildClusters = [&](int start, int end) {
+		for (int cluster = start; cluster < end; ++cluster) {
+			GatherClusterNodes(cluster % clustersX, cluster / clustersX);
+			BuildIntraEdges(cluster);
+		}
+	};
+	if (jobSystem) {
+		jobSystem->ParallelFor(clustersX * clustersY, 16, buildClusters);
+	}
+	else {
+		buildClusters(0, clustersX * clustersY);
+	}
+}
+
+HierarchicalGrid::~HierarchicalGrid() {
+}
+
+HierarchicalGrid::ClusterBounds HierarchicalGrid::GetClusterBounds(int cluster) const {
+	ClusterBounds b;
+	b.x			= (cluster % clustersX) * clusterSize;
+	b.y			= (cluster / clustersX) * clusterSize;
+	b.width		= width - b.x < clusterSize ? width - b.x : clusterSize;
+	b.height	= height - b.y < clusterSize ? height - b.y : clusterSize;
+	return b;
+}
+
+int HierarchicalGrid::NewNode(int x, int y) {
+	int node;
+	if (!freeNodes.empty()) {
+		node = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		node = (int)nodes.size();
+		nodes.emplace_back();
+	}
+	AbstractNode& n = nodes[node];
+	n.cell		= (y * width) + x;
+	n.cluster	= GetCluster(n.cell);
+	n.partner	= -1;
+	n.edges.clear();
+	return node;
+}
+
+//Freed nodes have no edges, so searches can't ever get to them
+void HierarchicalGrid::FreeNode(int node) {
+	nodes[node].cluster = -1;
+	nodes[node].partner = -1;
+	nodes[node].edges.clear();
+	freeNodes.emplace_back(node);
+}
+
+/*
+Walks along one side of the edge between two clusters, looking for runs
+of cells that are open on both sides, and puts a pair of nodes (one either
+side, joined to each other) in for each entrance.
+*/
+void HierarchicalGrid::BuildBorder(std::vector<int>& border, int x, int y, int alongX, int alongY, int acrossX, int acrossY, int length) {
+	for (int node : border) {
+		FreeNode(node);
+	}
+	border.clear();
+
+	auto addEntrance = [&](int i) {
+		int ax = x + (i * alongX);
+		int ay = y + (i * alongY);
+		int a = NewNode(ax, ay);
+		int b = NewNode(ax + acrossX, ay + acrossY);
+		nodes[a].partner = b;
+		nodes[b].partner = a;
+		border.emplace_back(a);
+		border.emplace_back(b);
+	};
+
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i) {
+		int cx = x + (i * alongX);
+		int cy = y + (i * alongY);
+		bool open = i < length && !IsWall(cx, cy) && !IsWall(cx + acrossX, cy + acrossY);
+		if (open && runStart < 0) {
+			runStart = i;
+		}
+		else if (!open && runStart >= 0) {
+			if (i - runStart < LONG_ENTRANCE) {
+				addEntrance((runStart + i - 1) / 2);
+			}
+			else {
+				addEntrance(runStart);
+				addEntrance(i - 1);
+			}
+			runStart = -1;
+		}
+	}
+}
+
+//The edge between a cluster and the one to its right
+void HierarchicalGrid::BuildVerticalBorder(int clusterX, int clusterY) {
+	if (clusterX + 1 >= clustersX) {
+		return;
+	}
+	ClusterBounds b = GetClusterBounds((clusterY * clustersX) + clusterX);
+	BuildBorder(verticalBorders[(clusterY * (clustersX - 1)) + clusterX], b.x + b.width - 1, b.y, 0, 1, 1, 0, b.height);
+}
+
+//The edge between a cluster and the one below it
+void HierarchicalGrid::BuildHorizontalBorder(int clusterX, int clusterY) {
+	if (clusterY + 1 >= clustersY) {
+		return;
+	}
+	ClusterBounds b = GetClusterBounds((clusterY * clustersX) + clusterX);
+	BuildBorder(horizontalBorders[(clusterY * clustersX) + clusterX], b.x, b.y + b.height - 1, 1, 0, 0, 1, b.width);
+}
+
+void HierarchicalGrid::GatherClusterNodes(int clusterX, int clusterY) {
+	int cluster = (clusterY * clustersX) + clusterX;
+	std::vector<int>& into = clusterNodes[cluster];
+	into.clear();
+
+	auto gather = [&](const std::vector<int>& border) {
+		for (int node : border) {
+			if (nodes[node].cluster == cluster) {
+				into.emplace_back(node);
+			}
+		}
+	};
+	if (clusterX > 0) {
+		gather(verticalBorders[(clusterY * (clustersX - 1)) + clusterX - 1]);
+	}
+	if (clusterX + 1 < clustersX) {
+		gather(verticalBorders[(clusterY * (clustersX - 1)) + clusterX]);
+	}
+	if (clusterY > 0) {
+		gather(horizontalBorders[((clusterY - 1) * clustersX) + clusterX]);
+	}
+	if (clusterY + 1 < clustersY) {
+		gather(horizontalBorders[(clusterY * clustersX) + clusterX]);
+	}
+}
+
+//How far each of a cluster's entrances is from each other, without leaving the cluster
+void HierarchicalGrid::BuildIntraEdges(int cluster) {
+	const std::vector<int>& inCluster = clusterNodes[cluster];
+	ClusterMap map;
+	BuildClusterMap(cluster, map);
+	std::vector<int> distances;
+	std::vector<uint8_t> stopAt(map.open.size(), 0);
+
+	for (int node : inCluster) {
+		nodes[node].edges.clear();
+		stopAt[GetLocalIndex(map, nodes[node].cell)]++;
+	}
+	/*
+	Distances are the same both ways, so each pair only needs searching
+	once - and each search can stop once it's found every entrance that
+	hasn't had its own search yet.
+	*/
+	for (size_t i = 0; i < inCluster.size(); ++i) {
+		int node = inCluster[i];
+		stopAt[GetLocalIndex(map, nodes[node].cell)]--;
+		ClusterSearch(map, nodes[node].cell, distances, nullptr, &stopAt, (int)(inCluster.size() - i - 1));
+		for (size_t j = i + 1; j < inCluster.size(); ++j) {
+			int other	= inCluster[j];
+			int d		= distances[GetLocalIndex(map, nodes[other].cell)];
+			if (d >= 0) {
+				nodes[node].edges.push_back({ other, (float)d });
+				nodes[other].edges.push_back({ node, (float)d });
+			}
+		}
+	}
+}
+
+void HierarchicalGrid::BuildClusterMap(int cluster, ClusterMap& map) const {
+	ClusterBounds& b = map.bounds;
+	b			= GetClusterBounds(cluster);
+	map.stride	= b.width + 2;
+	map.open.assign(map.stride * (b.height + 2), 0);
+	for (int y = 0; y < b.height; ++y) {
+		for (int x = 0; x < b.width; ++x) {
+			map.open[((y + 1) * map.stride) + x + 1] = !IsWall(b.x + x, b.y + y);
+		}
+	}
+}
+
+/*
+Every move costs the same, so within a cluster a breadth first search is
+all that's needed - distances are in cells, indexed the same way as the
+cluster map. A cell's distance is right as soon as it's first reached, so
+if stopAt says how many of the cells being looked for are in each cell,
+the search can stop as soon as it's reached numStops of them. Returns how
+many cells it expanded.
+*/
+int HierarchicalGrid::ClusterSearch(const ClusterMap& map, int fromCell, std::vector<int>& distances, std::vector<int>* parents, const std::vector<uint8_t>* stopAt, int numStops) const {
+	int numCells = (int)map.open.size();
+	distances.assign(numCells, -1);
+	if (parents) {
+		parents->assign(numCells, -1);
+	}
+	const int offsets[4] = { -map.stride, map.stride, -1, 1 }; //up, down, left, right
+
+	std::vector<int> frontier(numCells);
+	int frontierSize = 0;
+
+	int start = GetLocalIndex(map, fromCell);
+	distances[start] = 0;
+	frontier[frontierSize++] = start;
+	if (stopAt) {
+		numStops -= (*stopAt)[start];
+	}
+	const uint8_t* open = map.open.data();
+	int* dist = distances.data();
+
+	int next = 0;
+	for (; next < frontierSize; ++next) {
+		if (stopAt && numStops <= 0) {
+			break;
+		}
+		int local = frontier[next];
+		for (int i = 0; i < 4; ++i) {
+			int neighbour = local + offsets[i];
+			if (!open[neighbour] || dist[neighbour] >= 0) {
+				continue;
+			}
+			dist[neighbour] = dist[local] + 1;
+			if (parents) {
+				(*parents)[neighbour] = local;
+			}
+			frontier[frontierSize++] = neighbour;
+			if (stopAt) {
+				numStops -= (*stopAt)[neighbour];
+			}
+		}
+	}
+	return next;
+}
+
+/*
+The start and goal are joined on to the entrances of the clusters they're
+in for just this search - as two extra nodes on the end of the graph, so
+that nothing shared has to change. If they're both in the same cluster,
+there might be a way straight there, too.
+*/
+bool HierarchicalGrid::FindAbstractPath(const Vector3& from, const Vector3& to, HierarchicalPath& outPath) const {
+	outPath.cells.clear();
+	outPath.next			= 0;
+	outPath.nodesExpanded	= 0;
+
+	int fromX, fromY, toX, toY;
+	if (!grid.GetCell(from, fromX, fromY) || !grid.GetCell(to, toX, toY)) {
+		return false; //outside of map region!
+	}
+	if (IsWall(toX, toY)) {
+		return false;
+	}
+	int startCell		= (fromY * width) + fromX;
+	int goalCell		= (toY * width) + toX;
+	int startCluster	= GetCluster(startCell);
+	int goalCluster		= GetCluster(goalCell);
+
+	std::vector<int> distances;
+	std::vector<Link> startLinks;
+	std::vector<Link> goalLinks;
+
+	ClusterMap map;
+	BuildClusterMap(startCluster, map);
+	int expanded = ClusterSearch(map, startCell, distances, nullptr);
+	for (int node : clusterNodes[startCluster]) {
+		int d = distances[GetLocalIndex(map, nodes[node].cell)];
+		if (d >= 0) {
+			startLinks.push_back({ node, (float)d });
+		}
+	}
+	int direct = startCluster == goalCluster ? distances[GetLocalIndex(map, goalCell)] : -1;
+
+	if (goalCluster != startCluster) {
+		BuildClusterMap(goalCluster, map);
+	}
+	expanded += ClusterSearch(map, goalCell, distances, nullptr);
+	for (int node : clusterNodes[goalCluster]) {
+		int d = distances[GetLocalIndex(map, nodes[node].cell)];
+		if (d >= 0) {
+			goalLinks.push_back({ node, (float)d });
+		}
+	}
+
+	int numNodes	= (int)nodes.size();
+	int startNode	= numNodes;
+	int goalNode	= numNodes + 1;
+
+	auto getCell = [&](int node) {
+		return node == startNode ? startCell : (node == goalNode ? goalCell : nodes[node].cell);
+	};
+	auto heuristic = [&](int node) {
+		int cell = getCell(node);
+		return (float)(std::abs((cell % width) - toX) + std::abs((cell / width) - toY));
+	};
+
+	GridSearchState& s = *grid.AcquireSearchState();
+	s.Reset(numNodes + 2);
+
+	auto relax = [&](int current, int neighbour, float cost) {
+		if (s.IsClosed(neighbour)) {
+			return;
+		}
+		float g		= s.g[current] + cost;
+		bool inOpen = s.IsOpen(neighbour);
+		if (inOpen && g >= s.g[neighbour]) {
+			return;
+		}
+		s.g[neighbour]		= g;
+		s.parent[neighbour] = current;
+		float f = g + heuristic(neighbour);
+		if (inOpen) {
+			s.openList.DecreaseKey(neighbour, f);
+		}
+		else {
+			s.visited[neighbour] = s.stamp;
+			s.openList.Push(neighbour, f);
+		}
+	};
+
+	s.g[startNode]			= 0;
+	s.parent[startNode]		= -1;
+	s.visited[startNode]	= s.stamp;
+	s.openList.Push(startNode, heuristic(startNode));
+
+	bool found = false;
+	while (!s.openList.IsEmpty()) {
+		int current = s.openList.Pop();
+		s.visited[current] = s.stamp + 1;
+		expanded++;
+
+		if (current == goalNode) {
+			for (int node = goalNode; node != -1; node = s.parent[node]) {
+				outPath.cells.emplace_back(getCell(node));
+			}
+			std::reverse(outPath.cells.begin(), outPath.cells.end());
+			found = true;
+			break;
+		}
+		if (current == startNode) {
+			for (const Link& l : startLinks) {
+				relax(current, l.node, l.cost);
+			}
+			if (direct >= 0) {
+				relax(current, goalNode, (float)direct);
+			}
+			continue;
+		}
+		const AbstractNode& n = nodes[current];
+		for (const AbstractEdge& e : n.edges) {
+			relax(current, e.node, e.cost);
+		}
+		if (n.partner >= 0) {
+			relax(current, n.partner, 1);
+		}
+		if (n.cluster == goalCluster) {
+			for (const Link& l : goalLinks) {
+				if (l.node == current) {
+					relax(current, goalNode, l.cost);
+				}
+			}
+		}
+	}
+	grid.ReleaseSearchState(&s);
+	outPath.nodesExpanded = expanded;
+
+	/*
+	An agent that's ended up slightly inside a wall can still step out of
+	it - but there's no entrance there if that means stepping straight
+	over into the next cluster, so try again from the other side.
+	*/
+	if (!found && IsWall(fromX, fromY)) {
+		for (int i = 0; i < 4 && !found; ++i) {
+			int nx = fromX + NEIGHBOUR_X[i];
+			int ny = fromY + NEIGHBOUR_Y[i];
+			if (IsWall(nx, ny) || GetCluster((ny * width) + nx) == startCluster) {
+				continue;
+			}
+			found = FindAbstractPath(grid.GetCellPosition(nx, ny), to, outPath);
+			expanded += outPath.nodesExpanded;
+			outPath.nodesExpanded = expanded;
+			if (found) {
+				outPath.cells.insert(outPath.cells.begin(), startCell);
+			}
+		}
+	}
+	return found;
+}
+
+bool HierarchicalGrid::RefineNextSegment(HierarchicalPath& path, NavigationPath& outSegment) const {
+	if (path.IsFinished()) {
+		return false;
+	}
+	int from	= path.cells[path.next];
+	int to		= path.cells[path.next + 1];
+	path.next++;
+
+	if (from == to) {
+		return true; //two entrances on the same cell, in a cluster's corner
+	}
+	int cluster = GetCluster(from);
+	if (cluster != GetCluster(to)) { //just stepping over into the next cluster
+		outSegment.PushWaypoint(grid.GetCellPosition(to % width, to / width));
+		return true;
+	}
+	ClusterMap map;
+	BuildClusterMap(cluster, map);
+	std::vector<int> distances;
+	std::vector<int> parents;
+	std::vector<uint8_t> stopAt(map.open.size(), 0);
+	stopAt[GetLocalIndex(map, to)] = 1;
+	path.nodesExpanded += ClusterSearch(map, from, distances, &parents, &stopAt, 1);
+
+	int local = GetLocalIndex(map, to);
+	if (distances[local] < 0) {
+		return false; //the walls have changed since the path was found
+	}
+	int start = GetLocalIndex(map, from);
+	for (; local != start; local = parents[local]) {
+		int cell = GetCellFromLocal(map, local);
+		outSegment.PushWaypoint(grid.GetCellPosition(cell % width, cell / width));
+	}
+	return true;
+}
+
+bool HierarchicalGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const {
+	int nodesExpanded;
+	return FindPath(from, to, outPath, nodesExpanded);
+}
+
+bool HierarchicalGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+	HierarchicalPath path;
+	bool found = FindAbstractPath(from, to, path);
+	nodesExpanded = path.nodesExpanded;
+	if (!found) {
+		return false;
+	}
+	int start = path.cells[0];
+	std::vector<Vector3> waypoints(1, grid.GetCellPosition(start % width, start / width));
+
+	while (!path.IsFinished()) {
+		NavigationPath segment;
+		bool refined = RefineNextSegment(path, segment);
+		nodesExpanded = path.nodesExpanded;
+		if (!refined) {
+			return false;
+		}
+		Vector3 waypoint;
+		while (segment.PopWaypoint(waypoint)) {
+			waypoints.emplace_back(waypoint);
+		}
+	}
+	for (auto i = waypoints.rbegin(); i != waypoints.rend(); ++i) {
+		outPath.PushWaypoint(*i);
+	}
+	return true;
+}
+
+/*
+Changing a cell only changes the entrances along the edges it's on, and
+the distances through the clusters either side of them.
+*/
+void HierarchicalGrid::SetWall(int x, int y, bool isWall) {
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return;
+	}
+	uint64_t bit = (uint64_t)1 << (x & 63);
+	uint64_t& word = walls[(y * rowWords) + (x >> 6)];
+	if (((word & bit) != 0) == isWall) {
+		return;
+	}
+	word = isWall ? word | bit : word & ~bit;
+
+	int cx = x / clusterSize;
+	int cy = y / clusterSize;
+	ClusterBounds b = GetClusterBounds((cy * clustersX) + cx);
+
+	int affectedX[5] = { cx };
+	int affectedY[5] = { cy };
+	int numAffected = 1;
+	auto affect = [&](int ax, int ay) {
+		affectedX[numAffected] = ax;
+		affectedY[numAffected] = ay;
+		numAffected++;
+	};
+	if (x == b.x && cx > 0) {
+		BuildVerticalBorder(cx - 1, cy);
+		affect(cx - 1, cy);
+	}
+	if (x == b.x + b.width - 1 && cx + 1 < clustersX) {
+		BuildVerticalBorder(cx, cy);
+		affect(cx + 1, cy);
+	}
+	if (y == b.y && cy > 0) {
+		BuildHorizontalBorder(cx, cy - 1);
+		affect(cx, cy - 1);
+	}
+	if (y == b.y + b.height - 1 && cy + 1 < clustersY) {
+		BuildHorizontalBorder(cx, cy);
+		affect(cx, cy + 1);
+	}
+	for (int i = 0; i < numAffected; ++i) {
+		GatherClusterNodes(affectedX[i], affectedY[i]);
+		BuildIntraEdges((affectedY[i] * clustersX) + affectedX[i]);
+	}
+}
+
+size_t HierarchicalGrid::GetMemoryUsage() const {
+	size_t total = sizeof(*this) + (walls.capacity() * sizeof(uint64_t));
+	total += nodes.capacity() * sizeof(AbstractNode);
+	for (const AbstractNode& n : nodes) {
+		total += n.edges.capacity() * sizeof(AbstractEdge);
+	}
+	total += freeNodes.capacity() * sizeof(int);
+	for (const std::vector<std::vector<int>>* lists : { &verticalBorders, &horizontalBorders, &clusterNodes }) {
+		total += lists->capacity() * sizeof(std::vector<int>);
+		for (const std::vector<int>& list : *lists) {
+			total += list.capacity() * sizeof(int);
+		}
+	}
+	return total;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		class JobSystem;
+
+		/*
+		A path across the hierarchy's clusters - just the cells where it
+		crosses from one cluster into the next, to be filled in a bit at a
+		time with RefineNextSegment, as the agent gets to them.
+		*/
+		class HierarchicalPath {
+		public:
+			HierarchicalPath() {}
+			~HierarchicalPath() {}
+
+			bool IsFinished() const {
+				return next + 1 >= (int)cells.size();
+			}
+
+			//How many nodes finding and refining the path has taken so far
+			int GetNodesExpanded() const {
+				return nodesExpanded;
+			}
+
+		protected:
+			friend class HierarchicalGrid;
+
+			std::vector<int>	cells;
+			int					next = 0;
+			int					nodesExpanded = 0;
+		};
+
+		/*
+		HPA* - the grid is cut up into square clusters, and wherever two
+		clusters have open cells next to each other along their edge, an
+		entrance is put in (one in the middle of a short gap, or one at each
+		end of a long one). How far apart each of a cluster's entrances are,
+		going through just that cluster, is worked out up front.
+
+		A search then only has to get from the start to its cluster's
+		entrances, across the graph of entrances, and into the goal's
+		cluster - so it costs about the same however big the map is. Paths
+		come out close to, but not always exactly, as short as A*'s.
+
+		The hierarchy keeps its own copy of the walls, so that they can be
+		changed with SetWall - only the cluster the cell is in gets worked
+		out again (along with its neighbour, if the cell is on the edge
+		between them). Searches can run on as many threads as you like, but
+		not while a wall is being changed.
+		*/
+		class HierarchicalGrid : public NavigationMap {
+		public:
+			//Working out each cluster's distances is spread over the job system's threads, if it's given one
+			HierarchicalGrid(const NavigationGrid& grid, int clusterSize = 32, JobSystem* jobSystem = nullptr);
+			~HierarchicalGrid();
+
+			//The whole path, a waypoint on every cell, like NavigationGrid's
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const override;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const override;
+
+			size_t GetMemoryUsage() const override;
+
+			bool FindAbstractPath(const Vector3& from, const Vector3& to, HierarchicalPath& outPath) const;
+
+			/*
+			Fills in the cells up to the next entrance on the path (not
+			including the one the agent's already at). False once the path's
+			finished - or if a wall has been put in the way since the path
+			was found, in which case it'll need finding again.
+			*/
+			bool RefineNextSegment(HierarchicalPath& path, NavigationPath& outSegment) const;
+
+			void SetWall(int x, int y, bool isWall);
+
+			bool IsWall(int x, int y) const {
+				if (x < 0 || y < 0 || x >= width || y >= height) {
+					return true;
+				}
+				return (walls[(y * rowWords) + (x >> 6)] >> (x & 63)) & 1;
+			}
+
+			int GetNumClusters() const {
+				return clustersX * clustersY;
+			}
+
+			int GetNumAbstractNodes() const {
+				return (int)nodes.size() - (int)freeNodes.size();
+			}
+
+		protected:
+			struct AbstractEdge {
+				int		node;
+				float	cost;
+			};
+
+			//An entrance cell, on one side of a cluster's edge
+			struct AbstractNode {
+				int							cell;
+				int							cluster;
+				int							partner;	//the cell across the edge from it
+				std::vector<AbstractEdge>	edges;		//to the rest of its cluster's entrances
+			};
+
+			struct Link {
+				int		node;
+				float	cost;
+			};
+
+			struct ClusterBounds {
+				int x;
+				int y;
+				int width;
+				int height;
+			};
+
+			//Which of a cluster's cells are open, with a border of wall around the outside
+			struct ClusterMap {
+				ClusterBounds			bounds;
+				int						stride;
+				std::vector<uint8_t>	open;
+			};
+
+			int NewNode(int x, int y);
+			void FreeNode(int node);
+
+			void BuildBorder(std::vector<int>& border, int x, int y, int alongX, int alongY, int acrossX, int acrossY, int length);
+			void BuildVerticalBorder(int clusterX, int clusterY);
+			void BuildHorizontalBorder(int clusterX, int clusterY);
+			void GatherClusterNodes(int clusterX, int clusterY);
+			void BuildIntraEdges(int cluster);
+
+			void BuildClusterMap(int cluster, ClusterMap& map) const;
+			int ClusterSearch(const ClusterMap& map, int fromCell, std::vector<int>& distances, std::vector<int>* parents, const std::vector<uint8_t>* stopAt = nullptr, int numStops = 0) const;
+
+			ClusterBounds GetClusterBounds(int cluster) const;
+
+			int GetCluster(int cell) const {
+				return (((cell / width) / clusterSize) * clustersX) + ((cell % width) / clusterSize);
+			}
+
+			int GetLocalIndex(const ClusterMap& map, int cell) const {
+				return (((cell / width) - map.bounds.y + 1) * map.stride) + ((cell % width) - map.bounds.x + 1);
+			}
+
+			int GetCellFromLocal(const ClusterMap& map, int local) const {
+				return ((map.bounds.y + (local / map.stride) - 1) * width) + map.bounds.x + (local % map.stride) - 1;
+			}
+
+			const NavigationGrid&	grid;
+			int						width;
+			int						height;
+			int						rowWords;
+			int						clusterSize;
+			int						clustersX;
+			int						clustersY;
+
+			std::vector<uint64_t>	walls;
+
+			std::vector<AbstractNode>		nodes;
+			std::vector<int>				freeNodes;
+			std::vector<std::vector<int>>	verticalBorders;	//between a cluster and the one to its right
+			std::vector<std::vector<int>>	horizontalBorders;	//between a cluster and the one below it
+			std::vector<std::vector<int>>	clusterNodes;
+		};
+	}
+}
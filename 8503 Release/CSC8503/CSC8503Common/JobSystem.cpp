@@ -0,0 +1,109 @@
+#include "JobSystem.h"
+#include <atomic>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+JobSystem::JobSystem(int numWorkers) {
+	shuttingDown = false;
+
+	if (numWorkers <= 0) {
+		numWorkers = (int)std::thread::hardware_concurrency() - 1;
+	}
+	for (int i = 0; i < numWorkers; ++i) {
+		workers.emplace_back(&JobSystem::WorkerThread, this);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		shuttingDown = true;
+	}
+	jobAdded.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void JobSystem::AddJob(const Job& job) {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.push_back(job);
+	}
+	jobAdded.notify_one();
+}
+
+void JobSystem::WorkerThread() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAdded.wait(lock, [&] { return shuttingDown || !jobs.empty(); });
+			if (jobs.empty()) {
+				return; //only get here once we're shutting down
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+bool JobSystem::RunPendingJob() {
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		if (jobs.empty()) {
+			return false;
+		}
+		job = std::move(jobs.front());
+		jobs.pop_front();
+	}
+	job();
+	return true;
+}
+
+/*
+The range is cut into one batch per thread (or fewer, if that would make
+the batches smaller than minBatchSize). The calling thread keeps the first
+batch for itself, and then pitches in with whatever else is in the queue
+until the counter says all of its batches have finished.
+*/
+void JobSystem::ParallelFor(int count, int minBatchSize, const RangeFunc& func) {
+	if (count <= 0) {
+		return;
+	}
+	if (minBatchSize < 1) {
+		minBatchSize = 1;
+	}
+	int numBatches = count / minBatchSize;
+	if (numBatches > GetNumThreads()) {
+		numBatches = GetNumThreads();
+	}
+	if (numBatches <= 1) {
+		func(0, count);
+		return;
+	}
+	int batchSize = (count + numBatches - 1) / numBatches;
+
+	std::atomic<int> batchesLeft(numBatches - 1);
+
+	for (int i = 1; i < numBatches; ++i) {
+		int start	= i * batchSize;
+		int end		= std::min(count, start + batchSize);
+		AddJob([&func, &batchesLeft, start, end]() {
+			func(start, end);
+			batchesLeft.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	func(0, std::min(count, batchSize));
+
+	while (batchesLeft.load(std::memory_order_acquire) > 0) {
+		if (!RunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A simple pool of worker threads, that can be handed jobs to run.
+
+		ParallelFor splits a range up into batches, and the calling thread
+		helps to work through the queue until all of its batches are done,
+		rather than just sleeping - so it's safe to call it from inside
+		another job, without the pool deadlocking.
+		*/
+		class JobSystem	{
+		public:
+			typedef std::function<void()>				Job;
+			typedef std::function<void(int, int)>		RangeFunc;
+
+			//0 threads will use one worker per hardware thread, minus
+			//one for the thread that is going to be calling ParallelFor
+			JobSystem(int numWorkers = 0);
+			~JobSystem();
+
+			void AddJob(const Job& job);
+
+			//Calls func(start, end) over [0, count), in batches of at least
+			//minBatchSize, and only returns once every batch has run
+			void ParallelFor(int count, int minBatchSize, const RangeFunc& func);
+
+			//Including the calling thread, so always at least 1
+			int GetNumThreads() const {
+				return (int)workers.size() + 1;
+			}
+
+		protected:
+			void WorkerThread();
+			bool RunPendingJob();
+
+			std::vector<std::thread>	workers;
+			std::deque<Job>				jobs;
+			std::mutex					jobMutex;
+			std::condition_variable		jobAdded;
+			bool						shuttingDown;
+		};
+	}
+}
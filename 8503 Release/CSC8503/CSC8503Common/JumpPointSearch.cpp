@@ -0,0 +1,351 @@
+#include "JumpPointSearch.h"
+#include <cmath>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float DIAGONAL_COST = 1.41421356f;
+
+//Neither of these should be given 0
+static int LowestBit(uint64_t v) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long i;
+	_BitScanForward64(&i, v);
+	return (int)i;
+#elif defined(_MSC_VER)
+	unsigned long i;
+	if (_BitScanForward(&i, (unsigned long)v)) {
+		return (int)i;
+	}
+	_BitScanForward(&i, (unsigned long)(v >> 32));
+	return (int)i + 32;
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+static int HighestBit(uint64_t v) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long i;
+	_BitScanReverse64(&i, v);
+	return (int)i;
+#elif defined(_MSC_VER)
+	unsigned long i;
+	if (_BitScanReverse(&i, (unsigned long)(v >> 32))) {
+		return (int)i + 32;
+	}
+	_BitScanReverse(&i, (unsigned long)v);
+	return (int)i;
+#else
+	return 63 - __builtin_clzll(v);
+#endif
+}
+
+static int Sign(int v) {
+	return (v > 0) - (v < 0);
+}
+
+JumpPointSearch::JumpPointSearch(const NavigationGrid& grid, GridConnectivity connectivity) : grid(grid) {
+	this->connectivity	= connectivity;
+	width				= grid.GetWidth();
+	height				= grid.GetHeight();
+	columnWords			= (height + 63) / 64;
+
+	columns.resize(width * columnWords, 0);
+	for (int x = 0; x < width; ++x) {
+		for (int y = 0; y < columnWords * 64; ++y) {
+			if (grid.IsWall(x, y)) {
+				columns[(x * columnWords) + (y >> 6)] |= (uint64_t)1 << (y & 63);
+			}
+		}
+	}
+	int longest = grid.GetRowWords() > columnWords ? grid.GetRowWords() : columnWords;
+	solidLine.resize(longest, ~(uint64_t)0);
+}
+
+JumpPointSearch::~JumpPointSearch() {
+}
+
+/*
+Moving along a line, a cell is a jump point if the cell beside it (on
+either side) is open, but the one just behind that was a wall - there's
+now a way round that we couldn't have got to any quicker. For a whole
+word of cells at once, that's the side line's walls shifted along by one,
+with the side line's open cells masked out of it.
+
+Returns where along the line the first jump point (or the goal) is, or -1
+if a wall (or the edge of the map) gets in the way first.
+*/
+int JumpPointSearch::ScanLine(const uint64_t* line, const uint64_t* before, const uint64_t* after, int numWords, int pos, int dir, int goal) const {
+	int startWord = pos >> 6;
+	if (dir > 0) {
+		for (int w = startWord; w < numWords; ++w) {
+			uint64_t behindB = (before[w] << 1) | (w > 0 ? before[w - 1] >> 63 : 1);
+			uint64_t behindA = (after[w] << 1) | (w > 0 ? after[w - 1] >> 63 : 1);
+			uint64_t stop = line[w] | (~before[w] & behindB) | (~after[w] & behindA);
+			if (goal >= 0 && (goal >> 6) == w) {
+				stop |= (uint64_t)1 << (goal & 63);
+			}
+			if (w == startWord) {
+				stop &= ~(uint64_t)0 << (pos & 63);
+			}
+			if (stop) {
+				int p = (w << 6) + LowestBit(stop);
+				return ((line[w] >> (p & 63)) & 1) ? -1 : p;
+			}
+		}
+	}
+	else {
+		const uint64_t topBit = (uint64_t)1 << 63;
+		for (int w = startWord; w >= 0; --w) {
+			uint64_t behindB = (before[w] >> 1) | (w + 1 < numWords ? before[w + 1] << 63 : topBit);
+			uint64_t behindA = (after[w] >> 1) | (w + 1 < numWords ? after[w + 1] << 63 : topBit);
+			uint64_t stop = line[w] | (~before[w] & behindB) | (~after[w] & behindA);
+			if (goal >= 0 && (goal >> 6) == w) {
+				stop |= (uint64_t)1 << (goal & 63);
+			}
+			if (w == startWord) {
+				stop &= ~(uint64_t)0 >> (63 - (pos & 63));
+			}
+			if (stop) {
+				int p = (w << 6) + HighestBit(stop);
+				return ((line[w] >> (p & 63)) & 1) ? -1 : p;
+			}
+		}
+	}
+	return -1;
+}
+
+/*
+Carries on from (x, y) in the direction (dx, dy) until it finds a jump
+point, and returns its cell index - or -1 if it hits a wall first.
+
+Straight lines are just a scan along a row or column. With four way
+movement, going up and down has to stop anywhere a scan to the left or
+right would find something, and moving diagonally has to do the same for
+both of the straight directions it's made up of.
+*/
+int JumpPointSearch::Jump(int x, int y, int dx, int dy, const Goal& goal) const {
+	if (!IsOpen(x, y)) {
+		return -1;
+	}
+	if (dy == 0) {
+		int p = ScanLine(GetRow(y), GetRow(y - 1), GetRow(y + 1), grid.GetRowWords(), x, dx, y == goal.y ? goal.x : -1);
+		return p < 0 ? -1 : (y * width) + p;
+	}
+	if (dx == 0 && connectivity == GridConnectivity::Eight) {
+		int p = ScanLine(GetColumn(x), GetColumn(x - 1), GetColumn(x + 1), columnWords, y, dy, x == goal.x ? goal.y : -1);
+		return p < 0 ? -1 : (p * width) + x;
+	}
+	if (dx == 0) {
+		for (;; y += dy) {
+			if (!IsOpen(x, y)) {
+				return -1;
+			}
+			if ((x == goal.x && y == goal.y) ||
+				(IsOpen(x - 1, y) && !IsOpen(x - 1, y - dy)) ||
+				(IsOpen(x + 1, y) && !IsOpen(x + 1, y - dy)) ||
+				Jump(x + 1, y, 1, 0, goal) >= 0 ||
+				Jump(x - 1, y, -1, 0, goal) >= 0) {
+				return (y * width) + x;
+			}
+		}
+	}
+	for (;; x += dx, y += dy) {
+		if (!IsOpen(x, y)) {
+			return -1;
+		}
+		if ((x == goal.x && y == goal.y) ||
+			Jump(x + dx, y, dx, 0, goal) >= 0 ||
+			Jump(x, y + dy, 0, dy, goal) >= 0) {
+			return (y * width) + x;
+		}
+		if (!IsOpen(x + dx, y) || !IsOpen(x, y + dy)) {
+			return -1; //can't squeeze past the corner
+		}
+	}
+}
+
+/*
+Which directions are worth jumping in from a cell, given the direction we
+got to it from. The start cell has no parent, so everything is tried.
+*/
+int JumpPointSearch::GetSuccessorDirections(int x, int y, int parent, int* dirX, int* dirY) const {
+	int count = 0;
+	auto add = [&](int dx, int dy) {
+		dirX[count] = dx;
+		dirY[count] = dy;
+		count++;
+	};
+	bool eight = connectivity == GridConnectivity::Eight;
+
+	if (parent < 0) {
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				if ((dx == 0 && dy == 0) || !IsOpen(x + dx, y + dy)) {
+					continue;
+				}
+				if (dx != 0 && dy != 0 && (!eight || !IsOpen(x + dx, y) || !IsOpen(x, y + dy))) {
+					continue;
+				}
+				add(dx, dy);
+			}
+		}
+		return count;
+	}
+	int dx = Sign(x - (parent % width));
+	int dy = Sign(y - (parent / width));
+
+	if (dx != 0 && dy != 0) {
+		bool vertical	= IsOpen(x, y + dy);
+		bool horizontal = IsOpen(x + dx, y);
+		if (vertical) {
+			add(0, dy);
+		}
+		if (horizontal) {
+			add(dx, 0);
+		}
+		if (vertical && horizontal) {
+			add(dx, dy);
+		}
+	}
+	else if (dx != 0) {
+		bool next	= IsOpen(x + dx, y);
+		bool up		= IsOpen(x, y - 1);
+		bool down	= IsOpen(x, y + 1);
+		if (next) {
+			add(dx, 0);
+			if (eight && up) {
+				add(dx, -1);
+			}
+			if (eight && down) {
+				add(dx, 1);
+			}
+		}
+		if (up) {
+			add(0, -1);
+		}
+		if (down) {
+			add(0, 1);
+		}
+	}
+	else {
+		bool next	= IsOpen(x, y + dy);
+		bool left	= IsOpen(x - 1, y);
+		bool right	= IsOpen(x + 1, y);
+		if (next) {
+			add(0, dy);
+			if (eight && left) {
+				add(-1, dy);
+			}
+			if (eight && right) {
+				add(1, dy);
+			}
+		}
+		if (left) {
+			add(-1, 0);
+		}
+		if (right) {
+			add(1, 0);
+		}
+	}
+	return count;
+}
+
+//Manhattan distance for four way movement, octile for eight
+float JumpPointSearch::Distance(int ax, int ay, int bx, int by) const {
+	int dx = std::abs(ax - bx);
+	int dy = std::abs(ay - by);
+	if (connectivity == GridConnectivity::Four) {
+		return (float)(dx + dy);
+	}
+	int diagonal = dx < dy ? dx : dy;
+	int straight = (dx > dy ? dx : dy) - diagonal;
+	return straight + (diagonal * DIAGONAL_COST);
+}
+
+bool JumpPointSearch::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const {
+	int nodesExpanded;
+	return FindPath(from, to, outPath, nodesExpanded);
+}
+
+bool JumpPointSearch::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+	nodesExpanded = 0;
+	int fromX, fromY;
+	Goal goal;
+	if (!grid.GetCell(from, fromX, fromY) || !grid.GetCell(to, goal.x, goal.y)) {
+		return false; //outside of map region!
+	}
+	GridSearchState& s = *grid.AcquireSearchState();
+	s.Reset(width * height);
+
+	int startCell	= (fromY * width) + fromX;
+	int endCell		= (goal.y * width) + goal.x;
+
+	s.g[startCell]			= 0;
+	s.parent[startCell]		= -1;
+	s.visited[startCell]	= s.stamp;
+	s.openList.Push(startCell, 0);
+
+	int dirX[8];
+	int dirY[8];
+
+	bool found = false;
+	while (!s.openList.IsEmpty()) {
+		int current = s.openList.Pop();
+		nodesExpanded++;
+		s.visited[current] = s.stamp + 1;
+
+		if (current == endCell) {
+			//Jump points are joined back up, so there's a waypoint on every cell
+			for (int cell = endCell; cell != startCell; cell = s.parent[cell]) {
+				int x	= cell % width;
+				int y	= cell / width;
+				int px	= s.parent[cell] % width;
+				int py	= s.parent[cell] / width;
+				int dx	= Sign(px - x);
+				int dy	= Sign(py - y);
+				for (; x != px || y != py; x += dx, y += dy) {
+					outPath.PushWaypoint(grid.GetCellPosition(x, y));
+				}
+			}
+			outPath.PushWaypoint(grid.GetCellPosition(fromX, fromY));
+			found = true;
+			break;
+		}
+		int x = current % width;
+		int y = current / width;
+		int numDirections = GetSuccessorDirections(x, y, s.parent[current], dirX, dirY);
+
+		for (int i = 0; i < numDirections; ++i) {
+			int jumpPoint = Jump(x + dirX[i], y + dirY[i], dirX[i], dirY[i], goal);
+			if (jumpPoint < 0 || s.IsClosed(jumpPoint)) {
+				continue;
+			}
+			int jx		= jumpPoint % width;
+			int jy		= jumpPoint / width;
+			float g		= s.g[current] + Distance(x, y, jx, jy);
+			bool inOpen = s.IsOpen(jumpPoint);
+			if (inOpen && g >= s.g[jumpPoint]) {
+				continue;
+			}
+			s.g[jumpPoint]		= g;
+			s.parent[jumpPoint] = current;
+
+			float f = g + Distance(jx, jy, goal.x, goal.y);
+			if (inOpen) {
+				s.openList.DecreaseKey(jumpPoint, f);
+			}
+			else {
+				s.visited[jumpPoint] = s.stamp;
+				s.openList.Push(jumpPoint, f);
+			}
+		}
+	}
+	grid.ReleaseSearchState(&s);
+	return found;
+}
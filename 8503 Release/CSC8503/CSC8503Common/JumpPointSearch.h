@@ -0,0 +1,74 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		enum class GridConnectivity {
+			Four,	//the same moves NavigationGrid's A* makes
+			Eight	//diagonals too, but never cutting a wall's corner
+		};
+
+		/*
+		Jump Point Search, over the same walls as a NavigationGrid. Every
+		move costs the same on our grids, so there are loads of equally good
+		routes, and A* ends up opening most of them. JPS skips along straight
+		lines instead, and only stops at cells where something interesting
+		happens (a wall starts or ends next to it, or it's the goal) - so only
+		a handful of cells ever go in the open list.
+
+		Scanning along a row is done a whole 64 bit word of cells at a time,
+		straight from the grid's wall bitset. There's also a copy of the map
+		turned on its side, so that columns can be scanned in the same way.
+
+		Paths come out the same length as A*'s, with a waypoint on every
+		cell, like NavigationGrid's. It's safe to search from many threads
+		at once - search state comes from the grid's pool.
+		*/
+		class JumpPointSearch : public NavigationMap {
+		public:
+			JumpPointSearch(const NavigationGrid& grid, GridConnectivity connectivity = GridConnectivity::Four);
+			~JumpPointSearch();
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const override;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const override;
+
+			size_t GetMemoryUsage() const override {
+				return sizeof(*this) + ((columns.capacity() + solidLine.capacity()) * sizeof(uint64_t));
+			}
+
+		protected:
+			struct Goal {
+				int x;
+				int y;
+			};
+
+			int		Jump(int x, int y, int dx, int dy, const Goal& goal) const;
+			int		ScanLine(const uint64_t* line, const uint64_t* before, const uint64_t* after, int numWords, int pos, int dir, int goal) const;
+			int		GetSuccessorDirections(int x, int y, int parent, int* dirX, int* dirY) const;
+			float	Distance(int ax, int ay, int bx, int by) const;
+
+			bool IsOpen(int x, int y) const {
+				return !grid.IsWall(x, y);
+			}
+
+			const uint64_t* GetRow(int y) const {
+				return (y < 0 || y >= height) ? solidLine.data() : grid.GetWallRow(y);
+			}
+
+			const uint64_t* GetColumn(int x) const {
+				return (x < 0 || x >= width) ? solidLine.data() : &columns[x * columnWords];
+			}
+
+			const NavigationGrid&	grid;
+			GridConnectivity		connectivity;
+			int						width;
+			int						height;
+			int						columnWords;
+
+			std::vector<uint64_t>	columns;	//the walls again, one column per line
+			std::vector<uint64_t>	solidLine;	//for looking off the edge of the map
+		};
+	}
+}
@@ -0,0 +1,73 @@
+#include "LevelArena.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+LevelArena::LevelArena(size_t blockSize) {
+	this->blockSize = blockSize;
+	currentBlock	= -1;
+	offset			= 0;
+	bytesUsed		= 0;
+}
+
+LevelArena::~LevelArena() {
+	for (Block& b : blocks) {
+		delete[] b.memory;
+	}
+}
+
+/*
+If the allocation doesn't fit in what's left of the current block, we move
+on to the next one (making a new one if we've run out). Anything bigger than
+a whole block just gets a block of its own.
+*/
+void* LevelArena::Allocate(size_t size, size_t alignment) {
+	while (true) {
+		if (currentBlock >= 0) {
+			Block& b		= blocks[currentBlock];
+			size_t address	= (size_t)(b.memory + offset);
+			size_t padding	= (alignment - (address % alignment)) % alignment;
+			if (offset + padding + size <= b.size) {
+				void* result = b.memory + offset + padding;
+				offset		+= padding + size;
+				bytesUsed	+= padding + size;
+				return result;
+			}
+		}
+		currentBlock++;
+		offset = 0;
+		if (currentBlock == (int)blocks.size()) {
+			size_t newSize = size + alignment > blockSize ? size + alignment : blockSize;
+			blocks.push_back({ new char[newSize], newSize });
+		}
+		else if (blocks[currentBlock].size < size + alignment) {
+			//An old block that's too small for this - swap in a bigger one
+			delete[] blocks[currentBlock].memory;
+			blocks[currentBlock] = { new char[size + alignment], size + alignment };
+		}
+	}
+}
+
+bool LevelArena::Owns(const void* p) const {
+	const char* c = (const char*)p;
+	for (const Block& b : blocks) {
+		if (c >= b.memory && c < b.memory + b.size) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void LevelArena::Reset() {
+	currentBlock	= blocks.empty() ? -1 : 0;
+	offset			= 0;
+	bytesUsed		= 0;
+}
+
+size_t LevelArena::GetBytesReserved() const {
+	size_t total = 0;
+	for (const Block& b : blocks) {
+		total += b.size;
+	}
+	return total;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A simple bump allocator, for everything that only lives as long as
+		a level does. Allocating just moves a pointer along the current
+		block, and Reset throws the whole lot away at once by moving it back
+		to the start - the blocks are kept, so the next level doesn't have
+		to ask the OS for anything.
+
+		Reset doesn't call any destructors, so whoever made the objects
+		has to do that first, if they need it (GameWorld does this for its
+		objects and constraints).
+		*/
+		class LevelArena {
+		public:
+			LevelArena(size_t blockSize = 256 * 1024);
+			~LevelArena();
+
+			void* Allocate(size_t size, size_t alignment);
+
+			template <typename T, typename... Args>
+			T* New(Args&&... args) {
+				return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			}
+
+			//Calls the destructor, but the memory is only given back by Reset
+			template <typename T>
+			void Delete(T* object) {
+				if (object) {
+					object->~T();
+				}
+			}
+
+			bool Owns(const void* p) const;
+
+			void Reset();
+
+			size_t GetBytesUsed() const {
+				return bytesUsed;
+			}
+
+			size_t GetBytesReserved() const;
+
+		protected:
+			struct Block {
+				char*	memory;
+				size_t	size;
+			};
+
+			std::vector<Block>	blocks;
+			size_t				blockSize;
+			int					currentBlock;
+			size_t				offset;
+			size_t				bytesUsed;
+		};
+	}
+}
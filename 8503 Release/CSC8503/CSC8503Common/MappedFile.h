@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A whole file mapped into memory, read only - nothing's actually read
+		in until it's touched, and the OS can share the pages between
+		everything that maps the same file. The data stays valid until the
+		MappedFile is closed or deleted.
+		*/
+		class MappedFile {
+		public:
+			MappedFile();
+			~MappedFile();
+
+			//A full path, not one relative to a data folder - false if it can't be mapped (or is empty)
+			bool Open(const std::string& path);
+			void Close();
+
+			bool IsOpen() const {
+				return data != nullptr;
+			}
+
+			const char* GetData() const {
+				return data;
+			}
+
+			size_t GetSize() const {
+				return size;
+			}
+
+		protected:
+			const char*	data;
+			size_t		size;
+#ifdef _WIN32
+			void*		fileHandle;
+			void*		mappingHandle;
+#endif
+		};
+	}
+}
@@ -0,0 +1,43 @@
+#include "NavigationAssets.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+std::mutex								NavigationAssets::assetLock;
+std::map<std::string, NavigationGrid*>	NavigationAssets::grids;
+std::map<std::string, NavigationMesh*>	NavigationAssets::meshes;
+
+//Loaded while the lock's held, so two threads asking for the same new file can't both load it
+const NavigationGrid* NavigationAssets::GetGrid(const std::string& filename) {
+	std::lock_guard<std::mutex> lock(assetLock);
+	auto i = grids.find(filename);
+	if (i != grids.end()) {
+		return i->second;
+	}
+	NavigationGrid* grid = new NavigationGrid(filename);
+	grids.insert(std::make_pair(filename, grid));
+	return grid;
+}
+
+const NavigationMesh* NavigationAssets::GetMesh(const std::string& filename) {
+	std::lock_guard<std::mutex> lock(assetLock);
+	auto i = meshes.find(filename);
+	if (i != meshes.end()) {
+		return i->second;
+	}
+	NavigationMesh* mesh = new NavigationMesh(filename);
+	meshes.insert(std::make_pair(filename, mesh));
+	return mesh;
+}
+
+void NavigationAssets::Clear() {
+	std::lock_guard<std::mutex> lock(assetLock);
+	for (auto& i : grids) {
+		delete i.second;
+	}
+	for (auto& i : meshes) {
+		delete i.second;
+	}
+	grids.clear();
+	meshes.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "NavigationGrid.h"
+#include "NavigationMesh.h"
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		One shared, read only copy of each navigation map, however many
+		agents (on however many threads) want it. The first time a file's
+		asked for, it's loaded - everything after that gets the same one.
+
+		Files are named relative to the data folder, like the grid and mesh
+		constructors, and can be text or binary. A file that can't be loaded
+		gives an empty map, the same as constructing one would.
+
+		Maps are kept until Clear, which should only be called once nothing
+		is using any of them any more.
+		*/
+		class NavigationAssets {
+		public:
+			static const NavigationGrid* GetGrid(const std::string& filename);
+			static const NavigationMesh* GetMesh(const std::string& filename);
+
+			static void Clear();
+
+		protected:
+			static std::mutex								assetLock;
+			static std::map<std::string, NavigationGrid*>	grids;
+			static std::map<std::string, NavigationMesh*>	meshes;
+		};
+	}
+}
@@ -1,176 +1,386 @@
 #include "NavigationGrid.h"
+#include "MappedFile.h"
 #include "../../Common/Assets.h"
 
 #include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <climits>
 
 using namespace NCL;
 using namespace CSC8503;
 
-const int LEFT_NODE		= 0;
-const int RIGHT_NODE	= 1;
-const int TOP_NODE		= 2;
-const int BOTTOM_NODE	= 3;
-
 const char WALL_NODE	= 'x';
 const char FLOOR_NODE	= '.';
 
+//What a binary grid file starts with - the wall bitset follows straight after, and is used from there
+struct GridFileHeader {
+	char		magic[4];
+	uint32_t	version;
+	int32_t		nodeSize;
+	int32_t		width;
+	int32_t		height;
+	int32_t		rowWords;
+};
+
+const char		GRID_FILE_MAGIC[4]	= { 'N', 'A', 'V', 'G' };
+const uint32_t	GRID_FILE_VERSION	= 1;
+
+//Up, down, left, right - the same order the neighbours were always tried in
+const int NEIGHBOUR_X[4] = { 0, 0, -1, 1 };
+const int NEIGHBOUR_Y[4] = { -1, 1, 0, 0 };
+
+void GridSearchState::Reset(int numCells) {
+	if ((int)visited.size() < numCells) {
+		g.resize(numCells);
+		parent.resize(numCells);
+		visited.resize(numCells, 0);
+	}
+	stamp += 2;
+	if (stamp == 0) { //wrapped around, so old stamps could look new again
+		std::fill(visited.begin(), visited.end(), 0);
+		stamp = 2;
+	}
+	openList.Reset(numCells);
+}
+
 NavigationGrid::NavigationGrid()	{
 	nodeSize	= 0;
 	gridWidth	= 0;
 	gridHeight	= 0;
-	allNodes	= nullptr;
+	rowWords	= 0;
+	wallBits	= nullptr;
+	mappedFile	= nullptr;
 }
 
 NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
+	if (LoadBinary(Assets::DATADIR + filename)) {
+		return;
+	}
 	std::ifstream infile(Assets::DATADIR + filename);
 
 	infile >> nodeSize;
 	infile >> gridWidth;
 	infile >> gridHeight;
 
-	allNodes = new GridNode[gridWidth * gridHeight];
+	rowWords = (gridWidth + 63) / 64;
+	walls.resize(rowWords * gridHeight, 0);
 
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];
 			char type = 0;
 			infile >> type;
-			n.type = type;
-			n.position = Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
+			if (type == WALL_NODE) {
+				walls[(y * rowWords) + (x >> 6)] |= (uint64_t)1 << (x & 63);
+			}
+		}
+		for (int x = gridWidth; x < rowWords * 64; ++x) {
+			walls[(y * rowWords) + (x >> 6)] |= (uint64_t)1 << (x & 63);
 		}
 	}
-	
-	//now to build the connectivity between the nodes
-	for (int y = 0; y < gridHeight; ++y) {
-		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];		
+	wallBits = walls.data();
+}
 
-			if (y > 0) { //get the above node
-				n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
-			}
-			if (y < gridHeight - 1) { //get the below node
-				n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
-			}
-			if (x > 0) { //get left node
-				n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
-			}
-			if (x < gridWidth - 1) { //get right node
-				n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
-			}
-			for (int i = 0; i < 4; ++i) {
-				if (n.connected[i]) {
-					if (n.connected[i]->type == '.') {
-						n.costs[i]		= 1;
-					}
-					if (n.connected[i]->type == 'x') {
-						n.connected[i] = nullptr; //actually a wall, disconnect!
-					}
-				}
-			}
-		}	
+/*
+False if it's not a binary grid at all, so it can be tried as text. One
+that is, but is cut short or doesn't add up, loads as an empty grid -
+better that than a half loaded one.
+*/
+bool NavigationGrid::LoadBinary(const std::string& path) {
+	MappedFile* file = new MappedFile();
+	if (!file->Open(path) || file->GetSize() < sizeof(GridFileHeader) ||
+		!std::equal(GRID_FILE_MAGIC, GRID_FILE_MAGIC + 4, file->GetData())) {
+		delete file;
+		return false;
+	}
+	const GridFileHeader* header = (const GridFileHeader*)file->GetData();
+	size_t wordCount = (size_t)header->rowWords * (size_t)header->height;
+	if (header->version != GRID_FILE_VERSION || header->nodeSize <= 0 || header->width < 0 || header->height < 0 || header->rowWords != (header->width + 63) / 64 ||
+		file->GetSize() < sizeof(GridFileHeader) + (wordCount * sizeof(uint64_t))) {
+		delete file;
+		return true;
 	}
+	nodeSize	= header->nodeSize;
+	gridWidth	= header->width;
+	gridHeight	= header->height;
+	rowWords	= header->rowWords;
+	wallBits	= (const uint64_t*)(file->GetData() + sizeof(GridFileHeader)); //the header keeps this 8 byte aligned
+	mappedFile	= file;
+	return true;
 }
 
-NavigationGrid::~NavigationGrid()	{
-	delete[] allNodes;
+bool NavigationGrid::WriteBinary(const std::string& filename) const {
+	std::ofstream outfile(Assets::DATADIR + filename, std::ios::binary);
+
+	GridFileHeader header;
+	std::copy(GRID_FILE_MAGIC, GRID_FILE_MAGIC + 4, header.magic);
+	header.version	= GRID_FILE_VERSION;
+	header.nodeSize = nodeSize;
+	header.width	= gridWidth;
+	header.height	= gridHeight;
+	header.rowWords = rowWords;
+
+	outfile.write((const char*)&header, sizeof(header));
+	outfile.write((const char*)wallBits, (size_t)rowWords * gridHeight * sizeof(uint64_t));
+	return outfile.good();
 }
 
-bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	//need to work out which node 'from' sits in, and 'to' sits in
-	int fromX = ((int)from.x / nodeSize);
-	int fromZ = ((int)from.z / nodeSize);
+NavigationGrid::~NavigationGrid()	{
+	for (GridSearchState* s : freeSearchStates) {
+		delete s;
+	}
+	delete mappedFile;
+}
 
-	int toX = ((int)to.x / nodeSize);
-	int toZ = ((int)to.z / nodeSize);
+//A mapped file's pages are only read in as they're touched, but they're still counted here
+size_t NavigationGrid::GetMemoryUsage() const {
+	return sizeof(*this) + (walls.capacity() * sizeof(uint64_t)) + (mappedFile ? mappedFile->GetSize() : 0);
+}
 
-	if (fromX < 0 || fromX > gridWidth - 1 ||
-		fromZ < 0 || fromZ > gridHeight - 1) {
-		return false; //outside of map region!
+bool NavigationGrid::GetCell(const Vector3& position, int& x, int& y) const {
+	if (nodeSize <= 0) {
+		return false; //an empty grid, from a file that couldn't be loaded
 	}
+	x = ((int)position.x / nodeSize);
+	y = ((int)position.z / nodeSize);
+	return x >= 0 && x < gridWidth && y >= 0 && y < gridHeight;
+}
 
-	if (toX < 0 || toX > gridWidth - 1 ||
-		toZ < 0 || toZ > gridHeight - 1) {
-		return false; //outside of map region!
+GridSearchState* NavigationGrid::AcquireSearchState() const {
+	{
+		std::lock_guard<std::mutex> lock(searchStateLock);
+		if (!freeSearchStates.empty()) {
+			GridSearchState* s = freeSearchStates.back();
+			freeSearchStates.pop_back();
+			return s;
+		}
 	}
+	return new GridSearchState();
+}
 
-	GridNode* startNode = &allNodes[(fromZ * gridWidth) + fromX];
-	GridNode* endNode	= &allNodes[(toZ * gridWidth) + toX];
+void NavigationGrid::ReleaseSearchState(GridSearchState* s) const {
+	std::lock_guard<std::mutex> lock(searchStateLock);
+	freeSearchStates.emplace_back(s);
+}
 
-	std::vector<GridNode*>  openList;
-	std::vector<GridNode*>  closedList;
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const {
+	int nodesExpanded;
+	return FindPath(from, to, outPath, nodesExpanded);
+}
 
-	openList.emplace_back(startNode);
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+	GridPathSearch search(*this);
+	nodesExpanded = 0;
+	if (!search.Start(from, to)) {
+		return false; //outside of map region!
+	}
+	SearchStatus status = search.Expand(INT_MAX);
+	nodesExpanded = search.GetNodesExpanded();
+	if (status != SearchStatus::Found) {
+		return false; //if the open list emptied out, there's no path!
+	}
+	search.GetPath(outPath);
+	return true;
+}
 
-	startNode->f = 0;
-	startNode->g = 0;
-	startNode->parent = nullptr;
+float NavigationGrid::Heuristic(int x, int y, int toX, int toY) const {
+	float dx = (float)((x - toX) * nodeSize);
+	float dy = (float)((y - toY) * nodeSize);
+	return std::sqrt((dx * dx) + (dy * dy));
+}
 
-	GridNode* currentBestNode = nullptr;
+/*
+Rather than stepping along the line a cell at a time, the cells it
+crosses in each row are worked out as one run, which is then checked
+against that row's wall bits a whole word at a time - so a long, shallow
+line costs little more than a short one. LOS_EPSILON makes sure a line
+going exactly through the corner of a cell counts as touching it.
+*/
+const double LOS_EPSILON = 1e-6;
 
-	while (!openList.empty()) {
-		currentBestNode = RemoveBestNode(openList);
+bool NavigationGrid::HasLineOfSight(int fromX, int fromY, int toX, int toY) const {
+	if (IsWall(fromX, fromY) || IsWall(toX, toY)) {
+		return false;
+	}
+	if (fromY > toY) {
+		std::swap(fromX, toX);
+		std::swap(fromY, toY);
+	}
+	int minX = std::min(fromX, toX);
+	int maxX = std::max(fromX, toX);
+	if (fromY == toY) {
+		return !RowHasWall(fromY, minX, maxX);
+	}
+	double slope = (double)(toX - fromX) / (double)(toY - fromY);
+	for (int y = fromY; y <= toY; ++y) {
+		//The part of the line inside this row, which starts and ends halfway through the end rows
+		double top		= (y == fromY) ? fromY + 0.5 : y;
+		double bottom	= (y == toY) ? toY + 0.5 : y + 1;
+		double x0 = fromX + 0.5 + ((top - (fromY + 0.5)) * slope);
+		double x1 = fromX + 0.5 + ((bottom - (fromY + 0.5)) * slope);
+		if (x0 > x1) {
+			std::swap(x0, x1);
+		}
+		int runStart	= std::max(minX, (int)std::floor(x0 - LOS_EPSILON));
+		int runEnd		= std::min(maxX, (int)std::floor(x1 + LOS_EPSILON));
+		if (RowHasWall(y, runStart, runEnd)) {
+			return false;
+		}
+	}
+	return true;
+}
 
-		if (currentBestNode == endNode) {			//we've found the path!
-			GridNode* node = endNode;
-			while (node != nullptr) {
-				outPath.PushWaypoint(node->position);
-				node = node->parent;
-			}
+bool NavigationGrid::RowHasWall(int y, int fromX, int toX) const {
+	const uint64_t* row = GetWallRow(y);
+	int firstWord	= fromX >> 6;
+	int lastWord	= toX >> 6;
+	for (int w = firstWord; w <= lastWord; ++w) {
+		uint64_t mask = ~(uint64_t)0;
+		if (w == firstWord) {
+			mask &= ~(uint64_t)0 << (fromX & 63);
+		}
+		if (w == lastWord) {
+			mask &= ~(uint64_t)0 >> (63 - (toX & 63));
+		}
+		if (row[w] & mask) {
 			return true;
 		}
-		else {
-			for (int i = 0; i < 4; ++i) {
-				GridNode* neighbour = currentBestNode->connected[i];
-				if (!neighbour) { //might not be connected...
-					continue;
-				}	
-				bool inClosed	= NodeInList(neighbour, closedList);
-				if (inClosed) {
-					continue; //already discarded this neighbour...
-				}
-
-				float h = Heuristic(neighbour, endNode);				
-				float g = currentBestNode->g + currentBestNode->costs[i];
-				float f = h + g;
-
-				bool inOpen		= NodeInList(neighbour, openList);
-
-				if (!inOpen) { //first time we've seen this neighbour
-					openList.emplace_back(neighbour);
-				}
-				if (!inOpen || f < neighbour->f) {//might be a better route to this neighbour
-					neighbour->parent = currentBestNode;
-					neighbour->f = f;
-					neighbour->g = g;
-				}
+	}
+	return false;
+}
+
+/*
+Working forwards from the start, each waypoint is only kept if the last
+one kept can't see the one after it - so the agent heads straight for
+each corner, rather than along every step of the staircase.
+*/
+void NavigationGrid::SmoothPath(NavigationPath& path) const {
+	std::vector<Vector3> points;
+	Vector3 waypoint;
+	while (path.PopWaypoint(waypoint)) {
+		points.emplace_back(waypoint);
+	}
+	//A path with a point off the grid (or an empty grid) can't be checked, so it's left as it is
+	std::vector<int> cellX(points.size());
+	std::vector<int> cellY(points.size());
+	bool onGrid = true;
+	for (size_t i = 0; i < points.size() && onGrid; ++i) {
+		onGrid = GetCell(points[i], cellX[i], cellY[i]);
+	}
+	std::vector<Vector3> kept;
+	if (points.size() < 3 || !onGrid) {
+		kept = points;
+	}
+	else {
+		int from = 0;
+		kept.emplace_back(points[0]);
+		for (int i = 1; i + 1 < (int)points.size(); ++i) {
+			if (!HasLineOfSight(cellX[from], cellY[from], cellX[i + 1], cellY[i + 1])) {
+				kept.emplace_back(points[i]);
+				from = i;
 			}
-			closedList.emplace_back(currentBestNode);
 		}
+		kept.emplace_back(points.back());
+	}
+	for (auto i = kept.rbegin(); i != kept.rend(); ++i) {
+		path.PushWaypoint(*i);
 	}
-	return false; //open list emptied out with no path!
 }
 
-bool NavigationGrid::NodeInList(GridNode* n, std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator i = std::find(list.begin(), list.end(), n);
-	return i == list.end() ? false : true;
+GridPathSearch::GridPathSearch(const NavigationGrid& grid) : grid(grid) {
+	state			= grid.AcquireSearchState();
+	status			= SearchStatus::NoPath;
+	startCell		= 0;
+	endCell			= 0;
+	toX				= 0;
+	toY				= 0;
+	nodesExpanded	= 0;
 }
 
-GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator bestI = list.begin();
+GridPathSearch::~GridPathSearch() {
+	grid.ReleaseSearchState(state);
+}
 
-	GridNode* bestNode = *list.begin();
+bool GridPathSearch::Start(const Vector3& from, const Vector3& to) {
+	//need to work out which node 'from' sits in, and 'to' sits in
+	int fromX, fromZ;
+	nodesExpanded = 0;
+	if (!grid.GetCell(from, fromX, fromZ) || !grid.GetCell(to, toX, toY)) {
+		status = SearchStatus::NoPath;
+		return false;
+	}
+	int width = grid.GetWidth();
+	GridSearchState& s = *state;
+	s.Reset(width * grid.GetHeight());
+
+	startCell	= (fromZ * width) + fromX;
+	endCell		= (toY * width) + toX;
+
+	s.g[startCell]			= 0;
+	s.parent[startCell]		= -1;
+	s.visited[startCell]	= s.stamp;
+	s.openList.Push(startCell, 0);
+
+	status = SearchStatus::Searching;
+	return true;
+}
 
-	for (auto i = list.begin(); i != list.end(); ++i) {
-		if ((*i)->f < bestNode->f) {
-			bestNode	= (*i);
-			bestI		= i;
+SearchStatus GridPathSearch::Expand(int maxNodes) {
+	GridSearchState& s = *state;
+	int width = grid.GetWidth();
+
+	for (int expanded = 0; status == SearchStatus::Searching && expanded < maxNodes; ++expanded) {
+		if (s.openList.IsEmpty()) {
+			status = SearchStatus::NoPath;
+			break;
 		}
-	}
-	list.erase(bestI);
+		int current = s.openList.Pop();
+		s.visited[current] = s.stamp + 1;
+		nodesExpanded++;
 
-	return bestNode;
+		if (current == endCell) { //we've found the path!
+			status = SearchStatus::Found;
+			break;
+		}
+		int x = current % width;
+		int y = current / width;
+		for (int i = 0; i < 4; ++i) {
+			int nx = x + NEIGHBOUR_X[i];
+			int ny = y + NEIGHBOUR_Y[i];
+			if (grid.IsWall(nx, ny)) { //might not be connected...
+				continue;
+			}
+			int neighbour = (ny * width) + nx;
+			if (s.IsClosed(neighbour)) {
+				continue; //already discarded this neighbour...
+			}
+			float g		= s.g[current] + 1;
+			bool inOpen	= s.IsOpen(neighbour);
+			if (inOpen && g >= s.g[neighbour]) {
+				continue; //already got a route here that's at least as good
+			}
+			s.g[neighbour]		= g;
+			s.parent[neighbour] = current;
+
+			float f = g + grid.Heuristic(nx, ny, toX, toY);
+			if (inOpen) {
+				s.openList.DecreaseKey(neighbour, f);
+			}
+			else { //first time we've seen this neighbour
+				s.visited[neighbour] = s.stamp;
+				s.openList.Push(neighbour, f);
+			}
+		}
+	}
+	return status;
 }
 
-float NavigationGrid::Heuristic(GridNode* hNode, GridNode* endNode) const {
-	return (hNode->position - endNode->position).Length();
-}
\ No newline at end of file
+void GridPathSearch::GetPath(NavigationPath& outPath) const {
+	if (status != SearchStatus::Found) {
+		return;
+	}
+	int width = grid.GetWidth();
+	for (int cell = endCell; cell != -1; cell = state->parent[cell]) {
+		outPath.PushWaypoint(grid.GetCellPosition(cell % width, cell / width));
+	}
+}
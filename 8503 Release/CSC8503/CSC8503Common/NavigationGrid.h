@@ -1,52 +1,187 @@
 #pragma once
 #include "NavigationMap.h"
+#include "NodeHeap.h"
 #include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
 namespace NCL {
 	namespace CSC8503 {
-		struct GridNode {
-			GridNode* parent;
+		class MappedFile;
 
-			GridNode* connected[4];
-			int		  costs[4];
+		/*
+		Everything one search needs to remember about each cell. It's kept
+		apart from the grid, and each search borrows one from the grid's
+		pool, so any number of searches can run on the same grid at once.
 
-			Vector3		position;
+		Cells are marked with the search's stamp when they're opened, and
+		stamp + 1 when they're closed - anything lower hasn't been seen by
+		this search at all, so nothing needs clearing between searches.
+		*/
+		struct GridSearchState {
+			std::vector<float>		g;
+			std::vector<int>		parent;
+			std::vector<uint32_t>	visited;
+			uint32_t				stamp = 0;
+			NodeHeap				openList;
 
-			float f;
-			float g;
+			void Reset(int numCells);
 
-			int type;
+			bool IsOpen(int cell) const {
+				return visited[cell] == stamp;
+			}
 
-			GridNode() {
-				for (int i = 0; i < 4; ++i) {
-					connected[i] = nullptr;
-					costs[i] = 0;
-				}
-				f = 0;
-				g = 0;
-				type = 0;
-				parent = nullptr;
+			bool IsClosed(int cell) const {
+				return visited[cell] == stamp + 1;
+			}
+
+			bool IsSeen(int cell) const {
+				return visited[cell] >= stamp;
 			}
-			~GridNode() {	}
 		};
 
+		/*
+		Once it's loaded, a grid never changes - it's just a bitset of which
+		cells are walls (one row of 64 bit words per row of the map, with
+		anything past the right hand edge counting as wall), and each cell's
+		neighbours are worked out from where it is. It can be shared between
+		as many agents, on as many threads, as you like.
+
+		Grids can be loaded from the usual text files, or from a binary file
+		saved out with WriteBinary - that's just a small header and then the
+		wall bitset as it is in memory. Binary files are mapped into memory
+		rather than read, and the grid uses the bitset straight out of the
+		mapping, so there's nothing to parse or copy at all. Which one a
+		file is is worked out from its first few bytes.
+
+		To have every agent share the one copy of a map, get it from
+		NavigationAssets, rather than making a new grid each time.
+		*/
 		class NavigationGrid : public NavigationMap	{
 		public:
 			NavigationGrid();
 			NavigationGrid(const std::string&filename);
 			~NavigationGrid();
 
-			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-				
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const override;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const override;
+
+			size_t GetMemoryUsage() const override;
+
+			//Relative to the data folder, like the file a grid is loaded from
+			bool WriteBinary(const std::string& filename) const;
+
+			int GetWidth() const {
+				return gridWidth;
+			}
+
+			int GetHeight() const {
+				return gridHeight;
+			}
+
+			int GetNodeSize() const {
+				return nodeSize;
+			}
+
+			int GetRowWords() const {
+				return rowWords;
+			}
+
+			const uint64_t* GetWallRow(int y) const {
+				return &wallBits[y * rowWords];
+			}
+
+			//Anywhere off the grid counts as a wall
+			bool IsWall(int x, int y) const {
+				if (x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) {
+					return true;
+				}
+				return (wallBits[(y * rowWords) + (x >> 6)] >> (x & 63)) & 1;
+			}
+
+			//Which cell a position is in - false if it's off the grid
+			bool	GetCell(const Vector3& position, int& x, int& y) const;
+			Vector3	GetCellPosition(int x, int y) const {
+				return Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
+			}
+
+			GridSearchState*	AcquireSearchState() const;
+			void				ReleaseSearchState(GridSearchState* s) const;
+
+			float Heuristic(int x, int y, int toX, int toY) const;
+
+			/*
+			Whether a straight line between the middles of two cells misses
+			every wall. Just touching the corner of a wall counts as hitting
+			it, so a line can never squeeze between two diagonal walls.
+			*/
+			bool HasLineOfSight(int fromX, int fromY, int toX, int toY) const;
+
+			//Takes out every waypoint that the ones either side of it can see past
+			void SmoothPath(NavigationPath& path) const;
+
 		protected:
-			bool		NodeInList(GridNode* n, std::vector<GridNode*>& list) const;
-			GridNode*	RemoveBestNode(std::vector<GridNode*>& list) const;
-			float		Heuristic(GridNode* hNode, GridNode* endNode) const;
+			bool RowHasWall(int y, int fromX, int toX) const;
+			bool LoadBinary(const std::string& path);
+
 			int nodeSize;
 			int gridWidth;
 			int gridHeight;
+			int rowWords;
 
-			GridNode* allNodes;
+			const uint64_t*			wallBits;	//either walls' data, or straight out of the mapped file
+			std::vector<uint64_t>	walls;		//only used by grids loaded from text
+			MappedFile*				mappedFile;
+
+			mutable std::mutex						searchStateLock;
+			mutable std::vector<GridSearchState*>	freeSearchStates;
+		};
+
+		enum class SearchStatus {
+			Searching,
+			Found,
+			NoPath
+		};
+
+		/*
+		The grid's A*, but it can be stopped after a set number of nodes,
+		and picked up again later from where it left off - so a long search
+		can be spread out over as many frames as it needs. FindPath is just
+		one of these, run until it's done.
+
+		It holds on to one of the grid's search states until it's deleted.
+		*/
+		class GridPathSearch {
+		public:
+			GridPathSearch(const NavigationGrid& grid);
+			~GridPathSearch();
+
+			//False if either end is off the grid
+			bool Start(const Vector3& from, const Vector3& to);
+
+			//Expands up to maxNodes more nodes
+			SearchStatus Expand(int maxNodes);
+
+			SearchStatus GetStatus() const {
+				return status;
+			}
+
+			int GetNodesExpanded() const {
+				return nodesExpanded;
+			}
+
+			//Only once the status is Found
+			void GetPath(NavigationPath& outPath) const;
+
+		protected:
+			const NavigationGrid&	grid;
+			GridSearchState*		state;
+			SearchStatus			status;
+			int						startCell;
+			int						endCell;
+			int						toX;
+			int						toY;
+			int						nodesExpanded;
 		};
 	}
 }
-
@@ -8,9 +8,20 @@ namespace NCL {
 		{
 		public:
 			NavigationMap() {}
-			~NavigationMap() {}
+			virtual ~NavigationMap() {}
 
-			virtual bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) = 0;
+			virtual bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const = 0;
+
+			//The same, but also says how many nodes the search expanded (for comparing maps) - -1 if it doesn't count them
+			virtual bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+				nodesExpanded = -1;
+				return FindPath(from, to, outPath);
+			}
+
+			//Roughly how many bytes the map's own data takes up, not counting anything it shares, or any searches' state
+			virtual size_t GetMemoryUsage() const {
+				return sizeof(*this);
+			}
 		};
 	}
 }
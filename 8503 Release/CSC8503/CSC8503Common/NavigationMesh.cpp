@@ -1,16 +1,77 @@
 #include "NavigationMesh.h"
+#include "MappedFile.h"
+#include "NodeHeap.h"
 #include "../../Common/Assets.h"
 #include <fstream>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 using namespace std;
 
+/*
+What a binary mesh file starts with. Straight after it come the vertices,
+the triangles, where each lookup grid cell's triangles start, and then
+the triangles in each cell - every one of them a whole number of floats
+or ints, so they all stay 4 byte aligned.
+*/
+struct MeshFileHeader {
+	char		magic[4];
+	uint32_t	version;
+	int32_t		numVerts;
+	int32_t		numTris;
+	float		gridMin[3];
+	float		gridCellSize;
+	int32_t		gridCellsX;
+	int32_t		gridCellsZ;
+	int32_t		numCellTris;
+};
+
+const char		MESH_FILE_MAGIC[4]	= { 'N', 'A', 'V', 'M' };
+const uint32_t	MESH_FILE_VERSION	= 1;
+
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "binary meshes store vertices as they are in memory");
+
+//How far outside a triangle's edges a point can be and still count as being in it
+const float TRIANGLE_EPSILON = 0.001f;
+
+//Twice the area of triangle abc, looking down from above - positive if c is to the right of a->b
+static float TriArea2(const Vector3& a, const Vector3& b, const Vector3& c) {
+	float ax = b.x - a.x;
+	float az = b.z - a.z;
+	float bx = c.x - a.x;
+	float bz = c.z - a.z;
+	return (bx * az) - (ax * bz);
+}
+
+static bool SamePoint(const Vector3& a, const Vector3& b) {
+	return (a - b).Length() < TRIANGLE_EPSILON;
+}
+
 NavigationMesh::NavigationMesh()
 {
+	gridCellSize	= 1.0f;
+	gridCellsX		= 0;
+	gridCellsZ		= 0;
+	tris			= nullptr;
+	verts			= nullptr;
+	cellStarts		= nullptr;
+	cellTris		= nullptr;
+	numTris			= 0;
+	numVerts		= 0;
+	numCellTris		= 0;
+	mappedFile		= nullptr;
 }
 
-NavigationMesh::NavigationMesh(const std::string&filename)
+NavigationMesh::NavigationMesh(const std::string&filename) : NavigationMesh()
 {
+	if (LoadBinary(Assets::DATADIR + filename)) {
+		return;
+	}
 	ifstream file(Assets::DATADIR + filename);
 
 	int numVertices = 0;
@@ -33,12 +94,433 @@ NavigationMesh::NavigationMesh(const std::string&filename)
 		file >> x;
 		allIndices.emplace_back(x);
 	}
+	BuildTriangles();
+	BuildTriangleGrid();
+	UseLoadedData();
 }
 
 NavigationMesh::~NavigationMesh()
 {
+	delete mappedFile;
+}
+
+void NavigationMesh::UseLoadedData() {
+	tris		= allTris.data();
+	verts		= allVerts.data();
+	cellStarts	= gridCellStarts.data();
+	cellTris	= gridCellTris.data();
+	numTris		= (int)allTris.size();
+	numVerts	= (int)allVerts.size();
+	numCellTris	= (int)gridCellTris.size();
+}
+
+/*
+False if it's not a binary mesh at all, so it can be tried as text. One
+that is, but doesn't add up, loads as an empty mesh.
+*/
+bool NavigationMesh::LoadBinary(const std::string& path) {
+	MappedFile* file = new MappedFile();
+	if (!file->Open(path) || file->GetSize() < sizeof(MeshFileHeader) ||
+		!std::equal(MESH_FILE_MAGIC, MESH_FILE_MAGIC + 4, file->GetData())) {
+		delete file;
+		return false;
+	}
+	const MeshFileHeader* header = (const MeshFileHeader*)file->GetData();
+	if (header->version != MESH_FILE_VERSION || header->numVerts < 0 || header->numTris < 0 ||
+		header->gridCellsX < 0 || header->gridCellsZ < 0 || header->numCellTris < 0) {
+		delete file;
+		return true;
+	}
+	size_t numCells		= header->numTris > 0 ? ((size_t)header->gridCellsX * header->gridCellsZ) + 1 : 0;
+	size_t vertsStart	= sizeof(MeshFileHeader);
+	size_t trisStart	= vertsStart + (header->numVerts * sizeof(Vector3));
+	size_t startsStart	= trisStart + (header->numTris * sizeof(NavTri));
+	size_t cellsStart	= startsStart + (numCells * sizeof(int));
+	size_t fileEnd		= cellsStart + (header->numCellTris * sizeof(int));
+	if (file->GetSize() < fileEnd) {
+		delete file;
+		return true;
+	}
+	const char* data = file->GetData();
+	verts		= (const Vector3*)(data + vertsStart);
+	tris		= (const NavTri*)(data + trisStart);
+	cellStarts	= (const int*)(data + startsStart);
+	cellTris	= (const int*)(data + cellsStart);
+	numVerts	= header->numVerts;
+	numTris		= header->numTris;
+	numCellTris	= header->numCellTris;
+	gridMin		= Vector3(header->gridMin[0], header->gridMin[1], header->gridMin[2]);
+	gridCellSize= header->gridCellSize;
+	gridCellsX	= header->gridCellsX;
+	gridCellsZ	= header->gridCellsZ;
+	mappedFile	= file;
+	return true;
+}
+
+bool NavigationMesh::WriteBinary(const std::string& filename) const {
+	ofstream outfile(Assets::DATADIR + filename, ios::binary);
+
+	MeshFileHeader header;
+	std::copy(MESH_FILE_MAGIC, MESH_FILE_MAGIC + 4, header.magic);
+	header.version		= MESH_FILE_VERSION;
+	header.numVerts		= numVerts;
+	header.numTris		= numTris;
+	header.gridMin[0]	= gridMin.x;
+	header.gridMin[1]	= gridMin.y;
+	header.gridMin[2]	= gridMin.z;
+	header.gridCellSize = gridCellSize;
+	header.gridCellsX	= gridCellsX;
+	header.gridCellsZ	= gridCellsZ;
+	header.numCellTris	= numCellTris;
+
+	int numCells = numTris > 0 ? (gridCellsX * gridCellsZ) + 1 : 0; //an empty mesh never builds its grid
+
+	outfile.write((const char*)&header, sizeof(header));
+	outfile.write((const char*)verts, numVerts * sizeof(Vector3));
+	outfile.write((const char*)tris, numTris * sizeof(NavTri));
+	outfile.write((const char*)cellStarts, numCells * sizeof(int));
+	outfile.write((const char*)cellTris, numCellTris * sizeof(int));
+	return outfile.good();
+}
+
+/*
+The same corner can be in the file more than once, so vertices are welded
+together by position first. Then every edge goes in a hash map, keyed on
+the two vertices it joins - the second triangle to have that edge is the
+first one's neighbour.
+*/
+void NavigationMesh::BuildTriangles() {
+	map<tuple<float, float, float>, int> welded;
+	vector<int> weldedIndex(allVerts.size());
+	for (int i = 0; i < (int)allVerts.size(); ++i) {
+		const Vector3& v = allVerts[i];
+		weldedIndex[i] = welded.insert({ make_tuple(v.x, v.y, v.z), i }).first->second;
+	}
+
+	int triCount = (int)allIndices.size() / 3;
+	allTris.resize(triCount);
+	for (int i = 0; i < triCount; ++i) {
+		NavTri& t = allTris[i];
+		for (int j = 0; j < 3; ++j) {
+			t.indices[j] = weldedIndex[allIndices[(i * 3) + j]];
+		}
+		t.centroid = (allVerts[t.indices[0]] + allVerts[t.indices[1]] + allVerts[t.indices[2]]) / 3.0f;
+	}
+
+	unordered_map<uint64_t, int> openEdges; //tri * 3 + edge, waiting for a neighbour
+	for (int i = 0; i < triCount; ++i) {
+		NavTri& t = allTris[i];
+		for (int j = 0; j < 3; ++j) {
+			uint32_t a = (uint32_t)t.indices[j];
+			uint32_t b = (uint32_t)t.indices[(j + 1) % 3];
+			uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+
+			auto found = openEdges.find(key);
+			if (found == openEdges.end()) {
+				openEdges.insert({ key, (i * 3) + j });
+				continue;
+			}
+			NavTri& other = allTris[found->second / 3];
+			other.neighbours[found->second % 3]	= i;
+			t.neighbours[j]						= found->second / 3;
+			openEdges.erase(found); //any more triangles on this edge can't be walked between
+		}
+	}
+}
+
+/*
+Roughly one cell per triangle, with each triangle listed in every cell its
+bounding box touches - so a lookup only ever has to test a few of them.
+*/
+void NavigationMesh::BuildTriangleGrid() {
+	if (allTris.empty()) {
+		return;
+	}
+	Vector3 gridMax = allVerts[allTris[0].indices[0]];
+	gridMin = gridMax;
+	for (const NavTri& t : allTris) {
+		for (int i : t.indices) {
+			gridMin.x = std::min(gridMin.x, allVerts[i].x);
+			gridMin.z = std::min(gridMin.z, allVerts[i].z);
+			gridMax.x = std::max(gridMax.x, allVerts[i].x);
+			gridMax.z = std::max(gridMax.z, allVerts[i].z);
+		}
+	}
+	float width		= std::max(gridMax.x - gridMin.x, TRIANGLE_EPSILON);
+	float depth		= std::max(gridMax.z - gridMin.z, TRIANGLE_EPSILON);
+	gridCellSize	= std::sqrt((width * depth) / allTris.size());
+	gridCellsX		= (int)(width / gridCellSize) + 1;
+	gridCellsZ		= (int)(depth / gridCellSize) + 1;
+
+	auto forEachCell = [&](const NavTri& t, auto func) {
+		Vector3 lo = allVerts[t.indices[0]];
+		Vector3 hi = lo;
+		for (int i : t.indices) {
+			lo.x = std::min(lo.x, allVerts[i].x);
+			lo.z = std::min(lo.z, allVerts[i].z);
+			hi.x = std::max(hi.x, allVerts[i].x);
+			hi.z = std::max(hi.z, allVerts[i].z);
+		}
+		int x0 = (int)((lo.x - gridMin.x) / gridCellSize);
+		int z0 = (int)((lo.z - gridMin.z) / gridCellSize);
+		int x1 = std::min((int)((hi.x - gridMin.x) / gridCellSize), gridCellsX - 1);
+		int z1 = std::min((int)((hi.z - gridMin.z) / gridCellSize), gridCellsZ - 1);
+		for (int z = z0; z <= z1; ++z) {
+			for (int x = x0; x <= x1; ++x) {
+				func((z * gridCellsX) + x);
+			}
+		}
+	};
+	//Count how many go in each cell first, so they can all be packed into one array
+	gridCellStarts.assign((gridCellsX * gridCellsZ) + 1, 0);
+	for (const NavTri& t : allTris) {
+		forEachCell(t, [&](int cell) { gridCellStarts[cell + 1]++; });
+	}
+	for (int i = 1; i < (int)gridCellStarts.size(); ++i) {
+		gridCellStarts[i] += gridCellStarts[i - 1];
+	}
+	vector<int> filled(gridCellStarts.begin(), gridCellStarts.end() - 1);
+	gridCellTris.resize(gridCellStarts.back());
+	for (int i = 0; i < (int)allTris.size(); ++i) {
+		forEachCell(allTris[i], [&](int cell) { gridCellTris[filled[cell]++] = i; });
+	}
+}
+
+bool NavigationMesh::IsInTriangle(const NavTri& t, const Vector3& p) const {
+	const Vector3& a = verts[t.indices[0]];
+	const Vector3& b = verts[t.indices[1]];
+	const Vector3& c = verts[t.indices[2]];
+	float area = TriArea2(a, b, c);
+	if (std::abs(area) < TRIANGLE_EPSILON) {
+		return false;
+	}
+	//p has to be on the same side of every edge as the triangle is, whichever way round it's wound
+	float tolerance = -TRIANGLE_EPSILON * std::abs(area);
+	float side		= area > 0 ? 1.0f : -1.0f;
+	return	TriArea2(a, b, p) * side >= tolerance &&
+			TriArea2(b, c, p) * side >= tolerance &&
+			TriArea2(c, a, p) * side >= tolerance;
+}
+
+//The height of the triangle's surface, straight above or below p
+float NavigationMesh::GetHeight(const NavTri& t, const Vector3& p) const {
+	const Vector3& a = verts[t.indices[0]];
+	const Vector3& b = verts[t.indices[1]];
+	const Vector3& c = verts[t.indices[2]];
+	float area = TriArea2(a, b, c);
+	float wa = TriArea2(b, c, p) / area;
+	float wb = TriArea2(c, a, p) / area;
+	return (a.y * wa) + (b.y * wb) + (c.y * (1.0f - wa - wb));
+}
+
+int NavigationMesh::GetTriangle(const Vector3& position) const {
+	int x = (int)std::floor((position.x - gridMin.x) / gridCellSize);
+	int z = (int)std::floor((position.z - gridMin.z) / gridCellSize);
+	if (x < 0 || z < 0 || x >= gridCellsX || z >= gridCellsZ) {
+		return -1;
+	}
+	int cell = (z * gridCellsX) + x;
+	int best = -1;
+	float bestHeight = 0;
+	for (int i = cellStarts[cell]; i < cellStarts[cell + 1]; ++i) {
+		const NavTri& t = tris[cellTris[i]];
+		if (!IsInTriangle(t, position)) {
+			continue;
+		}
+		float height = std::abs(GetHeight(t, position) - position.y);
+		if (best < 0 || height < bestHeight) {
+			best		= cellTris[i];
+			bestHeight	= height;
+		}
+	}
+	return best;
+}
+
+int NavigationMesh::GetSharedEdge(int tri, int neighbour) const {
+	for (int i = 0; i < 3; ++i) {
+		if (GetNeighbour(tri, i) == neighbour) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const {
+	int nodesExpanded;
+	return FindPath(from, to, outPath, nodesExpanded);
+}
+
+/*
+A* over the triangles - moving into a triangle costs the distance to the
+middle of the edge it's entered by, from wherever the last one was
+entered. That's not quite the real shortest distance, but it's close, and
+the funnel straightens the path out afterwards anyway.
+*/
+bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+	nodesExpanded = 0;
+	int startTri	= GetTriangle(from);
+	int endTri		= GetTriangle(to);
+	if (startTri < 0 || endTri < 0) {
+		return false; //outside of the mesh!
+	}
+	vector<float>	g(numTris, 0.0f);
+	vector<int>		parent(numTris, -1);
+	vector<Vector3>	entry(numTris);
+	vector<char>	closed(numTris, 0);
+	NodeHeap		openList;
+	openList.Reset(numTris);
+
+	entry[startTri] = from;
+	openList.Push(startTri, (to - from).Length());
+
+	bool found = false;
+	while (!openList.IsEmpty()) {
+		int current = openList.Pop();
+		nodesExpanded++;
+		closed[current] = 1;
+		if (current == endTri) {
+			found = true;
+			break;
+		}
+		const NavTri& t = tris[current];
+		for (int i = 0; i < 3; ++i) {
+			int neighbour = GetNeighbour(current, i);
+			if (neighbour < 0 || closed[neighbour]) {
+				continue;
+			}
+			Vector3 midpoint = (verts[t.indices[i]] + verts[t.indices[(i + 1) % 3]]) * 0.5f;
+			float newG = g[current] + (midpoint - entry[current]).Length();
+
+			bool inOpen = openList.Contains(neighbour);
+			if (inOpen && newG >= g[neighbour]) {
+				continue;
+			}
+			g[neighbour]		= newG;
+			parent[neighbour]	= current;
+			entry[neighbour]	= midpoint;
+
+			float f = newG + (to - midpoint).Length();
+			if (inOpen) {
+				openList.DecreaseKey(neighbour, f);
+			}
+			else {
+				openList.Push(neighbour, f);
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	vector<int> corridor;
+	for (int tri = endTri; tri != -1; tri = parent[tri]) {
+		corridor.emplace_back(tri);
+	}
+	std::reverse(corridor.begin(), corridor.end());
+
+	/*
+	Every edge the path crosses, as a left and right point - which is which
+	depends on which way round the triangle we're coming from is wound.
+	*/
+	vector<Vector3> portals;
+	portals.emplace_back(from);
+	portals.emplace_back(from);
+	for (size_t i = 0; i + 1 < corridor.size(); ++i) {
+		const NavTri& t = tris[corridor[i]];
+		int edge = GetSharedEdge(corridor[i], corridor[i + 1]);
+		const Vector3& a = verts[t.indices[edge]];
+		const Vector3& b = verts[t.indices[(edge + 1) % 3]];
+		if (TriArea2(t.centroid, a, b) > 0) {
+			portals.emplace_back(a);
+			portals.emplace_back(b);
+		}
+		else {
+			portals.emplace_back(b);
+			portals.emplace_back(a);
+		}
+	}
+	portals.emplace_back(to);
+	portals.emplace_back(to);
+
+	vector<Vector3> points;
+	PullString(portals, points);
+	for (auto i = points.rbegin(); i != points.rend(); ++i) {
+		outPath.PushWaypoint(*i);
+	}
+	return true;
+}
+
+/*
+The simple stupid funnel algorithm. A funnel is kept going out from the
+last corner of the path, and narrowed down by each edge the path crosses
+in turn. As soon as one side of the funnel would cross over the other,
+the path has to turn at that side's corner - which becomes the start of
+a new funnel, and everything after it is looked at again.
+*/
+void NavigationMesh::PullString(const vector<Vector3>& portals, vector<Vector3>& outPoints) const {
+	int numPortals = (int)portals.size() / 2;
+
+	Vector3 apex	= portals[0];
+	Vector3 left	= portals[0];
+	Vector3 right	= portals[1];
+	int apexIndex	= 0;
+	int leftIndex	= 0;
+	int rightIndex	= 0;
+
+	outPoints.emplace_back(apex);
+
+	for (int i = 1; i < numPortals; ++i) {
+		const Vector3& newLeft	= portals[(i * 2)];
+		const Vector3& newRight = portals[(i * 2) + 1];
+
+		//Can the right hand side of the funnel move in?
+		if (TriArea2(apex, right, newRight) <= 0.0f) {
+			if (SamePoint(apex, right) || TriArea2(apex, left, newRight) > 0.0f) {
+				right		= newRight;
+				rightIndex	= i;
+			}
+			else { //it'd cross over the left, so the path turns at the left corner
+				apex = left;
+				apexIndex = leftIndex;
+				if (!SamePoint(outPoints.back(), apex)) {
+					outPoints.emplace_back(apex);
+				}
+				left		= apex;
+				right		= apex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i			= apexIndex;
+				continue;
+			}
+		}
+		//And the left?
+		if (TriArea2(apex, left, newLeft) >= 0.0f) {
+			if (SamePoint(apex, left) || TriArea2(apex, right, newLeft) < 0.0f) {
+				left		= newLeft;
+				leftIndex	= i;
+			}
+			else {
+				apex = right;
+				apexIndex = rightIndex;
+				if (!SamePoint(outPoints.back(), apex)) {
+					outPoints.emplace_back(apex);
+				}
+				left		= apex;
+				right		= apex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i			= apexIndex;
+				continue;
+			}
+		}
+	}
+	const Vector3& end = portals[(numPortals - 1) * 2];
+	if (!SamePoint(outPoints.back(), end)) {
+		outPoints.emplace_back(end);
+	}
 }
 
-bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	return false;
+size_t NavigationMesh::GetMemoryUsage() const {
+	return sizeof(*this) + (allTris.capacity() * sizeof(NavTri)) + (allVerts.capacity() * sizeof(Vector3)) +
+		((allIndices.capacity() + gridCellStarts.capacity() + gridCellTris.capacity()) * sizeof(int)) +
+		(mappedFile ? mappedFile->GetSize() : 0);
 }
@@ -4,29 +4,117 @@
 #include <vector>
 namespace NCL {
 	namespace CSC8503 {
+		class MappedFile;
+
+		/*
+		Paths over a mesh of walkable triangles. Triangles are searched with
+		A* (moving between the middles of the edges they share), and then the
+		corridor of triangles the search went through is pulled tight with
+		the 'simple stupid funnel algorithm' - so paths only turn at corners,
+		rather than zig-zagging through every triangle's edge.
+
+		Vertices in the same place are treated as the same vertex, however
+		the file lists them, and triangles sharing an edge are joined up as
+		they're loaded. Finding which triangle a point is in goes through a
+		grid over the mesh (looking from above), and if a few triangles are
+		stacked up over a point, the one closest in height is used.
+
+		The mesh never changes once it's loaded, so searches can run on any
+		number of threads at once.
+
+		As well as the text .navmesh files, a mesh can be saved out with
+		WriteBinary once all that's been worked out - the vertices, then the
+		triangles (with their indices and neighbours), then the lookup grid,
+		each as an array exactly as it's used. Binary files are mapped into
+		memory and used from there, with no parsing, welding or joining up
+		to do. As with grids, NavigationAssets keeps one shared copy of each.
+		*/
 		class NavigationMesh : public NavigationMap	{
 		public:
 			NavigationMesh();
 			NavigationMesh(const std::string&filename);
 			~NavigationMesh();
 
-			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-		
-		protected:
+			//It points into its own data (or its mapped file), so can't just be copied
+			NavigationMesh(const NavigationMesh&) = delete;
+			NavigationMesh& operator=(const NavigationMesh&) = delete;
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const override;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const override;
+
+			size_t GetMemoryUsage() const override;
+
+			//Relative to the data folder, like the file a mesh is loaded from
+			bool WriteBinary(const std::string& filename) const;
+
+			//-1 if the point isn't over the mesh
+			int GetTriangle(const Vector3& position) const;
+
+			int GetNumTriangles() const {
+				return numTris;
+			}
 
+			Vector3 GetTriangleCentre(int tri) const {
+				return tris[tri].centroid;
+			}
+
+			//-1 if there's nothing on the other side of that edge
+			int GetNeighbour(int tri, int edge) const {
+				return tris[tri].neighbours[edge];
+			}
+
+		protected:
+			/*
+			Edge i runs from vertex i to vertex i + 1, and neighbours[i] is
+			the triangle on the other side of it. It's all plain numbers (no
+			pointers), so that triangles can be used straight from a file.
+			*/
 			struct NavTri {
-				NavTri* neighbours[3];
+				int		neighbours[3];
+				int		indices[3];
+				Vector3 centroid;
 
 				NavTri() {
-					neighbours[0] = nullptr;
-					neighbours[1] = nullptr;
-					neighbours[2] = nullptr;
+					neighbours[0] = -1;
+					neighbours[1] = -1;
+					neighbours[2] = -1;
 				}
 			};
 
+			void BuildTriangles();
+			void BuildTriangleGrid();
+			void UseLoadedData();
+			bool LoadBinary(const std::string& path);
+
+			bool	IsInTriangle(const NavTri& t, const Vector3& p) const;
+			float	GetHeight(const NavTri& t, const Vector3& p) const;
+
+			int GetSharedEdge(int tri, int neighbour) const;
+
+			void PullString(const std::vector<Vector3>& portals, std::vector<Vector3>& outPoints) const;
+
+			//Either the vectors' data, or straight out of the mapped file
+			const NavTri*	tris;
+			const Vector3*	verts;
+			const int*		cellStarts;
+			const int*		cellTris;
+			int				numTris;
+			int				numVerts;
+			int				numCellTris;
+			MappedFile*		mappedFile;
+
+			//Only used by meshes loaded from text
 			std::vector<NavTri>		allTris;
 			std::vector<Vector3>	allVerts;
 			std::vector<int>		allIndices;
+
+			//Which triangles overlap each cell of a grid laid over the mesh
+			Vector3				gridMin;
+			float				gridCellSize;
+			int					gridCellsX;
+			int					gridCellsZ;
+			std::vector<int>	gridCellStarts;
+			std::vector<int>	gridCellTris;
 		};
 	}
-}
\ No newline at end of file
+}
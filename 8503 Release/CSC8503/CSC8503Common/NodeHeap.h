@@ -0,0 +1,152 @@
+#pragma once
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A binary min-heap of node indices, sorted by a key (usually A*'s f
+		score, but anything with a < will do). Where each node is in the
+		heap is tracked, so a node that's found a cheaper route can be moved
+		up straight away, rather than having to be searched for.
+
+		The places array is never cleared - an entry is only trusted if the
+		heap really has that node in that place - so starting a new search
+		is just a case of emptying the heap.
+		*/
+		template <typename KeyType>
+		class BasicNodeHeap {
+		public:
+			BasicNodeHeap() {
+			}
+			~BasicNodeHeap() {
+			}
+
+			void Reset(int numNodes) {
+				entries.clear();
+				if ((int)places.size() < numNodes) {
+					places.resize(numNodes, 0);
+				}
+			}
+
+			bool IsEmpty() const {
+				return entries.empty();
+			}
+
+			int GetSize() const {
+				return (int)entries.size();
+			}
+
+			bool Contains(int node) const {
+				int p = places[node];
+				return p < (int)entries.size() && entries[p].node == node;
+			}
+
+			void Push(int node, const KeyType& key) {
+				entries.push_back({ key, node });
+				places[node] = (int)entries.size() - 1;
+				SiftUp((int)entries.size() - 1);
+			}
+
+			//The key can only ever go down
+			void DecreaseKey(int node, const KeyType& key) {
+				int p = places[node];
+				entries[p].key = key;
+				SiftUp(p);
+			}
+
+			//The key can go either way
+			void UpdateKey(int node, const KeyType& key) {
+				int p = places[node];
+				bool up = key < entries[p].key;
+				entries[p].key = key;
+				if (up) {
+					SiftUp(p);
+				}
+				else {
+					SiftDown(p);
+				}
+			}
+
+			//Takes a node out from anywhere in the heap
+			void Remove(int node) {
+				int p		= places[node];
+				Entry last	= entries.back();
+				entries.pop_back();
+				if (p < (int)entries.size()) {
+					entries[p]			= last;
+					places[last.node]	= p;
+					SiftUp(p);
+					SiftDown(places[last.node]);
+				}
+			}
+
+			int GetTop() const {
+				return entries[0].node;
+			}
+
+			const KeyType& GetTopKey() const {
+				return entries[0].key;
+			}
+
+			int Pop() {
+				int top		= entries[0].node;
+				Entry last	= entries.back();
+				entries.pop_back();
+				if (!entries.empty()) {
+					entries[0]			= last;
+					places[last.node]	= 0;
+					SiftDown(0);
+				}
+				return top;
+			}
+
+		protected:
+			struct Entry {
+				KeyType	key;
+				int		node;
+			};
+
+			void SiftUp(int i) {
+				Entry e = entries[i];
+				while (i > 0) {
+					int parent = (i - 1) / 2;
+					if (!(e.key < entries[parent].key)) {
+						break;
+					}
+					entries[i]					= entries[parent];
+					places[entries[i].node]		= i;
+					i = parent;
+				}
+				entries[i]		= e;
+				places[e.node]	= i;
+			}
+
+			void SiftDown(int i) {
+				int count	= (int)entries.size();
+				Entry e		= entries[i];
+				while (true) {
+					int child = (i * 2) + 1;
+					if (child >= count) {
+						break;
+					}
+					if (child + 1 < count && entries[child + 1].key < entries[child].key) {
+						child++;
+					}
+					if (!(entries[child].key < e.key)) {
+						break;
+					}
+					entries[i]					= entries[child];
+					places[entries[i].node]		= i;
+					i = child;
+				}
+				entries[i]		= e;
+				places[e.node]	= i;
+			}
+
+			std::vector<Entry>	entries;
+			std::vector<int>	places;
+		};
+
+		typedef BasicNodeHeap<float> NodeHeap;
+	}
+}
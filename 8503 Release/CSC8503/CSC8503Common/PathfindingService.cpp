@@ -0,0 +1,230 @@
+#include "PathfindingService.h"
+#include <cstdlib>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+//How many nodes a worker expands before it checks if anything more important has come in
+const int SEARCH_SLICE = 256;
+
+PathfindingService::PathfindingService(const NavigationGrid& grid, int numWorkers, int nodesPerFrame, int coalesceRadius, bool smoothPaths) : grid(grid) {
+	this->nodesPerFrame		= nodesPerFrame;
+	this->coalesceRadius	= coalesceRadius;
+	this->smoothPaths		= smoothPaths;
+	budget					= nodesPerFrame;
+	nextOrder				= 0;
+	shuttingDown			= false;
+
+	if (numWorkers < 1) {
+		numWorkers = 1;
+	}
+	for (int i = 0; i < numWorkers; ++i) {
+		workers.emplace_back(&PathfindingService::WorkerThread, this);
+	}
+}
+
+PathfindingService::~PathfindingService() {
+	{
+		std::lock_guard<std::mutex> lock(serviceLock);
+		shuttingDown = true;
+	}
+	workReady.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+	for (Search* s : searches) {
+		delete s->search;
+		delete s;
+	}
+}
+
+void PathfindingService::RequestPath(const PathRequest& request) {
+	int startX, startY, goalX, goalY;
+	bool onGrid = grid.GetCell(request.from, startX, startY) && grid.GetCell(request.to, goalX, goalY);
+	{
+		std::lock_guard<std::mutex> lock(serviceLock);
+		RemoveAgent(request.agentID);
+
+		if (!onGrid) { //no point bothering the workers with this one
+			PathResult result;
+			result.agentID = request.agentID;
+			completed[request.agentID] = result;
+			return;
+		}
+		Search* s = FindSearchToJoin(startX, startY, goalX, goalY);
+		if (!s) {
+			s = new Search();
+			s->request	= request;
+			s->startX	= startX;
+			s->startY	= startY;
+			s->goalX	= goalX;
+			s->goalY	= goalY;
+			s->order	= nextOrder++;
+			searches.emplace_back(s);
+		}
+		else if (request.priority > s->request.priority) {
+			s->request.priority = request.priority;
+		}
+		s->agents.emplace_back(request.agentID);
+		waiting[request.agentID] = s;
+	}
+	workReady.notify_one();
+}
+
+void PathfindingService::BeginFrame() {
+	if (nodesPerFrame <= 0) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(serviceLock);
+		budget = nodesPerFrame;
+	}
+	workReady.notify_all();
+}
+
+bool PathfindingService::CollectResult(int agentID, PathResult& result) {
+	std::lock_guard<std::mutex> lock(serviceLock);
+	auto i = completed.find(agentID);
+	if (i == completed.end()) {
+		return false;
+	}
+	result = std::move(i->second);
+	completed.erase(i);
+	return true;
+}
+
+bool PathfindingService::IsWaiting(int agentID) const {
+	std::lock_guard<std::mutex> lock(serviceLock);
+	return waiting.find(agentID) != waiting.end();
+}
+
+void PathfindingService::CancelRequest(int agentID) {
+	std::lock_guard<std::mutex> lock(serviceLock);
+	RemoveAgent(agentID);
+	completed.erase(agentID);
+}
+
+/*
+Everything below here expects serviceLock to already be held
+*/
+PathfindingService::Search* PathfindingService::FindSearchToJoin(int startX, int startY, int goalX, int goalY) const {
+	for (Search* s : searches) {
+		if (std::abs(s->startX - startX) <= coalesceRadius && std::abs(s->startY - startY) <= coalesceRadius &&
+			std::abs(s->goalX - goalX) <= coalesceRadius && std::abs(s->goalY - goalY) <= coalesceRadius) {
+			return s;
+		}
+	}
+	return nullptr;
+}
+
+//Highest priority first, and then whichever was asked for first
+PathfindingService::Search* PathfindingService::GetNextSearch() const {
+	Search* best = nullptr;
+	for (Search* s : searches) {
+		if (s->busy) {
+			continue;
+		}
+		if (!best || s->request.priority > best->request.priority ||
+			(s->request.priority == best->request.priority && s->order < best->order)) {
+			best = s;
+		}
+	}
+	return best;
+}
+
+bool PathfindingService::HasWork() const {
+	if (nodesPerFrame > 0 && budget <= 0) {
+		return false;
+	}
+	return GetNextSearch() != nullptr;
+}
+
+//If nobody wants a search any more it's thrown away - unless a worker is in the middle of it
+void PathfindingService::RemoveAgent(int agentID) {
+	auto i = waiting.find(agentID);
+	if (i == waiting.end()) {
+		return;
+	}
+	Search* s = i->second;
+	waiting.erase(i);
+	s->agents.erase(std::find(s->agents.begin(), s->agents.end(), agentID));
+
+	if (s->agents.empty() && !s->busy) {
+		searches.erase(std::find(searches.begin(), searches.end(), s));
+		delete s->search;
+		delete s;
+	}
+}
+
+void PathfindingService::Finish(Search* s, const PathResult& result) {
+	for (int agentID : s->agents) {
+		PathResult& r = completed[agentID];
+		r = result;
+		r.agentID = agentID;
+		waiting.erase(agentID);
+	}
+	searches.erase(std::find(searches.begin(), searches.end(), s));
+	delete s->search;
+	delete s;
+}
+
+/*
+Each time round, a worker takes a slice of the frame's budget, and spends
+it on the most important search that nobody else is working on. Searches
+are only ever touched by the worker that has them marked as busy, so the
+searching itself happens without the lock held.
+*/
+void PathfindingService::WorkerThread() {
+	std::unique_lock<std::mutex> lock(serviceLock);
+	while (true) {
+		workReady.wait(lock, [&] { return shuttingDown || HasWork(); });
+		if (shuttingDown) {
+			return;
+		}
+		Search* s = GetNextSearch();
+		int slice = SEARCH_SLICE;
+		if (nodesPerFrame > 0) {
+			slice	= budget < SEARCH_SLICE ? budget : SEARCH_SLICE;
+			budget -= slice;
+		}
+		s->busy = true;
+		lock.unlock();
+
+		if (!s->search) {
+			s->search = new GridPathSearch(grid);
+			s->search->Start(s->request.from, s->request.to);
+		}
+		int before			= s->search->GetNodesExpanded();
+		SearchStatus status	= s->search->Expand(slice);
+		int used			= s->search->GetNodesExpanded() - before;
+
+		PathResult result;
+		if (status == SearchStatus::Found) {
+			NavigationPath path;
+			s->search->GetPath(path);
+			if (smoothPaths) {
+				grid.SmoothPath(path);
+			}
+			result.found = true;
+			Vector3 waypoint;
+			while (path.PopWaypoint(waypoint)) {
+				result.waypoints.emplace_back(waypoint);
+			}
+		}
+		lock.lock();
+		s->busy = false;
+		if (nodesPerFrame > 0) {
+			budget += slice - used; //whatever this search didn't need
+			if (budget > nodesPerFrame) {
+				budget = nodesPerFrame;
+			}
+		}
+		if (status != SearchStatus::Searching || s->agents.empty()) {
+			Finish(s, result);
+		}
+		if (HasWork()) {
+			workReady.notify_one();
+		}
+	}
+}
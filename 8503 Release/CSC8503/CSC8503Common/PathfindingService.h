@@ -0,0 +1,110 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		struct PathRequest {
+			Vector3	from;
+			Vector3	to;
+			int		agentID		= -1;
+			int		priority	= 0;	//higher goes first
+		};
+
+		struct PathResult {
+			int						agentID = -1;
+			bool					found	= false;
+			std::vector<Vector3>	waypoints;	//from the start to the goal
+		};
+
+		/*
+		Does agents' path searches on worker threads, instead of inside their
+		state updates, so one long search can't make a frame hitch.
+
+		Every frame, BeginFrame tops up a budget of how many nodes the
+		workers can expand before the next one - searches that need more
+		than that just carry on next frame, from where they got to. Higher
+		priority requests are worked on first, and take over from anything
+		lower at the end of each slice.
+
+		A request that starts and ends within a couple of cells of one that's
+		already waiting (or being searched) is just added on to it, and they
+		both get the same path. A new request from an agent replaces whatever
+		it had asked for before.
+
+		With smoothPaths set, finished paths are pulled tight (with the
+		grid's SmoothPath) on the worker, so they only have a waypoint at
+		each corner.
+
+		Finished paths wait, one per agent, until CollectResult is called for
+		that agent - agents should keep following whatever path they already
+		had until then.
+		*/
+		class PathfindingService {
+		public:
+			//A nodesPerFrame of 0 means there's no budget at all
+			PathfindingService(const NavigationGrid& grid, int numWorkers = 1, int nodesPerFrame = 4096, int coalesceRadius = 2, bool smoothPaths = false);
+			~PathfindingService();
+
+			void RequestPath(const PathRequest& request);
+
+			//Called once a frame, on the game thread
+			void BeginFrame();
+
+			bool CollectResult(int agentID, PathResult& result);
+
+			//True if the agent has asked for a path that it hasn't got back yet
+			bool IsWaiting(int agentID) const;
+
+			/*
+			Forgets anything the agent has asked for, or has waiting to be
+			collected. Agent IDs get reused, so this has to be called before
+			an agent goes away - otherwise whatever takes its ID next would
+			be handed its path.
+			*/
+			void CancelRequest(int agentID);
+
+		protected:
+			struct Search {
+				PathRequest			request;
+				int					startX;
+				int					startY;
+				int					goalX;
+				int					goalY;
+				uint64_t			order;
+				std::vector<int>	agents;
+				GridPathSearch*		search	= nullptr;
+				bool				busy	= false;
+			};
+
+			void	WorkerThread();
+			Search* FindSearchToJoin(int startX, int startY, int goalX, int goalY) const;
+			Search* GetNextSearch() const;
+			void	RemoveAgent(int agentID);
+			void	Finish(Search* s, const PathResult& result);
+
+			bool HasWork() const;
+
+			const NavigationGrid&	grid;
+			int						nodesPerFrame;
+			int						coalesceRadius;
+			bool					smoothPaths;
+			int						budget;
+			uint64_t				nextOrder;
+			bool					shuttingDown;
+
+			std::vector<Search*>					searches;
+			std::unordered_map<int, Search*>		waiting;	//which search each agent is on
+			std::unordered_map<int, PathResult>		completed;
+
+			std::vector<std::thread>	workers;
+			mutable std::mutex			serviceLock;
+			std::condition_variable		workReady;
+		};
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include <atomic>
+#include <vector>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		class GameObject;
+
+		enum class PhysicsCommandType {
+			AddForce,
+			AddForceAtPosition,
+			AddTorque,
+			SetPosition,
+			SetLinearVelocity,
+			DisableCollisions
+		};
+
+		/*
+		Something the game wants done to an object, that has to wait until
+		the physics thread is between steps. Its physics object is only
+		looked up once the command is run, as it might have moved by then.
+		*/
+		struct PhysicsCommand {
+			PhysicsCommandType	type;
+			GameObject*			object;
+			Vector3				value;
+			Vector3				position;
+		};
+
+		/*
+		A fixed size ring buffer, for passing commands from one thread (the
+		game) to one other thread (physics) without any locking - each end
+		only ever writes its own index, and just reads the other one.
+		*/
+		class PhysicsCommandQueue {
+		public:
+			//Capacity gets rounded up to a power of two
+			PhysicsCommandQueue(int capacity = 16384) {
+				int size = 1;
+				while (size < capacity) {
+					size <<= 1;
+				}
+				commands.resize(size);
+				mask = size - 1;
+				head = 0;
+				tail = 0;
+			}
+
+			//Only to be called from the producing thread. Returns false,
+			//and drops the command, if the queue is full
+			bool Push(const PhysicsCommand& c) {
+				size_t h = head.load(std::memory_order_relaxed);
+				if (h - tail.load(std::memory_order_acquire) >= commands.size()) {
+					return false;
+				}
+				commands[h & mask] = c;
+				head.store(h + 1, std::memory_order_release);
+				return true;
+			}
+
+			//Only to be called from the consuming thread
+			bool Pop(PhysicsCommand& c) {
+				size_t t = tail.load(std::memory_order_relaxed);
+				if (t == head.load(std::memory_order_acquire)) {
+					return false;
+				}
+				c = commands[t & mask];
+				tail.store(t + 1, std::memory_order_release);
+				return true;
+			}
+
+		protected:
+			std::vector<PhysicsCommand>	commands;
+			size_t						mask;
+			//Kept on separate cache lines, so the two threads don't fight
+			alignas(64) std::atomic<size_t>	head;
+			alignas(64) std::atomic<size_t>	tail;
+		};
+	}
+}
@@ -1,6 +1,7 @@
 #include "PhysicsObject.h"
 #include "PhysicsSystem.h"
 #include "../CSC8503Common/Transform.h"
+#include "PhysicsCommandQueue.h"
 using namespace NCL;
 using namespace CSC8503;
 
@@ -11,6 +12,11 @@ PhysicsObject::PhysicsObject(Transform* parentTransform, const CollisionVolume*
 	inverseMass = 1.0f;
 	elasticity	= 0.8f;
 	friction	= 0.8f;
+
+	inertiaDirty = true;
+	massDirty	 = false;
+	commandQueue = nullptr;
+	owner		 = nullptr;
 }
 
 PhysicsObject::~PhysicsObject()	{
@@ -29,10 +35,18 @@ void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
 }
 
 void PhysicsObject::AddForce(const Vector3& addedForce) {
+	if (commandQueue) {
+		commandQueue->Push({ PhysicsCommandType::AddForce, owner, addedForce, Vector3() });
+		return;
+	}
 	force += addedForce;
 }
 
 void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3& position) {
+	if (commandQueue) {
+		commandQueue->Push({ PhysicsCommandType::AddForceAtPosition, owner, addedForce, position });
+		return;
+	}
 	Vector3 localPos = position - transform->GetPosition();
 
 	force  += addedForce;
@@ -40,9 +54,40 @@ void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3&
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) {
+	if (commandQueue) {
+		commandQueue->Push({ PhysicsCommandType::AddTorque, owner, addedTorque, Vector3() });
+		return;
+	}
 	torque += addedTorque;
 }
 
+/*
+Called on the physics thread - the queue is bypassed, as we're now the
+ones allowed to touch the object!
+*/
+void PhysicsObject::ExecuteCommand(const PhysicsCommand& command) {
+	switch (command.type) {
+		case PhysicsCommandType::AddForce:
+			force += command.value;
+			break;
+		case PhysicsCommandType::AddForceAtPosition:
+			force  += command.value;
+			torque += Vector3::Cross(command.position - transform->GetPosition(), command.value);
+			break;
+		case PhysicsCommandType::AddTorque:
+			torque += command.value;
+			break;
+		case PhysicsCommandType::SetPosition:
+			transform->SetPosition(command.value);
+			break;
+		case PhysicsCommandType::SetLinearVelocity:
+			linearVelocity = command.value;
+			break;
+		default:
+			break;
+	}
+}
+
 void PhysicsObject::ClearForces() {
 	force				= Vector3();
 	torque				= Vector3();
@@ -58,6 +103,7 @@ void PhysicsObject::InitCubeInertia() {
 	inverseInertia.x = (12.0f * inverseMass) / (dimsSqr.y + dimsSqr.z);
 	inverseInertia.y = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.z);
 	inverseInertia.z = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.y);
+	inertiaDirty = true;
 }
 
 void PhysicsObject::InitSphereInertia() {
@@ -65,13 +111,42 @@ void PhysicsObject::InitSphereInertia() {
 	float i			= 2.5f * inverseMass / (radius*radius);
 
 	inverseInertia	= Vector3(i, i, i);
+	inertiaDirty	= true;
 }
 
+bool PhysicsObject::InertiaNeedsUpdate() const {
+	if (inertiaDirty) {
+		return true;
+	}
+	return !IsInertiaIsotropic() && transform->GetOrientation() != inertiaOrientation;
+}
+
+/*
+Rotating a diagonal tensor only needs the one rotation matrix - each
+element is just the sum of the 3 axes' inertia, weighted by how much of
+that axis lines up with its row and column.
+*/
 void PhysicsObject::UpdateInertiaTensor() {
+	if (!InertiaNeedsUpdate()) {
+		return;
+	}
 	Quaternion q = transform->GetOrientation();
-	
-	Matrix3 invOrientation	= Matrix3(q.Conjugate());
-	Matrix3 orientation		= Matrix3(q);
 
-	inverseInteriaTensor = orientation * Matrix3::Scale(inverseInertia) *invOrientation;
+	if (IsInertiaIsotropic()) {
+		SetInertiaTensor(Matrix3::Scale(inverseInertia), q);
+		return;
+	}
+	Matrix3 orientation = Matrix3(q);
+	Matrix3 tensor;
+	for (int row = 0; row < 3; ++row) {
+		for (int column = row; column < 3; ++column) {
+			float value =
+				orientation.array[row]	   * inverseInertia.x * orientation.array[column] +
+				orientation.array[3 + row] * inverseInertia.y * orientation.array[3 + column] +
+				orientation.array[6 + row] * inverseInertia.z * orientation.array[6 + column];
+			tensor.array[column * 3 + row] = value;
+			tensor.array[row * 3 + column] = value;
+		}
+	}
+	SetInertiaTensor(tensor, q);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../Common/Vector3.h"
 #include "../../Common/Matrix3.h"
+#include "../../Common/Quaternion.h"
 
 using namespace NCL::Maths;
 
@@ -9,6 +10,9 @@ namespace NCL {
 	
 	namespace CSC8503 {
 		class Transform;
+		class GameObject;
+		class PhysicsCommandQueue;
+		struct PhysicsCommand;
 
 		class PhysicsObject	{
 		public:
@@ -31,10 +35,23 @@ namespace NCL {
 				return force;
 			}
 
+			//An object going from fixed to moving (or back) changes which
+			//constraints can be solved alongside each other
 			void SetInverseMass(float invMass) {
+				if ((invMass > 0.0f) != (inverseMass > 0.0f)) {
+					massDirty = true;
+				}
 				inverseMass = invMass;
 			}
 
+			bool IsMassDirty() const {
+				return massDirty;
+			}
+
+			void ClearMassDirty() {
+				massDirty = false;
+			}
+
 			float GetInverseMass() const {
 				return inverseMass;
 			}
@@ -67,6 +84,35 @@ namespace NCL {
 
 			void ClearForces();
 
+			/*
+			While physics is running on its own thread, forces and torques
+			from the game get queued up, and are only actually added once
+			the physics thread runs the command.
+			*/
+			void SetCommandQueue(PhysicsCommandQueue* queue) {
+				commandQueue = queue;
+			}
+
+			PhysicsCommandQueue* GetCommandQueue() const {
+				return commandQueue;
+			}
+
+			void ExecuteCommand(const PhysicsCommand& command);
+
+			//For when the transform has been moved somewhere else in memory
+			void SetTransform(Transform* t) {
+				transform = t;
+			}
+
+			/*
+			Queued commands refer to the object this belongs to, rather
+			than to this, as this can be moved about in memory (or deleted)
+			before the physics thread gets round to them.
+			*/
+			void SetOwner(GameObject* o) {
+				owner = o;
+			}
+
 			void SetLinearVelocity(const Vector3& v) {
 				linearVelocity = v;
 			}
@@ -75,11 +121,50 @@ namespace NCL {
 				angularVelocity = v;
 			}
 
+			//Forces are normally only ever added - these are for putting
+			//an object back exactly how it was, from a snapshot
+			void SetForce(const Vector3& f) {
+				force = f;
+			}
+
+			void SetTorque(const Vector3& t) {
+				torque = t;
+			}
+
+			void SetLocalInverseInertia(const Vector3& i) {
+				inverseInertia	= i;
+				inertiaDirty	= true;
+			}
+
 			void InitCubeInertia();
 			void InitSphereInertia();
 
+			/*
+			The world space inertia tensor only changes when the object
+			turns, so it's cached along with the orientation it was worked
+			out for. Objects with the same inertia around every axis (like
+			spheres) never need it rotating at all.
+			*/
 			void UpdateInertiaTensor();
 
+			bool InertiaNeedsUpdate() const;
+
+			bool IsInertiaIsotropic() const {
+				return inverseInertia.x == inverseInertia.y && inverseInertia.y == inverseInertia.z;
+			}
+
+			Vector3 GetLocalInverseInertia() const {
+				return inverseInertia;
+			}
+
+			//For when the tensor has been worked out elsewhere, such as
+			//in PhysicsSystem's batched update
+			void SetInertiaTensor(const Matrix3& tensor, const Quaternion& orientation) {
+				inverseInteriaTensor	= tensor;
+				inertiaOrientation		= orientation;
+				inertiaDirty			= false;
+			}
+
 			Matrix3 GetInertiaTensor() const {
 				return inverseInteriaTensor;
 			}
@@ -87,6 +172,8 @@ namespace NCL {
 		protected:
 			const CollisionVolume* volume;
 			Transform*		transform;
+			PhysicsCommandQueue* commandQueue;
+			GameObject*		owner;
 
 			float inverseMass;
 			float elasticity;
@@ -102,6 +189,9 @@ namespace NCL {
 			Vector3 torque;
 			Vector3 inverseInertia;
 			Matrix3 inverseInteriaTensor;
+			Quaternion inertiaOrientation;
+			bool	inertiaDirty;
+			bool	massDirty;
 		};
 	}
 }
@@ -0,0 +1,212 @@
+#include "PhysicsStats.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+RollingStat::RollingStat(int windowSize) {
+	samples.resize(windowSize > 0 ? windowSize : 1);
+	Clear();
+}
+
+void RollingStat::AddSample(float value) {
+	samples[next] = value;
+	next = (next + 1) % samples.size();
+	if (count < (int)samples.size()) {
+		count++;
+	}
+}
+
+void RollingStat::Clear() {
+	next	= 0;
+	count	= 0;
+}
+
+float RollingStat::GetMin() const {
+	if (count == 0) {
+		return 0.0f;
+	}
+	float result = samples[0];
+	for (int i = 1; i < count; ++i) {
+		result = std::min(result, samples[i]);
+	}
+	return result;
+}
+
+float RollingStat::GetMax() const {
+	if (count == 0) {
+		return 0.0f;
+	}
+	float result = samples[0];
+	for (int i = 1; i < count; ++i) {
+		result = std::max(result, samples[i]);
+	}
+	return result;
+}
+
+float RollingStat::GetAverage() const {
+	if (count == 0) {
+		return 0.0f;
+	}
+	float total = 0.0f;
+	for (int i = 0; i < count; ++i) {
+		total += samples[i];
+	}
+	return total / count;
+}
+
+PhysicsStats::PhysicsStats(int windowSize) {
+	for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+		phaseStats[i] = RollingStat(windowSize);
+	}
+	for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+		counterStats[i] = RollingStat(windowSize);
+	}
+	totalStat	= RollingStat(windowSize);
+	frameCount	= 0;
+	dumpFormat	= PhysicsStatsFormat::CSV;
+}
+
+PhysicsStats::~PhysicsStats() {
+	StopDump();
+}
+
+Timepoint PhysicsStats::Now() {
+	return std::chrono::high_resolution_clock::now();
+}
+
+float PhysicsStats::MillisecondsSince(const Timepoint& start) {
+	std::chrono::duration<float, std::milli> diff = Now() - start;
+	return diff.count();
+}
+
+void PhysicsStats::AddPhaseTime(PhysicsPhase p, const Timepoint& start) {
+	current.phaseTime[(int)p] += MillisecondsSince(start);
+}
+
+void PhysicsStats::BeginFrame() {
+	current.Reset();
+	frameStart = Now();
+}
+
+/*
+Called once the physics update has finished - the frame's values get pushed
+into the rolling windows, and written out to the dump file if we have one.
+*/
+void PhysicsStats::EndFrame() {
+	current.totalTime = MillisecondsSince(frameStart);
+
+	for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+		phaseStats[i].AddSample(current.phaseTime[i]);
+	}
+	for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+		counterStats[i].AddSample((float)current.counters[i]);
+	}
+	totalStat.AddSample(current.totalTime);
+
+	last = current;
+	frameCount++;
+
+	if (dumpFile.is_open()) {
+		WriteFrame();
+	}
+}
+
+bool PhysicsStats::StartDump(const std::string& filename, PhysicsStatsFormat format) {
+	StopDump();
+	dumpFile.open(filename);
+	if (!dumpFile.is_open()) {
+		std::cout << "Can't open " << filename << " for physics stats!\n";
+		return false;
+	}
+	dumpFormat = format;
+
+	if (dumpFormat == PhysicsStatsFormat::CSV) {
+		dumpFile << "frame,total";
+		for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+			dumpFile << "," << GetPhaseName((PhysicsPhase)i);
+		}
+		for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+			dumpFile << "," << GetCounterName((PhysicsCounter)i);
+		}
+		dumpFile << "\n";
+	}
+	return true;
+}
+
+void PhysicsStats::StopDump() {
+	if (dumpFile.is_open()) {
+		dumpFile.close();
+	}
+}
+
+/*
+CSV gets one row per frame. JSON is written as one object per line, so the
+file can be streamed / appended to without ever having to close an array.
+*/
+void PhysicsStats::WriteFrame() {
+	if (dumpFormat == PhysicsStatsFormat::CSV) {
+		dumpFile << frameCount << "," << last.totalTime;
+		for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+			dumpFile << "," << last.phaseTime[i];
+		}
+		for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+			dumpFile << "," << last.counters[i];
+		}
+		dumpFile << "\n";
+	}
+	else {
+		dumpFile << "{\"frame\":" << frameCount << ",\"total\":" << last.totalTime << ",\"phases\":{";
+		for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+			dumpFile << (i ? "," : "") << "\"" << GetPhaseName((PhysicsPhase)i) << "\":" << last.phaseTime[i];
+		}
+		dumpFile << "},\"counters\":{";
+		for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+			dumpFile << (i ? "," : "") << "\"" << GetCounterName((PhysicsCounter)i) << "\":" << last.counters[i];
+		}
+		dumpFile << "}}\n";
+	}
+}
+
+void PhysicsStats::PrintSummary(std::ostream& o) const {
+	o << std::fixed << std::setprecision(3);
+	o << "Physics stats over last " << totalStat.GetSampleCount() << " frames (min / avg / max)\n";
+	o << "  " << std::setw(20) << std::left << "Total (ms)" << totalStat.GetMin() << " / " << totalStat.GetAverage() << " / " << totalStat.GetMax() << "\n";
+	for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+		const RollingStat& s = phaseStats[i];
+		o << "  " << std::setw(20) << std::left << GetPhaseName((PhysicsPhase)i) << s.GetMin() << " / " << s.GetAverage() << " / " << s.GetMax() << "\n";
+	}
+	for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+		const RollingStat& s = counterStats[i];
+		o << "  " << std::setw(20) << std::left << GetCounterName((PhysicsCounter)i) << s.GetMin() << " / " << s.GetAverage() << " / " << s.GetMax() << "\n";
+	}
+	o << std::defaultfloat << std::right;
+}
+
+const char* PhysicsStats::GetPhaseName(PhysicsPhase p) {
+	switch (p) {
+		case PhysicsPhase::IntegrateAccel:		return "IntegrateAccel";
+		case PhysicsPhase::BroadPhase:			return "BroadPhase";
+		case PhysicsPhase::NarrowPhase:			return "NarrowPhase";
+		case PhysicsPhase::Solver:				return "Solver";
+		case PhysicsPhase::Constraints:			return "Constraints";
+		case PhysicsPhase::IntegrateVelocity:	return "IntegrateVelocity";
+		case PhysicsPhase::UpdateCollisionList:	return "UpdateCollisionList";
+		default:								return "Unknown";
+	}
+}
+
+const char* PhysicsStats::GetCounterName(PhysicsCounter c) {
+	switch (c) {
+		case PhysicsCounter::Bodies:			return "Bodies";
+		case PhysicsCounter::AwakeBodies:		return "AwakeBodies";
+		case PhysicsCounter::CandidatePairs:	return "CandidatePairs";
+		case PhysicsCounter::Contacts:			return "Contacts";
+		case PhysicsCounter::Substeps:			return "Substeps";
+		case PhysicsCounter::SolverIterations:	return "SolverIterations";
+		case PhysicsCounter::ConstraintColours:	return "ConstraintColours";
+		default:								return "Unknown";
+	}
+}
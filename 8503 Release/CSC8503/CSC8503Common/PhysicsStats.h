@@ -0,0 +1,159 @@
+#pragma once
+#include "../../Common/GameTimer.h"
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace NCL {
+	namespace CSC8503 {
+		enum class PhysicsPhase {
+			IntegrateAccel,
+			BroadPhase,
+			NarrowPhase,
+			Solver,
+			Constraints,
+			IntegrateVelocity,
+			UpdateCollisionList,
+			MAX_PHASES
+		};
+
+		enum class PhysicsCounter {
+			Bodies,
+			AwakeBodies,
+			CandidatePairs,
+			Contacts,
+			Substeps,
+			SolverIterations,
+			ConstraintColours,
+			MAX_COUNTERS
+		};
+
+		enum class PhysicsStatsFormat {
+			CSV,
+			JSON
+		};
+
+		const int NUM_PHYSICS_PHASES	= (int)PhysicsPhase::MAX_PHASES;
+		const int NUM_PHYSICS_COUNTERS	= (int)PhysicsCounter::MAX_COUNTERS;
+
+		/*
+		Everything we measured during a single call to PhysicsSystem::Update.
+		Phase times are in milliseconds, and are summed across every substep
+		taken that frame.
+		*/
+		struct PhysicsFrameStats {
+			float	phaseTime[NUM_PHYSICS_PHASES];
+			int		counters[NUM_PHYSICS_COUNTERS];
+			float	totalTime;
+
+			PhysicsFrameStats() {
+				Reset();
+			}
+
+			void Reset() {
+				for (int i = 0; i < NUM_PHYSICS_PHASES; ++i) {
+					phaseTime[i] = 0.0f;
+				}
+				for (int i = 0; i < NUM_PHYSICS_COUNTERS; ++i) {
+					counters[i] = 0;
+				}
+				totalTime = 0.0f;
+			}
+		};
+
+		/*
+		Keeps the last N samples of a value, so we can see the min / avg / max
+		over a window of frames rather than just the latest (noisy) value.
+		*/
+		class RollingStat {
+		public:
+			RollingStat(int windowSize = 120);
+
+			void	AddSample(float value);
+			void	Clear();
+
+			float	GetMin()		const;
+			float	GetMax()		const;
+			float	GetAverage()	const;
+			int		GetSampleCount()const { return count; }
+
+		protected:
+			std::vector<float>	samples;
+			int					next;
+			int					count;
+		};
+
+		class PhysicsStats {
+		public:
+			PhysicsStats(int windowSize = 120);
+			~PhysicsStats();
+
+			void BeginFrame();
+			void EndFrame();
+
+			PhysicsFrameStats& GetCurrentFrame() {
+				return current;
+			}
+
+			const PhysicsFrameStats& GetLastFrame() const {
+				return last;
+			}
+
+			const RollingStat& GetPhaseStat(PhysicsPhase p) const {
+				return phaseStats[(int)p];
+			}
+
+			const RollingStat& GetCounterStat(PhysicsCounter c) const {
+				return counterStats[(int)c];
+			}
+
+			const RollingStat& GetTotalStat() const {
+				return totalStat;
+			}
+
+			void AddPhaseTime(PhysicsPhase p, const Timepoint& start);
+
+			void AddPhaseTime(PhysicsPhase p, float ms) {
+				current.phaseTime[(int)p] += ms;
+			}
+
+			void AddCounter(PhysicsCounter c, int amount = 1) {
+				current.counters[(int)c] += amount;
+			}
+
+			void SetCounter(PhysicsCounter c, int value) {
+				current.counters[(int)c] = value;
+			}
+
+			bool StartDump(const std::string& filename, PhysicsStatsFormat format = PhysicsStatsFormat::CSV);
+			void StopDump();
+
+			bool IsDumping() const {
+				return dumpFile.is_open();
+			}
+
+			void PrintSummary(std::ostream& o) const;
+
+			static Timepoint Now();
+			static float	 MillisecondsSince(const Timepoint& start);
+
+			static const char* GetPhaseName(PhysicsPhase p);
+			static const char* GetCounterName(PhysicsCounter c);
+
+		protected:
+			void WriteFrame();
+
+			PhysicsFrameStats	current;
+			PhysicsFrameStats	last;
+			Timepoint			frameStart;
+			int					frameCount;
+
+			RollingStat			phaseStats[NUM_PHYSICS_PHASES];
+			RollingStat			counterStats[NUM_PHYSICS_COUNTERS];
+			RollingStat			totalStat;
+
+			std::ofstream		dumpFile;
+			PhysicsStatsFormat	dumpFormat;
+		};
+	}
+}
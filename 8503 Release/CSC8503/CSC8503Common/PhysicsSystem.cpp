@@ -4,11 +4,18 @@
 #include "CollisionDetection.h"
 #include "../../Common/Quaternion.h"
 
+#include "../../Common/GameTimer.h"
+
 #include "Constraint.h"
+#include "JobSystem.h"
+#include "WorldSnapshot.h"
 
-#include "Debug.h"
+#include "QuadTree.h"
 
 #include <functional>
+#include <iostream>
+#include <unordered_map>
+#include <cstdint>
 using namespace NCL;
 using namespace CSC8503;
 
@@ -24,6 +31,11 @@ PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
 	useBroadPhase	= false;	
 	dTOffset		= 0.0f;
 	globalDamping	= 0.995f;
+	jobSystem		= nullptr;
+	batchedConstraintVersion = -1;
+	solverMode		= SolverMode::Impulse;
+	constraintIterationCount = 10;
+	SetFixedTimestep(120);
 	SetGravity(Vector3(0.0f, -19.6f, 0.0f));
 }
 
@@ -46,76 +58,165 @@ any collisions they are in.
 */
 void PhysicsSystem::Clear() {
 	allCollisions.clear();
+	collisionEvents.clear();
+	constraintBatches.clear();
+	unbatchedConstraints.clear();
+	directConstraints.clear();
+	batchedObjects.clear();
+	batchedConstraintVersion = -1;
 }
 
-/*
+void PhysicsSystem::Snapshot(WorldSnapshot& snapshot) const {
+	snapshot.GetHeader().physicsTimeOffset = dTOffset;
+	snapshot.SetNumCollisions((int)allCollisions.size());
 
-This is the core of the physics engine update
+	int32_t* idsA		= snapshot.GetCollisionIDsA();
+	int32_t* idsB		= snapshot.GetCollisionIDsB();
+	int32_t* framesLeft = snapshot.GetCollisionFramesLeft();
+	float* values[WorldSnapshot::NUM_COLLISION_VALUES];
+	for (int v = 0; v < WorldSnapshot::NUM_COLLISION_VALUES; ++v) {
+		values[v] = snapshot.GetCollisionValues(v);
+	}
+	int i = 0;
+	for (const CollisionDetection::CollisionInfo& info : allCollisions) {
+		const CollisionDetection::ContactPoint& p = info.point;
+		idsA[i]			= info.a->GetWorldID();
+		idsB[i]			= info.b->GetWorldID();
+		framesLeft[i]	= info.framesLeft;
+		values[WorldSnapshot::LocalAX][i] = p.localA.x;
+		values[WorldSnapshot::LocalAY][i] = p.localA.y;
+		values[WorldSnapshot::LocalAZ][i] = p.localA.z;
+		values[WorldSnapshot::LocalBX][i] = p.localB.x;
+		values[WorldSnapshot::LocalBY][i] = p.localB.y;
+		values[WorldSnapshot::LocalBZ][i] = p.localB.z;
+		values[WorldSnapshot::NormalX][i] = p.normal.x;
+		values[WorldSnapshot::NormalY][i] = p.normal.y;
+		values[WorldSnapshot::NormalZ][i] = p.normal.z;
+		values[WorldSnapshot::Penetration][i] = p.penetration;
+		++i;
+	}
+}
 
+/*
+The pairs were saved in the set's own order, so they can all be put back
+on the end of it without any searching.
 */
-int constraintIterationCount = 10;
+bool PhysicsSystem::Restore(const WorldSnapshot& snapshot) {
+	if (snapshot.IsEmpty()) {
+		return false;
+	}
+	int count = snapshot.GetNumCollisions();
+
+	const int32_t* idsA			= snapshot.GetCollisionIDsA();
+	const int32_t* idsB			= snapshot.GetCollisionIDsB();
+	const int32_t* framesLeft	= snapshot.GetCollisionFramesLeft();
+	const float* values[WorldSnapshot::NUM_COLLISION_VALUES];
+	for (int v = 0; v < WorldSnapshot::NUM_COLLISION_VALUES; ++v) {
+		values[v] = snapshot.GetCollisionValues(v);
+	}
+	for (int i = 0; i < count; ++i) {
+		if (!gameWorld.GetObjectByID(idsA[i]) || !gameWorld.GetObjectByID(idsB[i])) {
+			return false;
+		}
+	}
 
-//This is the fixed timestep we'd LIKE to have
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
+	allCollisions.clear();
+	broadphaseCollisions.clear();
+	collisionEvents.clear();
+	for (int i = 0; i < count; ++i) {
+		CollisionDetection::CollisionInfo info;
+		info.a			= gameWorld.GetObjectByID(idsA[i]);
+		info.b			= gameWorld.GetObjectByID(idsB[i]);
+		info.handleA	= gameWorld.GetHandle(info.a);
+		info.handleB	= gameWorld.GetHandle(info.b);
+		info.framesLeft = framesLeft[i];
+		info.AddContactPoint(
+			Vector3(values[WorldSnapshot::LocalAX][i], values[WorldSnapshot::LocalAY][i], values[WorldSnapshot::LocalAZ][i]),
+			Vector3(values[WorldSnapshot::LocalBX][i], values[WorldSnapshot::LocalBY][i], values[WorldSnapshot::LocalBZ][i]),
+			Vector3(values[WorldSnapshot::NormalX][i], values[WorldSnapshot::NormalY][i], values[WorldSnapshot::NormalZ][i]),
+			values[WorldSnapshot::Penetration][i]);
+		allCollisions.insert(allCollisions.end(), info);
+	}
+	dTOffset = snapshot.GetHeader().physicsTimeOffset;
+	return true;
+}
 
 /*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the 
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate. 
+idealHZ is the fixed timestep we'd LIKE to have, and realHZ is the one
+we actually have... If physics takes too long it starts to kill the
+framerate, it'll drop the iteration count down until the FPS stabilises,
+even if that ends up being at a low rate. 
 */
-int realHZ		= idealHZ;
-float realDT	= idealDT;
+void PhysicsSystem::SetFixedTimestep(int hz) {
+	idealHZ = hz < 1 ? 1 : hz;
+	idealDT = 1.0f / idealHZ;
+	realHZ	= idealHZ;
+	realDT	= idealDT;
+}
 
-void PhysicsSystem::Update(float dt) {	
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
-		constraintIterationCount--;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
+void PhysicsSystem::SetConstraintIterationCount(int count) {
+	constraintIterationCount = count < 1 ? 1 : count;
+}
+
+/*
+When running headless (such as in the benchmark) the timestep should stay
+locked at the ideal rate, so that runs can be compared against each other.
+*/
+void PhysicsSystem::UseAdaptiveTimestep(bool state) {
+	adaptiveTimestep = state;
+	if (!adaptiveTimestep) {
+		realHZ = idealHZ;
+		realDT = idealDT;
 	}
+}
+
+/*
+
+This is the core of the physics engine update
 
+*/
+void PhysicsSystem::Update(float dt) {	
 	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
 
 	GameTimer t;
 	t.GetTimeDeltaSeconds();
 
+	stats.BeginFrame();
+
+	if (gameWorld.GetRemovalVersion() != seenRemovalVersion) {
+		RemoveStaleCollisions();
+		seenRemovalVersion = gameWorld.GetRemovalVersion();
+	}
+
 	if (useBroadPhase) {
 		UpdateObjectAABBs();
 	}
 
+	Timepoint batchStart = PhysicsStats::Now();
+	BuildConstraintBatches();
+	stats.AddPhaseTime(PhysicsPhase::Constraints, batchStart);
+
 	while(dTOffset >= realDT) {
-		IntegrateAccel(realDT); //Update accelerations from external forces
-		if (useBroadPhase) {
-			BroadPhase();
-			NarrowPhase();
+		if (solverMode == SolverMode::XPBD) {
+			StepXPBD(realDT);
 		}
 		else {
-			BasicCollisionDetection();
-		}
-
-		//This is our simple iterative solver - 
-		//we just run things multiple times, slowly moving things forward
-		//and then rechecking that the constraints have been met		
-		float constraintDt = realDT /  (float)constraintIterationCount;
-		for (int i = 0; i < constraintIterationCount; ++i) {
-			UpdateConstraints(constraintDt);	
+			StepImpulse(realDT);
 		}
-		IntegrateVelocity(realDT); //update positions from new velocity changes
-
 		dTOffset -= realDT;
 	}
 
 	ClearForces();	//Once we've finished with the forces, reset them to zero
 
+	Timepoint listStart = PhysicsStats::Now();
 	UpdateCollisionList(); //Remove any old collisions
+	stats.AddPhaseTime(PhysicsPhase::UpdateCollisionList, listStart);
+
+	stats.EndFrame();
+
+	if (!adaptiveTimestep) {
+		return;
+	}
 
 	t.Tick();
 	float updateTime = t.GetTimeDeltaSeconds();
@@ -141,6 +242,132 @@ void PhysicsSystem::Update(float dt) {
 	}
 }
 
+void PhysicsSystem::StepImpulse(float dt) {
+	Timepoint phaseStart = PhysicsStats::Now();
+	UpdateInertiaTensors();
+	IntegrateAccel(dt); //Update accelerations from external forces
+	stats.AddPhaseTime(PhysicsPhase::IntegrateAccel, phaseStart);
+
+	CollisionDetectionPhase();
+
+	//This is our simple iterative solver - 
+	//we just run things multiple times, slowly moving things forward
+	//and then rechecking that the constraints have been met		
+	phaseStart = PhysicsStats::Now();
+	for (Constraint* c : directConstraints) {
+		c->UpdateConstraint(dt);
+	}
+	float constraintDt = dt /  (float)constraintIterationCount;
+	for (int i = 0; i < constraintIterationCount; ++i) {
+		UpdateConstraints(constraintDt);	
+	}
+	stats.AddPhaseTime(PhysicsPhase::Constraints, phaseStart);
+	stats.AddCounter(PhysicsCounter::SolverIterations, constraintIterationCount);
+
+	phaseStart = PhysicsStats::Now();
+	IntegrateVelocity(dt); //update positions from new velocity changes
+	stats.AddPhaseTime(PhysicsPhase::IntegrateVelocity, phaseStart);
+
+	stats.AddCounter(PhysicsCounter::Substeps);
+}
+
+/*
+In XPBD mode, collisions are only found once per step, and the contacts
+handed to the solver - which then does all of its substeps in one go. Any
+constraints the solver doesn't know about are still solved the old way
+afterwards, so nothing just stops working.
+*/
+void PhysicsSystem::StepXPBD(float dt) {
+	Timepoint phaseStart = PhysicsStats::Now();
+	UpdateInertiaTensors();
+	xpbd.LoadBodies(gameWorld);
+	xpbd.LoadConstraints(gameWorld);
+	stats.AddPhaseTime(PhysicsPhase::IntegrateAccel, phaseStart);
+
+	CollisionDetectionPhase();
+
+	xpbd.Solve(dt, applyGravity ? gravity : Vector3(), stats);
+
+	phaseStart = PhysicsStats::Now();
+	xpbd.StoreBodies(dt);
+	stats.AddPhaseTime(PhysicsPhase::IntegrateVelocity, phaseStart);
+
+	phaseStart = PhysicsStats::Now();
+	for (Constraint* c : xpbd.GetUnsupportedConstraints()) {
+		c->UpdateConstraint(dt);
+	}
+	stats.AddPhaseTime(PhysicsPhase::Constraints, phaseStart);
+
+	stats.AddCounter(PhysicsCounter::Substeps, xpbd.GetSubsteps());
+	stats.AddCounter(PhysicsCounter::SolverIterations, xpbd.GetSubsteps());
+}
+
+/*
+Contacts are resolved as soon as they're found, so the time spent
+in the solver is taken back out of the collision detection time
+*/
+void PhysicsSystem::CollisionDetectionPhase() {
+	float solverTime = stats.GetCurrentFrame().phaseTime[(int)PhysicsPhase::Solver];
+	if (useBroadPhase) {
+		Timepoint phaseStart = PhysicsStats::Now();
+		BroadPhase();
+		stats.AddPhaseTime(PhysicsPhase::BroadPhase, phaseStart);
+
+		phaseStart = PhysicsStats::Now();
+		NarrowPhase();
+		stats.AddPhaseTime(PhysicsPhase::NarrowPhase, phaseStart);
+	}
+	else {
+		Timepoint phaseStart = PhysicsStats::Now();
+		BasicCollisionDetection();
+		stats.AddPhaseTime(PhysicsPhase::NarrowPhase, phaseStart);
+	}
+	solverTime = stats.GetCurrentFrame().phaseTime[(int)PhysicsPhase::Solver] - solverTime;
+	stats.AddPhaseTime(PhysicsPhase::NarrowPhase, -solverTime);
+}
+
+void PhysicsSystem::ResolveContact(CollisionDetection::CollisionInfo& info) {
+	Timepoint solverStart = PhysicsStats::Now();
+	if (solverMode == SolverMode::XPBD) {
+		xpbd.AddContact(info);
+	}
+	else {
+		ImpulseResolveCollision(*info.a, *info.b, info.point);
+	}
+	stats.AddPhaseTime(PhysicsPhase::Solver, solverStart);
+	info.framesLeft = numCollisionFrames;
+	info.handleA	= gameWorld.GetHandle(info.a);
+	info.handleB	= gameWorld.GetHandle(info.b);
+	allCollisions.insert(info);
+}
+
+/*
+Any pair with an object that's no longer in the world has to go - the
+object that's left behind is told the collision has ended, but the one
+that's gone can't be, as it might well have been deleted. Only runs when
+something has actually been removed, so it costs nothing most frames.
+*/
+void PhysicsSystem::RemoveStaleCollisions() {
+	for (auto i = allCollisions.begin(); i != allCollisions.end(); ) {
+		bool validA = gameWorld.IsValid(i->handleA);
+		bool validB = gameWorld.IsValid(i->handleB);
+		if (validA && validB) {
+			++i;
+			continue;
+		}
+		if (!deferCollisionEvents && i->framesLeft != numCollisionFrames) {
+			if (validA) {
+				i->a->OnCollisionEnd(nullptr);
+			}
+			else if (validB) {
+				i->b->OnCollisionEnd(nullptr);
+			}
+		}
+		i = allCollisions.erase(i);
+	}
+	broadphaseCollisions.clear();
+}
+
 /*
 Later on we're going to need to keep track of collisions
 across multiple frames, so we store them in a set.
@@ -155,13 +382,23 @@ rocket launcher, gaining a point when the player hits the gold coin, and so on).
 void PhysicsSystem::UpdateCollisionList() {
 	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
 		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+			if (deferCollisionEvents) {
+				collisionEvents.push_back({ i->a, i->b, true });
+			}
+			else {
+				i->a->OnCollisionBegin(i->b);
+				i->b->OnCollisionBegin(i->a);
+			}
 		}
 		(*i).framesLeft = (*i).framesLeft - 1;
 		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
+			if (deferCollisionEvents) {
+				collisionEvents.push_back({ i->a, i->b, false });
+			}
+			else {
+				i->a->OnCollisionEnd(i->b);
+				i->b->OnCollisionEnd(i->a);
+			}
 			i = allCollisions.erase(i);
 		}
 		else {
@@ -171,9 +408,13 @@ void PhysicsSystem::UpdateCollisionList() {
 }
 
 void PhysicsSystem::UpdateObjectAABBs() {
-	gameWorld.OperateOnContents(
-		[](GameObject* g) {
-			g->UpdateBroadphaseAABB();
+	gameWorld.GetEntities().ForEachChunk(ComponentBit(ComponentType::Transform) | ComponentBit(ComponentType::Collider),
+		[](ArchetypeChunk& chunk) {
+			const Transform* transforms		= chunk.Get<Transform>();
+			ColliderComponent* colliders	= chunk.Get<ColliderComponent>();
+			for (int i = 0; i < chunk.GetCount(); ++i) {
+				colliders[i].UpdateBroadphaseAABB(transforms[i].GetOrientation());
+			}
 		}
 	);
 }
@@ -192,19 +433,24 @@ void PhysicsSystem::BasicCollisionDetection() {
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
 
+	int pairs		= 0;
+	int contacts	= 0;
+
 	for (auto i = first; i != last; i++) {
 		if ((*i)->GetPhysicsObject() == nullptr) continue;
 		
 		CollisionDetection::CollisionInfo info;
 
 		for (auto j = i + 1; j != last; j++) {
+			pairs++;
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
-				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+				contacts++;
+				ResolveContact(info);
 			}
 		}
 	}
+	stats.AddCounter(PhysicsCounter::CandidatePairs, pairs);
+	stats.AddCounter(PhysicsCounter::Contacts, contacts);
 }
 
 /*
@@ -271,7 +517,72 @@ compare the collisions that we absolutely need to.
 */
 
 void PhysicsSystem::BroadPhase() {
+	broadphaseCollisions.clear();
 
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	//The tree needs to cover the whole world, so size it to fit whatever
+	//is in the world this frame. It's kept square, as a long thin tree
+	//would keep splitting objects that lie along its long axis!
+	float worldSize = 1.0f;
+	int numObjects	= 0;
+	for (auto i = first; i != last; ++i) {
+		Vector3 halfSizes;
+		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		Vector3 pos = (*i)->GetTransform().GetPosition();
+		float extentX = std::abs(pos.x) + halfSizes.x;
+		float extentZ = std::abs(pos.z) + halfSizes.z;
+		if (extentX > worldSize) {
+			worldSize = extentX;
+		}
+		if (extentZ > worldSize) {
+			worldSize = extentZ;
+		}
+		numObjects++;
+	}
+
+	//Allow the tree to get deep enough that, if things are spread out
+	//evenly, the leaves still only end up with a handful of objects each
+	const int maxLeafSize = 6;
+	int maxDepth = 7;
+	while ((1 << (2 * maxDepth)) * maxLeafSize < numObjects && maxDepth < 12) {
+		maxDepth++;
+	}
+
+	QuadTree<GameObject*> tree(Vector2(worldSize, worldSize), maxDepth, maxLeafSize);
+	for (auto i = first; i != last; ++i) {
+		Vector3 halfSizes;
+		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		Vector3 pos = (*i)->GetTransform().GetPosition();
+		tree.Insert(*i, pos, halfSizes);
+	}
+
+	tree.OperateOnContents(
+		[&](std::list<QuadTreeEntry<GameObject*>>& data) {
+			CollisionDetection::CollisionInfo info;
+			for (auto i = data.begin(); i != data.end(); ++i) {
+				for (auto j = std::next(i); j != data.end(); ++j) {
+					//is this pair of items already in the collision set -
+					//if the same pair is in another quadtree node together etc
+					info.a = (*i).object;
+					info.b = (*j).object;
+					if (info.a->GetWorldID() > info.b->GetWorldID()) {
+						std::swap(info.a, info.b);
+					}
+					info.handleA = gameWorld.GetHandle(info.a);
+					info.handleB = gameWorld.GetHandle(info.b);
+					broadphaseCollisions.insert(info);
+				}
+			}
+		}
+	);
+	stats.AddCounter(PhysicsCounter::CandidatePairs, (int)broadphaseCollisions.size());
 }
 
 /*
@@ -280,7 +591,18 @@ The broadphase will now only give us likely collisions, so we can now go through
 and work out if they are truly colliding, and if so, add them into the main collision list
 */
 void PhysicsSystem::NarrowPhase() {
-
+	int contacts = 0;
+	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
+		CollisionDetection::CollisionInfo info = *i;
+		if (!info.a->GetPhysicsObject() || !info.b->GetPhysicsObject()) {
+			continue;
+		}
+		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
+			contacts++;
+			ResolveContact(info);
+		}
+	}
+	stats.AddCounter(PhysicsCounter::Contacts, contacts);
 }
 
 /*
@@ -291,36 +613,105 @@ without worrying about repeated forces accumulating etc.
 This function will update both linear and angular acceleration,
 based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
+
+Like the other integration steps, this only needs the rigid bodies, so
+it walks through them chunk by chunk rather than object by object.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetEntities().ForEachChunk(ComponentBit(ComponentType::RigidBody),
+		[&](ArchetypeChunk& chunk) {
+			PhysicsObject* bodies = chunk.Get<PhysicsObject>();
+			for (int i = 0; i < chunk.GetCount(); ++i) {
+				PhysicsObject* obj = &bodies[i];
+				float inverseMass = obj->GetInverseMass();
 
-	for (auto i = first; i != last; i++) {
-		PhysicsObject* obj = (*i)->GetPhysicsObject();
-		if (obj == nullptr) continue;
-		float inverseMass = obj->GetInverseMass();
+				Vector3 linearVel = obj->GetLinearVelocity() * obj->GetFriction();
+				Vector3 force = obj->GetForce();
+				Vector3 accel = force * inverseMass;
 
-		Vector3 linearVel = obj->GetLinearVelocity() * obj->GetFriction();
-		Vector3 force = obj->GetForce();
-		Vector3 accel = force * inverseMass;
+				if (applyGravity && inverseMass > 0) accel += gravity;
+				linearVel += accel * dt;
+				obj->SetLinearVelocity(linearVel);
 
-		if (applyGravity && inverseMass > 0) accel += gravity;
-		linearVel += accel * dt;
-		obj->SetLinearVelocity(linearVel);
+				Vector3 torque = obj->GetTorque();
+				Vector3 angVel = obj->GetAngularVelocity();
 
-		Vector3 torque = obj->GetTorque();
-		Vector3 angVel = obj->GetAngularVelocity();
+				Vector3 angAccel = obj->GetInertiaTensor() * torque * obj->GetFriction();
 
-		obj->UpdateInertiaTensor();
+				angVel += angAccel * dt;
+				obj->SetAngularVelocity(angVel);
+			}
+		}
+	);
+}
+/*
+Only objects that have turned since last time need their world space
+inertia tensors redoing - and objects with the same inertia on every axis
+don't even need that, so they're handled by the object itself. Everything
+else gets copied out into arrays, so that the maths can all be done in one
+tight loop, and then the results are handed back.
 
-		Vector3 angAccel = obj->GetInertiaTensor() * torque * obj->GetFriction();
+The tensor is symmetric, so only 6 of its 9 elements are worked out.
+*/
+void PhysicsSystem::UpdateInertiaTensors() {
+	inertiaObjects.clear();
+	inertiaQX.clear();	inertiaQY.clear();	inertiaQZ.clear();	inertiaQW.clear();
+	inertiaX.clear();	inertiaY.clear();	inertiaZ.clear();
+
+	gameWorld.GetEntities().ForEachChunk(ComponentBit(ComponentType::Transform) | ComponentBit(ComponentType::RigidBody),
+		[&](ArchetypeChunk& chunk) {
+			const Transform* transforms = chunk.Get<Transform>();
+			PhysicsObject* bodies		= chunk.Get<PhysicsObject>();
+			for (int i = 0; i < chunk.GetCount(); ++i) {
+				PhysicsObject* obj = &bodies[i];
+				if (!obj->InertiaNeedsUpdate()) {
+					continue;
+				}
+				if (obj->IsInertiaIsotropic()) {
+					obj->UpdateInertiaTensor();
+					continue;
+				}
+				Quaternion q	= transforms[i].GetOrientation();
+				Vector3 inertia = obj->GetLocalInverseInertia();
+				inertiaObjects.push_back(obj);
+				inertiaQX.push_back(q.x);	inertiaQY.push_back(q.y);	inertiaQZ.push_back(q.z);	inertiaQW.push_back(q.w);
+				inertiaX.push_back(inertia.x);	inertiaY.push_back(inertia.y);	inertiaZ.push_back(inertia.z);
+			}
+		}
+	);
+
+	int count = (int)inertiaObjects.size();
+	inertiaTensors.resize(count * 6);
+
+	for (int i = 0; i < count; ++i) {
+		float x = inertiaQX[i], y = inertiaQY[i], z = inertiaQZ[i], w = inertiaQW[i];
+
+		//The columns of the rotation matrix, as in Matrix3(Quaternion)
+		float r00 = 1 - 2 * y * y - 2 * z * z, r10 = 2 * x * y + 2 * z * w, r20 = 2 * x * z - 2 * y * w;
+		float r01 = 2 * x * y - 2 * z * w, r11 = 1 - 2 * x * x - 2 * z * z, r21 = 2 * y * z + 2 * x * w;
+		float r02 = 2 * x * z + 2 * y * w, r12 = 2 * y * z - 2 * x * w, r22 = 1 - 2 * x * x - 2 * y * y;
+
+		float ix = inertiaX[i], iy = inertiaY[i], iz = inertiaZ[i];
+		float* out = &inertiaTensors[i * 6];
+
+		out[0] = r00 * ix * r00 + r01 * iy * r01 + r02 * iz * r02;	//xx
+		out[1] = r10 * ix * r10 + r11 * iy * r11 + r12 * iz * r12;	//yy
+		out[2] = r20 * ix * r20 + r21 * iy * r21 + r22 * iz * r22;	//zz
+		out[3] = r00 * ix * r10 + r01 * iy * r11 + r02 * iz * r12;	//xy
+		out[4] = r00 * ix * r20 + r01 * iy * r21 + r02 * iz * r22;	//xz
+		out[5] = r10 * ix * r20 + r11 * iy * r21 + r12 * iz * r22;	//yz
+	}
 
-		angVel += angAccel * dt;
-		obj->SetAngularVelocity(angVel);
+	for (int i = 0; i < count; ++i) {
+		const float* t = &inertiaTensors[i * 6];
+		Matrix3 tensor;
+		tensor.array[0] = t[0];	tensor.array[3] = t[3];	tensor.array[6] = t[4];
+		tensor.array[1] = t[3];	tensor.array[4] = t[1];	tensor.array[7] = t[5];
+		tensor.array[2] = t[4];	tensor.array[5] = t[5];	tensor.array[8] = t[2];
+		inertiaObjects[i]->SetInertiaTensor(tensor, Quaternion(inertiaQX[i], inertiaQY[i], inertiaQZ[i], inertiaQW[i]));
 	}
 }
+
 /*
 This function integrates linear and angular velocity into
 position and orientation. It may be called multiple times
@@ -328,53 +719,75 @@ throughout a physics update, to slowly move the objects through
 the world, looking for collisions.
 */
 void PhysicsSystem::IntegrateVelocity(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetEntities().ForEachChunk(ComponentBit(ComponentType::Transform) | ComponentBit(ComponentType::RigidBody),
+		[&](ArchetypeChunk& chunk) {
+			Transform* transforms	= chunk.Get<Transform>();
+			PhysicsObject* bodies	= chunk.Get<PhysicsObject>();
 
-	float linearDamping;
-	float angularDamping;
+			float linearDamping;
+			float angularDamping;
 
-	for (auto i = first; i != last; i++) {
-		PhysicsObject* obj = (*i)->GetPhysicsObject();
-		if (obj == nullptr) continue;
-		linearDamping = 1.0f - (obj->GetFriction() * dt);
-		angularDamping = 1.0f - (obj->GetFriction() * dt);
-		Transform& transform = (*i)->GetTransform();
+			for (int i = 0; i < chunk.GetCount(); ++i) {
+				PhysicsObject* obj = &bodies[i];
+				linearDamping = 1.0f - (obj->GetFriction() * dt);
+				angularDamping = 1.0f - (obj->GetFriction() * dt);
+				Transform& transform = transforms[i];
 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = obj->GetLinearVelocity();
-		position += linearVel * dt;
+				Vector3 position = transform.GetPosition();
+				Vector3 linearVel = obj->GetLinearVelocity();
+				position += linearVel * dt;
 
-		transform.SetPosition(position);
+				transform.SetPosition(position);
 
-		linearVel = linearVel * linearDamping;
-		obj->SetLinearVelocity(linearVel);
-		
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = obj->GetAngularVelocity();
+				linearVel = linearVel * linearDamping;
+				obj->SetLinearVelocity(linearVel);
 
-		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+				Quaternion orientation = transform.GetOrientation();
+				Vector3 angVel = obj->GetAngularVelocity();
 
-		transform.SetOrientation(orientation);
+				orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
+				orientation.Normalise();
 
-		angVel = angVel * angularDamping;
-		obj->SetAngularVelocity(angVel);
-	}
+				transform.SetOrientation(orientation);
+
+				angVel = angVel * angularDamping;
+				obj->SetAngularVelocity(angVel);
+			}
+		}
+	);
 }
 
 /*
 Once we're finished with a physics update, we have to
 clear out any accumulated forces, ready to receive new
 ones in the next 'game' frame.
+
+As this touches every body once per frame, it's also where
+we count up the bodies for the stats. There's no sleeping yet,
+so a body counts as 'awake' if it is dynamic and still moving.
 */
 void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnContents(
-		[](GameObject* o) {
-			o->GetPhysicsObject()->ClearForces();
+	const float awakeSpeedSquared = 0.01f * 0.01f;
+
+	int bodies	= 0;
+	int awake	= 0;
+	gameWorld.GetEntities().ForEachChunk(ComponentBit(ComponentType::RigidBody),
+		[&](ArchetypeChunk& chunk) {
+			PhysicsObject* physBodies = chunk.Get<PhysicsObject>();
+			for (int i = 0; i < chunk.GetCount(); ++i) {
+				PhysicsObject* phys = &physBodies[i];
+				phys->ClearForces();
+				bodies++;
+				if (phys->GetInverseMass() > 0.0f &&
+					(phys->GetLinearVelocity().LengthSquared() > awakeSpeedSquared ||
+					 phys->GetAngularVelocity().LengthSquared() > awakeSpeedSquared)) {
+					awake++;
+				}
+			}
 		}
 	);
+	stats.SetCounter(PhysicsCounter::Bodies, bodies);
+	stats.SetCounter(PhysicsCounter::AwakeBodies, awake);
 }
 
 
@@ -386,11 +799,118 @@ us to model springs and ropes etc.
 
 */
 void PhysicsSystem::UpdateConstraints(float dt) {
+	const int minBatchSize = 64;
+
+	for (std::vector<Constraint*>& batch : constraintBatches) {
+		if (jobSystem && (int)batch.size() > minBatchSize) {
+			jobSystem->ParallelFor((int)batch.size(), minBatchSize,
+				[&](int start, int end) {
+					for (int i = start; i < end; ++i) {
+						batch[i]->UpdateConstraint(dt);
+					}
+				}
+			);
+		}
+		else {
+			for (Constraint* c : batch) {
+				c->UpdateConstraint(dt);
+			}
+		}
+	}
+	for (Constraint* c : unbatchedConstraints) {
+		c->UpdateConstraint(dt);
+	}
+}
+
+/*
+To solve constraints in parallel, we need to make sure that no two
+constraints being solved at the same time touch the same object. We 'colour'
+the constraints greedily, in the order they are in the world - each one
+gets the lowest colour that none of its objects have used yet. Every colour
+then becomes a batch that can be solved all at once, and the batches are
+always solved in the same order, so the results don't depend on how many
+threads we have. A chain of constraints only needs 2 colours!
+
+Fixed objects are never changed by a constraint, so they don't stop two
+constraints sharing a colour. The batches are only rebuilt if the world's
+constraints have changed since last time, or if one of the objects in
+them has been fixed or freed (by SetInverseMass, which snapshot restores
+use too).
+
+Direct constraints (like ChainConstraint) are kept to one side, as they
+are solved exactly, once per step, before the iterative ones.
+*/
+void PhysicsSystem::BuildConstraintBatches() {
+	if (batchedConstraintVersion == gameWorld.GetConstraintVersion() && !BatchedMassChanged()) {
+		stats.SetCounter(PhysicsCounter::ConstraintColours, (int)constraintBatches.size());
+		return;
+	}
+	batchedConstraintVersion = gameWorld.GetConstraintVersion();
+
 	std::vector<Constraint*>::const_iterator first;
 	std::vector<Constraint*>::const_iterator last;
 	gameWorld.GetConstraintIterators(first, last);
 
+	constraintBatches.clear();
+	unbatchedConstraints.clear();
+	directConstraints.clear();
+	batchedObjects.clear();
+
+	const int maxColours = 64;
+	std::unordered_map<GameObject*, uint64_t> usedColours;
+	std::vector<GameObject*> objects;
+
 	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateConstraint(dt);
+		Constraint* c = *i;
+		if (c->IsDirect()) {
+			directConstraints.push_back(c);
+			continue;
+		}
+		objects.clear();
+		if (!c->GetObjects(objects)) {
+			unbatchedConstraints.push_back(c);
+			continue;
+		}
+		uint64_t used = 0;
+		for (GameObject* o : objects) {
+			PhysicsObject* phys = o->GetPhysicsObject();
+			if (phys) {
+				phys->ClearMassDirty();
+				batchedObjects.push_back(o);
+			}
+			if (phys && phys->GetInverseMass() > 0.0f) {
+				used |= usedColours[o];
+			}
+		}
+		int colour = 0;
+		while (colour < maxColours && (used & (1ull << colour))) {
+			colour++;
+		}
+		if (colour == maxColours) {
+			unbatchedConstraints.push_back(c);
+			continue;
+		}
+		for (GameObject* o : objects) {
+			PhysicsObject* phys = o->GetPhysicsObject();
+			if (phys && phys->GetInverseMass() > 0.0f) {
+				usedColours[o] |= (1ull << colour);
+			}
+		}
+		if (colour >= (int)constraintBatches.size()) {
+			constraintBatches.resize(colour + 1);
+		}
+		constraintBatches[colour].push_back(c);
 	}
-}
\ No newline at end of file
+	stats.SetCounter(PhysicsCounter::ConstraintColours, (int)constraintBatches.size());
+}
+
+//The constraints haven't changed, so everything in batchedObjects is still about
+bool PhysicsSystem::BatchedMassChanged() const {
+	for (GameObject* o : batchedObjects) {
+		PhysicsObject* phys = o->GetPhysicsObject();
+		if (phys && phys->IsMassDirty()) {
+			return true;
+		}
+	}
+	return false;
+}
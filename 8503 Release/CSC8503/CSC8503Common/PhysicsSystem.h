@@ -1,9 +1,34 @@
 #pragma once
 #include "../CSC8503Common/GameWorld.h"
+#include "PhysicsStats.h"
+#include "XPBDSolver.h"
 #include <set>
+#include <vector>
 
 namespace NCL {
 	namespace CSC8503 {
+		class Constraint;
+		class JobSystem;
+		class PhysicsObject;
+		class WorldSnapshot;
+
+		/*
+		Impulse is the original solver, which pushes velocities apart and
+		iterates the constraints. XPBD solves positions directly, over a
+		number of substeps - see XPBDSolver.
+		*/
+		enum class SolverMode {
+			Impulse,
+			XPBD
+		};
+
+		//A pair of objects starting or stopping touching
+		struct CollisionEvent {
+			GameObject* a;
+			GameObject* b;
+			bool		began;
+		};
+
 		class PhysicsSystem	{
 		public:
 			PhysicsSystem(GameWorld& g);
@@ -13,6 +38,14 @@ namespace NCL {
 
 			void Update(float dt);
 
+			/*
+			Adds the collision pairs being tracked (and how long until each
+			one ends), plus any leftover time, on to a snapshot. The world's
+			own Snapshot / Restore must be called first.
+			*/
+			void Snapshot(WorldSnapshot& snapshot) const;
+			bool Restore(const WorldSnapshot& snapshot);
+
 			void UseGravity(bool state) {
 				applyGravity = state;
 			}
@@ -22,6 +55,67 @@ namespace NCL {
 			}
 
 			void SetGravity(const Vector3& g);
+
+			void UseBroadPhase(bool state) {
+				useBroadPhase = state;
+			}
+
+			bool IsUsingBroadPhase() const {
+				return useBroadPhase;
+			}
+
+			void UseAdaptiveTimestep(bool state);
+
+			void SetFixedTimestep(int hz);
+
+			int GetFixedTimestep() const {
+				return idealHZ;
+			}
+
+			void SetConstraintIterationCount(int count);
+
+			int GetConstraintIterationCount() const {
+				return constraintIterationCount;
+			}
+
+			/*
+			Normally OnCollisionBegin / OnCollisionEnd are called as soon as
+			physics spots them. When deferred, they're stored up instead, so
+			that whoever owns the objects can call them when it's safe to.
+			*/
+			void DeferCollisionEvents(bool state) {
+				deferCollisionEvents = state;
+			}
+
+			std::vector<CollisionEvent>& GetCollisionEvents() {
+				return collisionEvents;
+			}
+
+			void SetSolverMode(SolverMode mode) {
+				solverMode = mode;
+			}
+
+			SolverMode GetSolverMode() const {
+				return solverMode;
+			}
+
+			XPBDSolver& GetXPBDSolver() {
+				return xpbd;
+			}
+
+			//Constraint batches are spread across the job system's threads,
+			//or solved one after the other if there isn't one
+			void SetJobSystem(JobSystem* jobs) {
+				jobSystem = jobs;
+			}
+
+			const PhysicsStats& GetStats() const {
+				return stats;
+			}
+
+			PhysicsStats& GetStats() {
+				return stats;
+			}
 		protected:
 			void BasicCollisionDetection();
 			void BroadPhase();
@@ -30,13 +124,22 @@ namespace NCL {
 			void ClearForces();
 
 			void IntegrateAccel(float dt);
+			void UpdateInertiaTensors();
 			void IntegrateVelocity(float dt);
 
 			void UpdateConstraints(float dt);
+			void BuildConstraintBatches();
+			bool BatchedMassChanged() const;
 
 			void UpdateCollisionList();
+			void RemoveStaleCollisions();
 			void UpdateObjectAABBs();
 
+			void StepImpulse(float dt);
+			void StepXPBD(float dt);
+			void CollisionDetectionPhase();
+			void ResolveContact(CollisionDetection::CollisionInfo& info);
+
 			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
 
 			GameWorld& gameWorld;
@@ -47,9 +150,40 @@ namespace NCL {
 			float	globalDamping;
 
 			std::set<CollisionDetection::CollisionInfo> allCollisions;
+			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
 
 			bool useBroadPhase		= true;
+			bool adaptiveTimestep	= true;
+			bool deferCollisionEvents = false;
+
+			std::vector<CollisionEvent> collisionEvents;
 			int numCollisionFrames	= 1;
+			int seenRemovalVersion	= 0;
+
+			int		constraintIterationCount;
+			int		idealHZ;
+			float	idealDT;
+			int		realHZ;
+			float	realDT;
+
+			PhysicsStats stats;
+
+			JobSystem* jobSystem;
+
+			int										batchedConstraintVersion;
+			std::vector<std::vector<Constraint*>>	constraintBatches;
+			std::vector<Constraint*>				unbatchedConstraints;
+			std::vector<Constraint*>				directConstraints;
+			std::vector<GameObject*>				batchedObjects;	//watched for mass changes
+
+			//Scratch space for UpdateInertiaTensors
+			std::vector<PhysicsObject*>	inertiaObjects;
+			std::vector<float>			inertiaQX, inertiaQY, inertiaQZ, inertiaQW;
+			std::vector<float>			inertiaX, inertiaY, inertiaZ;
+			std::vector<float>			inertiaTensors;
+
+			SolverMode	solverMode;
+			XPBDSolver	xpbd;
 		};
 	}
 }
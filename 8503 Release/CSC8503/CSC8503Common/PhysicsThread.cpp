@@ -0,0 +1,200 @@
+#include "PhysicsThread.h"
+#include "GameObject.h"
+#include "GameWorld.h"
+#include <chrono>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const int FRONT_BUFFER	= 1;
+const int READING		= 2;
+const int CONSUMED		= 4;
+
+PhysicsThread::PhysicsThread(PhysicsSystem& p, GameWorld& w, int hz) : physics(p), world(w) {
+	timestep		= 1.0f / (float)hz;
+	running			= false;
+	snapshotState	= CONSUMED;
+	stepCount		= 0;
+}
+
+PhysicsThread::~PhysicsThread() {
+	Stop();
+}
+
+/*
+Every physics object gets pointed at the command queue, so game code
+doesn't need to know which thread physics is on.
+*/
+void PhysicsThread::Start() {
+	if (running) {
+		return;
+	}
+	world.OperateOnContents(
+		[&](GameObject* o) {
+			if (o->GetPhysicsObject()) {
+				o->GetPhysicsObject()->SetCommandQueue(&commands);
+			}
+		}
+	);
+	physics.UseAdaptiveTimestep(false);
+	physics.DeferCollisionEvents(true);
+
+	snapshots[0] = PhysicsSnapshot();
+	snapshots[1] = PhysicsSnapshot();
+	snapshotState	= CONSUMED;
+	stepCount		= 0;
+	PublishSnapshot(); //so there's something to read straight away
+
+	running = true;
+	thread	= std::thread(&PhysicsThread::ThreadLoop, this);
+}
+
+/*
+Once the thread has stopped, anything still in the queue is run, and the
+objects go back to being updated directly.
+*/
+void PhysicsThread::Stop() {
+	if (!running) {
+		return;
+	}
+	running = false;
+	thread.join();
+
+	ExecuteCommands();
+
+	world.OperateOnContents(
+		[&](GameObject* o) {
+			if (o->GetPhysicsObject()) {
+				o->GetPhysicsObject()->SetCommandQueue(nullptr);
+			}
+			o->ClearPublishedState();
+			if (o->GetRenderObject()) {
+				o->GetRenderObject()->ClearModelMatrix();
+			}
+		}
+	);
+	for (CollisionEvent& e : physics.GetCollisionEvents()) {
+		if (e.began) {
+			e.a->OnCollisionBegin(e.b);
+			e.b->OnCollisionBegin(e.a);
+		}
+		else {
+			e.a->OnCollisionEnd(e.b);
+			e.b->OnCollisionEnd(e.a);
+		}
+	}
+	physics.GetCollisionEvents().clear();
+	physics.DeferCollisionEvents(false);
+	physics.UseAdaptiveTimestep(true);
+}
+
+/*
+The world isn't updated from here - shuffling its object list would pull
+it out from under the renderer - so shuffling just pauses while physics
+is threaded.
+
+Steps are run at a fixed rate - if a step takes too long, we just fall
+behind and start the next one straight away, rather than trying to catch up.
+*/
+void PhysicsThread::ThreadLoop() {
+	std::chrono::duration<float> step(timestep);
+	auto nextStep = std::chrono::steady_clock::now();
+
+	while (running) {
+		ExecuteCommands();
+		physics.Update(timestep);
+		stepCount++;
+		PublishSnapshot();
+
+		nextStep += std::chrono::duration_cast<std::chrono::steady_clock::duration>(step);
+		auto now = std::chrono::steady_clock::now();
+		if (nextStep < now) {
+			nextStep = now;
+		}
+		std::this_thread::sleep_until(nextStep);
+	}
+}
+
+void PhysicsThread::ExecuteCommands() {
+	PhysicsCommand c;
+	while (commands.Pop(c)) {
+		if (c.type == PhysicsCommandType::DisableCollisions) {
+			c.object->SetCollisionsEnabled(false);
+		}
+		else if (c.object && c.object->GetPhysicsObject()) {
+			c.object->GetPhysicsObject()->ExecuteCommand(c);
+		}
+	}
+}
+
+/*
+The back buffer always gets the latest positions, and has any new
+collisions added on to the end of its list. It only becomes the front
+buffer if the game isn't reading the current one, and has already seen
+it - otherwise the collisions in it would be lost.
+*/
+void PhysicsThread::PublishSnapshot() {
+	int state = snapshotState.load(std::memory_order_acquire);
+	PhysicsSnapshot& back = snapshots[1 - (state & FRONT_BUFFER)];
+
+	back.objects.clear();
+	world.OperateOnContents(
+		[&](GameObject* o) {
+			PhysicsObject* phys = o->GetPhysicsObject();
+			back.objects.push_back({ o, o->GetTransform().GetPosition(), o->GetTransform().GetOrientation(),
+				phys ? phys->GetLinearVelocity() : Vector3() });
+		}
+	);
+	std::vector<CollisionEvent>& events = physics.GetCollisionEvents();
+	back.collisionEvents.insert(back.collisionEvents.end(), events.begin(), events.end());
+	events.clear();
+	back.step = stepCount;
+
+	if ((state & READING) || !(state & CONSUMED)) {
+		return;
+	}
+	//The game might have just started reading - if so, try again next step
+	int swapped = (state ^ FRONT_BUFFER) & ~CONSUMED;
+	if (snapshotState.compare_exchange_strong(state, swapped, std::memory_order_acq_rel)) {
+		snapshots[1 - (swapped & FRONT_BUFFER)].collisionEvents.clear();
+	}
+}
+
+const PhysicsSnapshot& PhysicsThread::AcquireSnapshot() {
+	int state = snapshotState.load(std::memory_order_acquire);
+	while (!snapshotState.compare_exchange_weak(state, state | READING, std::memory_order_acq_rel)) {
+	}
+	return snapshots[state & FRONT_BUFFER];
+}
+
+void PhysicsThread::ReleaseSnapshot() {
+	snapshotState.fetch_or(CONSUMED, std::memory_order_acq_rel);
+	snapshotState.fetch_and(~READING, std::memory_order_acq_rel);
+}
+
+int PhysicsThread::ApplySnapshot() {
+	const PhysicsSnapshot& snapshot = AcquireSnapshot();
+
+	for (const PhysicsObjectState& s : snapshot.objects) {
+		s.object->SetPublishedState(s.position, s.orientation, s.linearVelocity);
+		if (RenderObject* r = s.object->GetRenderObject()) {
+			r->SetModelMatrix(Matrix4::Translation(s.position) * Matrix4(s.orientation) * Matrix4::Scale(s.object->GetTransform().GetScale()));
+		}
+	}
+	bool alreadySeen = (snapshotState.load(std::memory_order_acquire) & CONSUMED) != 0;
+	if (!alreadySeen) {
+		for (const CollisionEvent& e : snapshot.collisionEvents) {
+			if (e.began) {
+				e.a->OnCollisionBegin(e.b);
+				e.b->OnCollisionBegin(e.a);
+			}
+			else {
+				e.a->OnCollisionEnd(e.b);
+				e.b->OnCollisionEnd(e.a);
+			}
+		}
+	}
+	int step = snapshot.step;
+	ReleaseSnapshot();
+	return step;
+}
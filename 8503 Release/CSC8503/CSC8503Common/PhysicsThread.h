@@ -0,0 +1,106 @@
+#pragma once
+#include "PhysicsCommandQueue.h"
+#include "PhysicsSystem.h"
+#include "../../Common/Vector3.h"
+#include "../../Common/Quaternion.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class GameWorld;
+
+		struct PhysicsObjectState {
+			GameObject* object;
+			Vector3		position;
+			Quaternion	orientation;
+			Vector3		linearVelocity;
+		};
+
+		/*
+		Everything the game gets to see of the physics world - where every
+		object was at the end of a step, and every collision that started or
+		stopped since the game last looked.
+		*/
+		struct PhysicsSnapshot {
+			std::vector<PhysicsObjectState>	objects;
+			std::vector<CollisionEvent>		collisionEvents;
+			int								step = 0;
+		};
+
+		/*
+		Runs a PhysicsSystem on its own thread, at its own fixed rate, so that
+		the game can get on with rendering and AI while physics is stepping.
+
+		While it's running, the physics thread owns the world's transforms and
+		physics objects. The game talks to it through a command queue (which
+		PhysicsObject::AddForce and friends use automatically), and reads back
+		a double buffered snapshot - the physics thread fills in one buffer
+		while the game reads the other, and they only swap over once the game
+		has finished with the one it has.
+
+		Objects and constraints must not be added to or removed from the world
+		while the thread is running, and objects mustn't have their components
+		changed, as either can move objects' data about under the physics
+		thread - Stop it first. The snapshots hold on to the GameObjects
+		themselves, which stay put.
+		*/
+		class PhysicsThread {
+		public:
+			PhysicsThread(PhysicsSystem& physics, GameWorld& world, int hz = 120);
+			~PhysicsThread();
+
+			void Start();
+			void Stop();
+
+			bool IsRunning() const {
+				return running;
+			}
+
+			PhysicsCommandQueue& GetCommandQueue() {
+				return commands;
+			}
+
+			/*
+			Called on the game thread, once per frame. Copies the latest
+			snapshot into the objects' published state and render matrices,
+			and calls the collision callbacks for everything that happened
+			since last time. Returns the physics step it came from.
+
+			Physics keeps stepping while the callbacks run, so they must
+			only change physics state through the command queue (see
+			GameObject::OnCollisionBegin).
+			*/
+			int ApplySnapshot();
+
+		protected:
+			void ThreadLoop();
+			void ExecuteCommands();
+			void PublishSnapshot();
+
+			const PhysicsSnapshot&	AcquireSnapshot();
+			void					ReleaseSnapshot();
+
+			PhysicsSystem&			physics;
+			GameWorld&				world;
+			float					timestep;
+
+			std::thread				thread;
+			std::atomic<bool>		running;
+
+			PhysicsCommandQueue		commands;
+
+			/*
+			Bit 0 is which buffer is the front one, bit 1 is set while the
+			game is reading it, and bit 2 once the game has finished with it,
+			and it's OK to swap in a new one.
+			*/
+			PhysicsSnapshot			snapshots[2];
+			std::atomic<int>		snapshotState;
+			int						stepCount;
+		};
+	}
+}
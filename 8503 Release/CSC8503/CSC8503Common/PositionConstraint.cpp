@@ -33,8 +33,14 @@ void PositionConstraint::UpdateConstraint(float dt)
 			Vector3 aImpulse = offsetDir * lambda;
 			Vector3 bImpulse = -offsetDir * lambda;
 
-			physA->ApplyLinearImpulse(aImpulse);
-			physB->ApplyLinearImpulse(bImpulse);
+			//Fixed objects are left alone entirely, as they can be shared
+			//between constraints that are being solved at the same time
+			if (physA->GetInverseMass() > 0.0f) {
+				physA->ApplyLinearImpulse(aImpulse);
+			}
+			if (physB->GetInverseMass() > 0.0f) {
+				physB->ApplyLinearImpulse(bImpulse);
+			}
 		}
 	}
 }
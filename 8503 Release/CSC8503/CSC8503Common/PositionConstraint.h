@@ -11,16 +11,45 @@ namespace NCL {
 				objectA = a;
 				objectB = b;
 				distance = d;
+				compliance = 0.0f;
 			};
 
 			~PositionConstraint() {};
 
 			void UpdateConstraint(float dt) override;
 
+			bool GetObjects(std::vector<GameObject*>& objects) const override {
+				objects.push_back(objectA);
+				objects.push_back(objectB);
+				return true;
+			}
+
+			GameObject* GetObjectA() const {
+				return objectA;
+			}
+
+			GameObject* GetObjectB() const {
+				return objectB;
+			}
+
+			float GetDistance() const {
+				return distance;
+			}
+
+			//Only used by the XPBD solver, in metres per newton
+			void SetCompliance(float c) {
+				compliance = c;
+			}
+
+			float GetCompliance() const {
+				return compliance;
+			}
+
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
 			float distance;
+			float compliance;
 		};
 	}
 }
\ No newline at end of file
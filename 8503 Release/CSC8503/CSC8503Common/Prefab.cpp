@@ -0,0 +1,120 @@
+#include "Prefab.h"
+#include "LevelArena.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+Prefab::Prefab(const std::string& name) {
+	this->name		= name;
+	volume			= nullptr;
+	renderObject	= nullptr;
+	inertia			= PrefabInertia::Cube;
+	physicsObject	= new PhysicsObject(&transform, nullptr);
+	UpdateInertia();
+}
+
+Prefab::~Prefab() {
+	delete physicsObject;
+	delete renderObject;
+	delete volume;
+}
+
+Prefab& Prefab::SetBoundingVolume(CollisionVolume* vol) {
+	delete volume;
+	volume = vol;
+	return *this;
+}
+
+Prefab& Prefab::SetScale(const Vector3& scale) {
+	transform.SetScale(scale);
+	UpdateInertia();
+	return *this;
+}
+
+Prefab& Prefab::SetOrientation(const Quaternion& orientation) {
+	transform.SetOrientation(orientation);
+	return *this;
+}
+
+Prefab& Prefab::SetInverseMass(float invMass) {
+	physicsObject->SetInverseMass(invMass);
+	UpdateInertia();
+	return *this;
+}
+
+Prefab& Prefab::SetFriction(float f) {
+	physicsObject->SetFriction(f);
+	return *this;
+}
+
+Prefab& Prefab::SetElasticity(float e) {
+	physicsObject->SetElasticity(e);
+	return *this;
+}
+
+Prefab& Prefab::SetInertia(PrefabInertia shape) {
+	inertia = shape;
+	UpdateInertia();
+	return *this;
+}
+
+Prefab& Prefab::SetRenderObject(MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader) {
+	delete renderObject;
+	renderObject = new RenderObject(&transform, mesh, tex, shader);
+	return *this;
+}
+
+Prefab& Prefab::SetColour(const Vector4& colour) {
+	if (renderObject) {
+		renderObject->SetColour(colour);
+	}
+	return *this;
+}
+
+/*
+Inertia only depends on the scale and mass, so it's worked out here, once,
+rather than for every object that gets spawned.
+*/
+void Prefab::UpdateInertia() {
+	if (inertia == PrefabInertia::Sphere) {
+		physicsObject->InitSphereInertia();
+	}
+	else {
+		physicsObject->InitCubeInertia();
+	}
+}
+
+ComponentMask Prefab::GetComponentMask() const {
+	ComponentMask mask = ComponentBit(ComponentType::Transform) | ComponentBit(ComponentType::Score) | ComponentBit(ComponentType::RigidBody);
+	if (renderObject) {
+		mask |= ComponentBit(ComponentType::Renderable);
+	}
+	return mask;
+}
+
+const void* Prefab::GetComponentData(ComponentType type) const {
+	switch (type) {
+		case ComponentType::Transform:	return &transform;
+		case ComponentType::RigidBody:	return physicsObject;
+		case ComponentType::Renderable:	return renderObject;
+		case ComponentType::Score:		return &score;
+		default:						return nullptr;
+	}
+}
+
+CollisionVolume* Prefab::CloneVolume(LevelArena& arena) const {
+	if (!volume) {
+		return nullptr;
+	}
+	switch (volume->type) {
+		case VolumeType::AABB:		return (CollisionVolume*)arena.New<AABBVolume>(*(const AABBVolume*)volume);
+		case VolumeType::OBB:		return (CollisionVolume*)arena.New<OBBVolume>(*(const OBBVolume*)volume);
+		case VolumeType::Sphere:	return (CollisionVolume*)arena.New<SphereVolume>(*(const SphereVolume*)volume);
+		case VolumeType::Capsule:	return (CollisionVolume*)arena.New<CapsuleVolume>(*(const CapsuleVolume*)volume);
+		default:					return nullptr;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Transform.h"
+#include "CollisionVolume.h"
+#include "PhysicsObject.h"
+#include "RenderObject.h"
+#include "Components.h"
+#include <string>
+
+namespace NCL {
+	class MeshGeometry;
+
+	namespace CSC8503 {
+		class LevelArena;
+
+		enum class PrefabInertia {
+			Cube,
+			Sphere
+		};
+
+		/*
+		Everything that every copy of a kind of object has in common - its
+		volume, scale, mass, friction and elasticity, what it looks like,
+		and its name (which the game uses as its tag). The prefab keeps one
+		'master' copy of each component, with the inertia already worked
+		out, and GameWorld::SpawnPrefab just copies those straight into the
+		world for each new object.
+
+		Changing a prefab doesn't change anything that's already been
+		spawned from it.
+		*/
+		class Prefab {
+		public:
+			Prefab(const std::string& name = "");
+			~Prefab();
+
+			Prefab(const Prefab&) = delete;
+			Prefab& operator=(const Prefab&) = delete;
+
+			//The prefab owns the volume - each object gets its own copy of it
+			Prefab& SetBoundingVolume(CollisionVolume* vol);
+			Prefab& SetScale(const Vector3& scale);
+			Prefab& SetOrientation(const Quaternion& orientation);
+
+			Prefab& SetInverseMass(float invMass);
+			Prefab& SetFriction(float f);
+			Prefab& SetElasticity(float e);
+			Prefab& SetInertia(PrefabInertia shape);
+
+			Prefab& SetRenderObject(MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader);
+			Prefab& SetColour(const Vector4& colour);
+
+			const std::string& GetName() const {
+				return name;
+			}
+
+			const CollisionVolume* GetBoundingVolume() const {
+				return volume;
+			}
+
+			//Only the components that are the same for every copy - the
+			//collider and AI belong to each object, so aren't included
+			ComponentMask	GetComponentMask() const;
+			const void*		GetComponentData(ComponentType type) const;
+
+			CollisionVolume* CloneVolume(LevelArena& arena) const;
+
+		protected:
+			void UpdateInertia();
+
+			std::string		name;
+			Transform		transform;
+			CollisionVolume* volume;
+			PhysicsObject*	physicsObject;
+			RenderObject*	renderObject;
+			ScoreComponent	score;
+			PrefabInertia	inertia;
+		};
+	}
+}
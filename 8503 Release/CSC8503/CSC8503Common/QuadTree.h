@@ -31,7 +31,9 @@ namespace NCL {
 		protected:
 			friend class QuadTree<T>;
 
-			QuadTreeNode() {}
+			QuadTreeNode() {
+				children = nullptr;
+			}
 
 			QuadTreeNode(Vector2 pos, Vector2 size) {
 				children		= nullptr;
@@ -43,20 +45,73 @@ namespace NCL {
 				delete[] children;
 			}
 
+			/*
+			The tree splits the world up on the xz plane, so the y axis of
+			each node is treated as being effectively infinite. An object
+			that straddles a split line will end up in more than one leaf.
+			*/
 			void Insert(T& object, const Vector3& objectPos, const Vector3& objectSize, int depthLeft, int maxSize) {
-
+				if (!CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y))) {
+					return;
+				}
+				if (children) { //not a leaf node, just descend the tree
+					for (int i = 0; i < 4; ++i) {
+						children[i].Insert(object, objectPos, objectSize, depthLeft - 1, maxSize);
+					}
+				}
+				else { //currently a leaf node, can just expand
+					contents.push_back(QuadTreeEntry<T>(object, objectPos, objectSize));
+					if ((int)contents.size() > maxSize && depthLeft > 0) {
+						Split();
+						//we need to reinsert the contents so far!
+						for (auto& i : contents) {
+							for (int j = 0; j < 4; ++j) {
+								auto entry = i;
+								children[j].Insert(entry.object, entry.pos, entry.size, depthLeft - 1, maxSize);
+							}
+						}
+						contents.clear(); //contents now distributed!
+					}
+				}
 			}
 
 			void Split() {
-
+				Vector2 halfSize = size / 2.0f;
+				children = new QuadTreeNode<T>[4];
+				children[0] = QuadTreeNode<T>(position + Vector2(-halfSize.x, halfSize.y), halfSize);
+				children[1] = QuadTreeNode<T>(position + Vector2(halfSize.x, halfSize.y), halfSize);
+				children[2] = QuadTreeNode<T>(position + Vector2(-halfSize.x, -halfSize.y), halfSize);
+				children[3] = QuadTreeNode<T>(position + Vector2(halfSize.x, -halfSize.y), halfSize);
 			}
 
 			void DebugDraw() {
-
+				if (children) {
+					for (int i = 0; i < 4; ++i) {
+						children[i].DebugDraw();
+					}
+					return;
+				}
+				Vector3 a(position.x - size.x, 0, position.y - size.y);
+				Vector3 b(position.x + size.x, 0, position.y - size.y);
+				Vector3 c(position.x + size.x, 0, position.y + size.y);
+				Vector3 d(position.x - size.x, 0, position.y + size.y);
+				Debug::DrawLine(a, b, Debug::GREEN);
+				Debug::DrawLine(b, c, Debug::GREEN);
+				Debug::DrawLine(c, d, Debug::GREEN);
+				Debug::DrawLine(d, a, Debug::GREEN);
 			}
 
 			void OperateOnContents(QuadTreeFunc& func) {
-
+				if (children) {
+					for (int i = 0; i < 4; ++i) {
+						children[i].OperateOnContents(func);
+					}
+				}
+				else {
+					if (!contents.empty()) {
+						func(contents);
+					}
+				}
 			}
 
 		protected:
@@ -1,5 +1,6 @@
 #include "RenderObject.h"
 #include "../../Common/MeshGeometry.h"
+#include "Transform.h"
 
 using namespace NCL::CSC8503;
 using namespace NCL;
@@ -10,8 +11,12 @@ RenderObject::RenderObject(Transform* parentTransform, MeshGeometry* mesh, Textu
 	this->texture	= tex;
 	this->shader	= shader;
 	this->colour	= Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	this->useModelMatrix = false;
 }
 
 RenderObject::~RenderObject() {
 
-}
\ No newline at end of file
+}
+Matrix4 RenderObject::GetModelMatrix() const {
+	return useModelMatrix ? modelMatrix : transform->GetMatrix();
+}
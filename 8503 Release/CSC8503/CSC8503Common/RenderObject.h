@@ -34,6 +34,10 @@ namespace NCL {
 				return transform;
 			}
 
+			void SetTransform(Transform* t) {
+				transform = t;
+			}
+
 			ShaderBase*		GetShader() const {
 				return shader;
 			}
@@ -46,12 +50,27 @@ namespace NCL {
 				return colour;
 			}
 
+			//With physics on its own thread, objects are drawn where it
+			//last published them, rather than straight from the transform
+			void SetModelMatrix(const Matrix4& m) {
+				modelMatrix		= m;
+				useModelMatrix	= true;
+			}
+
+			void ClearModelMatrix() {
+				useModelMatrix = false;
+			}
+
+			Matrix4 GetModelMatrix() const;
+
 		protected:
 			MeshGeometry*	mesh;
 			TextureBase*	texture;
 			ShaderBase*		shader;
 			Transform*		transform;
 			Vector4			colour;
+			Matrix4			modelMatrix;
+			bool			useModelMatrix;
 		};
 	}
 }
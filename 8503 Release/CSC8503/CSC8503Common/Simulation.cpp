@@ -0,0 +1,101 @@
+#include "Simulation.h"
+#include "GameObject.h"
+#include <cfloat>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Fast maths lets the compiler reorder and fuse floating point operations
+however it likes, so two builds (or even two functions) can get different
+answers to the same sum - lockstep can't work like that.
+*/
+#if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+#error "Simulations must be built with precise floating point, not fast maths"
+#endif
+#if defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ != 0
+#error "Simulations must be built to use SSE floating point, not x87"
+#endif
+
+Simulation::Simulation(int hz) : physics(world) {
+	physics.UseGravity(true);
+	physics.UseAdaptiveTimestep(false);
+	physics.SetFixedTimestep(hz);
+	stepCount		= 0;
+	deterministic	= false;
+	stateHash		= 0;
+}
+
+Simulation::~Simulation() {
+	Clear();
+}
+
+void Simulation::AddAgent(GameObject* o) {
+	agents.emplace_back(world.AddGameObject(o));
+}
+
+void Simulation::Clear() {
+	world.ClearAndErase();
+	physics.Clear();
+	agents.clear();
+	stepCount = 0;
+}
+
+void Simulation::Snapshot(WorldSnapshot& snapshot) const {
+	world.Snapshot(snapshot);
+	physics.Snapshot(snapshot);
+	snapshot.SetTick(stepCount);
+}
+
+bool Simulation::Restore(const WorldSnapshot& snapshot) {
+	if (!world.Restore(snapshot) || !physics.Restore(snapshot)) {
+		return false;
+	}
+	stepCount = (int)snapshot.GetTick();
+	return true;
+}
+
+void Simulation::SetDeterministic(uint64_t seed) {
+	deterministic = true;
+	world.SetRandomSeed(seed);
+	physics.UseAdaptiveTimestep(false);
+}
+
+uint64_t Simulation::Tick(const std::vector<LockstepInput>& inputs) {
+	for (const LockstepInput& input : inputs) {
+		GameObject* o = world.GetObjectByID(input.objectID);
+		if (!o) {
+			continue;
+		}
+		if (input.type == PhysicsCommandType::DisableCollisions) {
+			o->SetCollisionsEnabled(false);
+		}
+		else if (o->GetPhysicsObject()) {
+			o->GetPhysicsObject()->ExecuteCommand({ input.type, o, input.value, input.position });
+		}
+	}
+	//Exactly one physics step's worth of time, so it runs exactly one step
+	Step(1.0f / physics.GetFixedTimestep());
+
+	Snapshot(hashSnapshot);
+	stateHash = hashSnapshot.GetHash();
+	return stateHash;
+}
+
+//Agents that have been removed from the world are dropped, keeping the rest in order
+void Simulation::Step(float dt) {
+	size_t alive = 0;
+	for (size_t i = 0; i < agents.size(); ++i) {
+		GameObject* o = world.GetGameObject(agents[i]);
+		if (!o) {
+			continue;
+		}
+		agents[alive++] = agents[i];
+		o->Update(dt);
+	}
+	agents.resize(alive);
+	world.UpdateWorld(dt);
+	physics.Update(dt);
+	world.FlushRemovals();
+	stepCount++;
+}
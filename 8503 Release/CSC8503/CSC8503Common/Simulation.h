@@ -0,0 +1,94 @@
+#pragma once
+#include "GameWorld.h"
+#include "PhysicsSystem.h"
+#include "WorldSnapshot.h"
+#include "PhysicsCommandQueue.h"
+#include <vector>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Something a player did on a given tick - objects are referred to by
+		their world ID, so that inputs can be sent between machines.
+		*/
+		struct LockstepInput {
+			int					objectID;
+			PhysicsCommandType	type;
+			Vector3				value;
+			Vector3				position;
+		};
+
+		/*
+		Everything needed to run one match - a world, the physics for it,
+		and the objects with AI that need updating each step. Nothing in
+		here touches the window, or any global state, so a process can
+		have as many of these as it likes, each on whichever thread.
+
+		The timestep is fixed rather than adaptive, so that two runs with
+		the same inputs step the same way however busy the machine is.
+
+		In deterministic mode, the world's shuffling is seeded, and the game
+		moves forward one Tick at a time. Two simulations built the same way,
+		with the same seed and the same inputs each tick, end up bit for bit
+		identical - whatever the thread count - so lockstep clients only
+		need to send each other their inputs, and the hash Tick returns, to
+		know they're still in sync. Builds have to use precise floating
+		point (no fast maths) for this to hold between machines.
+		*/
+		class Simulation {
+		public:
+			Simulation(int hz = 120);
+			virtual ~Simulation();
+
+			GameWorld& GetWorld() {
+				return world;
+			}
+
+			PhysicsSystem& GetPhysics() {
+				return physics;
+			}
+
+			//Adds the object to the world, and calls its Update every step,
+			//until it's removed from the world. The world owns it from then on
+			void AddAgent(GameObject* o);
+
+			void Clear();
+
+			virtual void Step(float dt);
+
+			void SetDeterministic(uint64_t seed);
+
+			bool IsDeterministic() const {
+				return deterministic;
+			}
+
+			//Runs exactly one fixed physics step, with the given inputs applied
+			//at the start of it, and returns the hash of the state after it
+			uint64_t Tick(const std::vector<LockstepInput>& inputs);
+
+			uint64_t GetStateHash() const {
+				return stateHash;
+			}
+
+			//The world and physics state, tagged with the step count
+			void Snapshot(WorldSnapshot& snapshot) const;
+			bool Restore(const WorldSnapshot& snapshot);
+
+			int GetStepCount() const {
+				return stepCount;
+			}
+
+		protected:
+			GameWorld		world;
+			PhysicsSystem	physics;
+
+			std::vector<GameObjectHandle> agents;	//handles, as agents can be removed mid-match
+			int stepCount;
+
+			bool			deterministic;
+			uint64_t		stateHash;
+			WorldSnapshot	hashSnapshot;
+		};
+	}
+}
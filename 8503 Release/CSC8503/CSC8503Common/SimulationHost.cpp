@@ -0,0 +1,41 @@
+#include "SimulationHost.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+SimulationHost::SimulationHost(JobSystem* jobs) {
+	jobSystem = jobs;
+}
+
+SimulationHost::~SimulationHost() {
+	Clear();
+}
+
+void SimulationHost::AddSimulation(Simulation* s) {
+	simulations.emplace_back(s);
+}
+
+void SimulationHost::Clear() {
+	for (Simulation* s : simulations) {
+		delete s;
+	}
+	simulations.clear();
+}
+
+void SimulationHost::Step(float dt) {
+	if (!jobSystem) {
+		for (Simulation* s : simulations) {
+			s->Step(dt);
+		}
+		return;
+	}
+	jobSystem->ParallelFor((int)simulations.size(), 1,
+		[&](int start, int end) {
+			for (int i = start; i < end; ++i) {
+				simulations[i]->Step(dt);
+			}
+		}
+	);
+}
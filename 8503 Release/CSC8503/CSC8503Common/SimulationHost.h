@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		class JobSystem;
+		class Simulation;
+
+		/*
+		Steps a number of independent simulations at once - one job per
+		simulation - so a single process can run lots of matches, or bot
+		training rollouts, side by side. Each simulation only ever runs
+		on one thread at a time, so they don't need any locking.
+
+		The physics in each simulation should be left without a job system
+		of its own - the parallelism here comes from running lots of them.
+		*/
+		class SimulationHost {
+		public:
+			//Without a job system, the simulations are just stepped in turn
+			SimulationHost(JobSystem* jobs = nullptr);
+			~SimulationHost();
+
+			//The host owns the simulation from then on
+			void AddSimulation(Simulation* s);
+			void Clear();
+
+			void Step(float dt);
+
+			int GetNumSimulations() const {
+				return (int)simulations.size();
+			}
+
+			Simulation* GetSimulation(int i) const {
+				return simulations[i];
+			}
+
+		protected:
+			JobSystem* jobSystem;
+			std::vector<Simulation*> simulations;
+		};
+	}
+}
@@ -6,10 +6,23 @@
 
 using namespace NCL::CSC8503;
 
-StateGameObject::StateGameObject(std::string name) : GameObject(name)
+//How long an agent follows a path from the service before asking for a fresher one
+const float REPATH_TIME = 0.5f;
+
+//How far ahead along a path an agent aims, at least
+const float LOOK_AHEAD_DISTANCE = 12.0f;
+
+StateGameObject::StateGameObject(std::string name, const NavigationMap* map, const FlowField* flowField, PathfindingService* pathService) : GameObject(name)
 {
+	SetAIAgent(true);
 	counter = 0.0f;
-	grid = new NavigationGrid("TestGrid1.txt");
+	this->map = map;
+	this->flowField = flowField;
+	this->pathService = pathService;
+	planner = nullptr;
+	repathTimer = 0.0f;
+	requestID = -1;
+	pathIndex = 0;
 	pathFound = false;
 	stateMachine = new StateMachine();
 
@@ -25,57 +38,150 @@ StateGameObject::StateGameObject(std::string name) : GameObject(name)
 	//AI jumps if no path available, of if it thinks it is blocked to jump over the blockade
 	stateMachine->AddTransition(new StateTransition(stateA, stateB, [&]()->bool { //pathfind when available
 		TestForPath();
-		return pathFound == true || GetPhysicsObject()->GetLinearVelocity().Length() <= 2;
+		return pathFound == true || GetGameLinearVelocity().Length() <= 2;
 		
 		}));
 	stateMachine->AddTransition(new StateTransition(stateB, stateA, [&]()->bool { //jump if blocked
 		TestForPath();
-		return pathFound == false || GetPhysicsObject()->GetLinearVelocity().Length() > 2;
+		return pathFound == false || GetGameLinearVelocity().Length() > 2;
 		}));
 }
 
 StateGameObject::~StateGameObject() {
+	CancelPathRequest();
 	delete stateMachine;
+	delete planner;
 }
 
 void StateGameObject::Update(float dt) {
-	if(GetTransform().GetPosition().y < -5) {
-		GetTransform().SetPosition(Vector3(-20, 5, 20)); //Ressurect if fallen
+	if(GetGamePosition().y < -5) {
+		MoveTo(Vector3(-20, 5, 20)); //Ressurect if fallen
 	}
+	repathTimer -= dt;
 	stateMachine->Update(dt);
 }
 
 bool StateGameObject::TestForPath() {
-	pathNodes.clear();
 	Vector3 shift(55, 0, 100);
-	Vector3 startPos = GetTransform().GetPosition() + shift;
+	Vector3 startPos = GetGamePosition() + shift;
 	Vector3 endPos = Vector3(90, 0, 0); //End area
+
+	if (planner) {
+		Vector3 waypoint;
+		pathFound = planner->SetGoal(endPos) && planner->SetStart(startPos) &&
+			planner->Replan() && planner->GetWaypoint(waypoint, 2);
+		pathTarget = waypoint - shift + Vector3(0, 3, 0);
+		return pathFound;
+	}
+	if (flowField) {
+		Vector3 waypoint;
+		pathFound = flowField->GetWaypoint(startPos, waypoint, 2);
+		pathTarget = waypoint - shift + Vector3(0, 3, 0);
+		return pathFound;
+	}
+	if (pathService) {
+		if (requestID != GetWorldID()) { //moved to another slot since it last asked
+			CancelPathRequest();
+			requestID = GetWorldID();
+		}
+		PathResult result;
+		if (pathService->CollectResult(requestID, result)) {
+			pathFound = result.found;
+			pathNodes.clear();
+			for (const Vector3& pos : result.waypoints) {
+				pathNodes.push_back(pos - shift + Vector3(0, 3, 0));
+			}
+			pathIndex = 0;
+		}
+		if (repathTimer <= 0 && !pathService->IsWaiting(requestID)) {
+			PathRequest request;
+			request.from	= startPos;
+			request.to		= endPos;
+			request.agentID = requestID;
+			pathService->RequestPath(request);
+			repathTimer = REPATH_TIME;
+		}
+		FollowPath();
+		return pathFound;
+	}
+	pathNodes.clear();
 	NavigationPath outPath;
-	pathFound = grid->FindPath(startPos, endPos, outPath);
+	pathFound = map && map->FindPath(startPos, endPos, outPath);
 
 	Vector3 pos;
 	while (outPath.PopWaypoint(pos)) {
 		pathNodes.push_back(pos - shift + Vector3(0, 3, 0));
 	}
+	pathIndex = 0;
+	FollowPath();
 	return pathFound;
 }
 
+/*
+The world hands an agent's ID on to the next object once it's removed, so
+whatever it had asked the service for goes with it - rather than ending up
+as the path of whatever takes its place.
+*/
+void StateGameObject::CancelPathRequest() {
+	if (pathService && requestID >= 0) {
+		pathService->CancelRequest(requestID);
+	}
+	requestID = -1;
+}
+
+/*
+A path from the service could have been asked for a while ago, so rather
+than always aiming two nodes in, the agent works out which node it's got
+closest to, and aims past that. On a path with a node on every cell that's
+two nodes on, but a smoothed path only has its corners left, so the agent
+stops at the first node that's a decent distance away - skipping a corner
+would send it into a wall.
+*/
+void StateGameObject::FollowPath() {
+	if (pathNodes.empty()) {
+		return;
+	}
+	Vector3 pos = GetGamePosition();
+	auto flatDistance = [&](const Vector3& node) {
+		Vector3 offset = node - pos;
+		return (offset.x * offset.x) + (offset.z * offset.z);
+	};
+	int last = (int)pathNodes.size() - 1;
+	int lookAhead = pathIndex + 4 < last ? pathIndex + 4 : last;
+	float closest = flatDistance(pathNodes[pathIndex]);
+	for (int i = pathIndex + 1; i <= lookAhead; ++i) {
+		float d = flatDistance(pathNodes[i]);
+		if (d < closest) {
+			closest = d;
+			pathIndex = i;
+		}
+	}
+	int target = pathIndex + 1 < last ? pathIndex + 1 : last;
+	if (target < last && flatDistance(pathNodes[target]) < LOOK_AHEAD_DISTANCE * LOOK_AHEAD_DISTANCE) {
+		target++;
+	}
+	pathTarget = pathNodes[target];
+}
+
 void StateGameObject::Pathfind(float dt) {
-	if (GetPhysicsObject()->GetLinearVelocity().Length() <= 2) {
-		if (grounded) {
+	if (GetGameLinearVelocity().Length() <= 2) {
+		if (IsGrounded()) {
 			//GetPhysicsObject()->AddForce({ 0, 1000, 0 });//Jump if possibly stuck
 		}
 	}
-	Vector3 target = pathNodes[2];
-	Vector3 facingNormal = (GetTransform().GetPosition()) - GetTransform().GetOrientation() * Vector3(0, 0, 1);
-	GetPhysicsObject()->AddForceAtPosition((target - GetTransform().GetPosition()).Normalised() * 50, facingNormal);
+	if (!pathFound) {
+		return;
+	}
+	Vector3 target = pathTarget;
+	Vector3 facingNormal = (GetGamePosition()) - GetGameOrientation() * Vector3(0, 0, 1);
+	GetPhysicsObject()->AddForceAtPosition((target - GetGamePosition()).Normalised() * 50, facingNormal);
 
 	//Oh yeah look at em goooooo skkrrrrr
 	
 }
 
 void StateGameObject::Jump(float dt) {
-	if (grounded) {
+	if (IsGrounded()) {
 		GetPhysicsObject()->AddForce({ 0, 1000, 0 });
 	}
 }
\ No newline at end of file
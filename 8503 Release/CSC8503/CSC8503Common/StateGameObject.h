@@ -1,7 +1,10 @@
 #pragma once
-#include "..\CSC8503Common\GameObject.h"
-#include "..\CSC8503Common\NavigationGrid.h"
-#include "..\CSC8503Common\NavigationPath.h"
+#include "../CSC8503Common/GameObject.h"
+#include "../CSC8503Common/NavigationGrid.h"
+#include "../CSC8503Common/NavigationPath.h"
+#include "../CSC8503Common/FlowField.h"
+#include "../CSC8503Common/PathfindingService.h"
+#include "../CSC8503Common/DStarLite.h"
 
 namespace NCL {
 	namespace CSC8503 {
@@ -10,11 +13,46 @@ namespace NCL {
 		class StateGameObject : public GameObject
 		{
 		public:
-			StateGameObject(std::string name);
+			/*
+			The map (and the flow field, if there is one) are shared with
+			every other agent, and aren't owned by this one. With a flow
+			field, the agent just looks up which way to go, rather than
+			searching the map for a whole path every time.
+
+			Without one, a pathfinding service will do the searching off on
+			its own threads - the agent keeps following its last path until
+			a new one comes back.
+			*/
+			StateGameObject(std::string name, const NavigationMap* map = nullptr, const FlowField* flowField = nullptr, PathfindingService* pathService = nullptr);
 			~StateGameObject();
 
 			virtual void Update(float dt);
 
+			/*
+			An agent with a planner of its own uses that before anything
+			else - it can be told about things that move (which the shared
+			map and flow field can't), and only does as much work as they
+			actually change. The agent owns the planner from then on.
+			*/
+			void SetPlanner(DStarLite* newPlanner) {
+				delete planner;
+				planner = newPlanner;
+			}
+
+			DStarLite* GetPlanner() const {
+				return planner;
+			}
+
+			//Swaps which shared pathfinding the agent uses - it starts again on a fresh path
+			void SetPathing(const FlowField* newFlowField, PathfindingService* newPathService) {
+				CancelPathRequest();
+				flowField	= newFlowField;
+				pathService = newPathService;
+				pathNodes.clear();
+				pathIndex	= 0;
+				repathTimer = 0.0f;
+			}
+
 			bool TestForPath();
 
 		protected:
@@ -25,13 +63,24 @@ namespace NCL {
 
 			void Jump(float dt);
 
+			void FollowPath();
+
+			void CancelPathRequest();
+
 			StateMachine* stateMachine;
 
 			float counter;
 			bool pathFound;
 
-			NavigationGrid* grid;
+			const NavigationMap* map;
+			const FlowField* flowField;
+			PathfindingService* pathService;
+			DStarLite* planner;
+			float repathTimer;
+			int requestID;	//the ID the service knows this agent by, or -1
 			vector<Vector3> pathNodes;
+			int pathIndex;
+			Vector3 pathTarget;
 		};
 	}
 }
@@ -7,6 +7,7 @@ using namespace NCL::CSC8503;
 
 StateObstacleObject::StateObstacleObject(std::string name, float counter) : GameObject(name)
 {
+	SetAIAgent(true);
 	this->counter = counter;
 
 	stateMachine = new StateMachine();
@@ -0,0 +1,107 @@
+#include "ThetaStar.h"
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8503;
+
+//The straight moves first, then the diagonals
+const int NEIGHBOUR_X[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+const int NEIGHBOUR_Y[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+
+ThetaStar::ThetaStar(const NavigationGrid& grid) : grid(grid) {
+	width = grid.GetWidth();
+}
+
+ThetaStar::~ThetaStar() {
+}
+
+float ThetaStar::Distance(int a, int b) const {
+	float dx = (float)((a % width) - (b % width));
+	float dy = (float)((a / width) - (b / width));
+	return std::sqrt((dx * dx) + (dy * dy));
+}
+
+bool ThetaStar::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const {
+	int nodesExpanded;
+	return FindPath(from, to, outPath, nodesExpanded);
+}
+
+bool ThetaStar::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const {
+	nodesExpanded = 0;
+	int fromX, fromY, toX, toY;
+	if (!grid.GetCell(from, fromX, fromY) || !grid.GetCell(to, toX, toY)) {
+		return false; //outside of map region!
+	}
+	GridSearchState& s = *grid.AcquireSearchState();
+	s.Reset(width * grid.GetHeight());
+
+	int startCell	= (fromY * width) + fromX;
+	int endCell		= (toY * width) + toX;
+
+	s.g[startCell]			= 0;
+	s.parent[startCell]		= -1;
+	s.visited[startCell]	= s.stamp;
+	s.openList.Push(startCell, 0);
+
+	bool found = false;
+	while (!s.openList.IsEmpty()) {
+		int current = s.openList.Pop();
+		nodesExpanded++;
+		s.visited[current] = s.stamp + 1;
+
+		if (current == endCell) {
+			found = true;
+			break;
+		}
+		int x		= current % width;
+		int y		= current / width;
+		int parent	= s.parent[current];
+		for (int i = 0; i < 8; ++i) {
+			int nx = x + NEIGHBOUR_X[i];
+			int ny = y + NEIGHBOUR_Y[i];
+			if (grid.IsWall(nx, ny)) {
+				continue;
+			}
+			//Diagonals can't cut the corner of a wall
+			if (i >= 4 && (grid.IsWall(nx, y) || grid.IsWall(x, ny))) {
+				continue;
+			}
+			int neighbour = (ny * width) + nx;
+			if (s.IsClosed(neighbour)) {
+				continue;
+			}
+			float g;
+			int newParent;
+			if (parent != -1 && grid.HasLineOfSight(parent % width, parent / width, nx, ny)) {
+				g			= s.g[parent] + Distance(parent, neighbour);
+				newParent	= parent;
+			}
+			else {
+				g			= s.g[current] + Distance(current, neighbour);
+				newParent	= current;
+			}
+			bool inOpen = s.IsOpen(neighbour);
+			if (inOpen && g >= s.g[neighbour]) {
+				continue;
+			}
+			s.g[neighbour]		= g;
+			s.parent[neighbour] = newParent;
+
+			float f = g + Distance(neighbour, endCell);
+			if (inOpen) {
+				s.openList.DecreaseKey(neighbour, f);
+			}
+			else {
+				s.visited[neighbour] = s.stamp;
+				s.openList.Push(neighbour, f);
+			}
+		}
+	}
+	if (found) {
+		for (int cell = endCell; cell != -1; cell = s.parent[cell]) {
+			outPath.PushWaypoint(grid.GetCellPosition(cell % width, cell / width));
+		}
+	}
+	grid.ReleaseSearchState(&s);
+	return found;
+}
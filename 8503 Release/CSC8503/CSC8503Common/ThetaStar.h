@@ -0,0 +1,36 @@
+#pragma once
+#include "NavigationGrid.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Theta* - A* over the same walls as a NavigationGrid, moving in eight
+		directions, but whenever a cell's parent can see one of its
+		neighbours, that neighbour is linked straight back to the parent
+		instead. Paths come out as straight lines between corners, at any
+		angle, rather than being stuck to the grid's directions - there's
+		a waypoint at each corner only, rather than on every cell.
+
+		Search state comes from the grid's pool, so it's safe to search
+		from many threads at once.
+		*/
+		class ThetaStar : public NavigationMap {
+		public:
+			ThetaStar(const NavigationGrid& grid);
+			~ThetaStar();
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) const override;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int& nodesExpanded) const override;
+
+			size_t GetMemoryUsage() const override {
+				return sizeof(*this);
+			}
+
+		protected:
+			float Distance(int a, int b) const;
+
+			const NavigationGrid&	grid;
+			int						width;
+		};
+	}
+}
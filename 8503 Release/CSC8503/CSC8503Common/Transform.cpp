@@ -12,11 +12,21 @@ Transform::~Transform()
 
 }
 
+/*
+Same as Translation(position) * Matrix4(orientation) * Scale(scale), but
+without the two full matrix multiplies - scaling just multiplies the
+rotation's columns, and the translation goes straight in the last column.
+*/
 void Transform::UpdateMatrix() {
-	matrix =
-		Matrix4::Translation(position) *
-		Matrix4(orientation) *
-		Matrix4::Scale(scale);
+	matrix = Matrix4(orientation);
+	for (int i = 0; i < 4; ++i) {
+		matrix.array[i]		*= scale.x;
+		matrix.array[4 + i] *= scale.y;
+		matrix.array[8 + i] *= scale.z;
+	}
+	matrix.array[12] = position.x;
+	matrix.array[13] = position.y;
+	matrix.array[14] = position.z;
 }
 
 Transform& Transform::SetPosition(const Vector3& worldPos) {
@@ -31,6 +41,14 @@ Transform& Transform::SetScale(const Vector3& worldScale) {
 	return *this;
 }
 
+Transform& Transform::Set(const Vector3& worldPos, const Quaternion& worldOrientation, const Vector3& worldScale) {
+	position	= worldPos;
+	orientation = worldOrientation;
+	scale		= worldScale;
+	UpdateMatrix();
+	return *this;
+}
+
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
 	orientation = worldOrientation;
 	UpdateMatrix();
@@ -21,6 +21,8 @@ namespace NCL {
 			Transform& SetPosition(const Vector3& worldPos);
 			Transform& SetScale(const Vector3& worldScale);
 			Transform& SetOrientation(const Quaternion& newOr);
+			//All three at once, only working out the matrix the one time
+			Transform& Set(const Vector3& worldPos, const Quaternion& newOr, const Vector3& worldScale);
 
 			Vector3 GetPosition() const {
 				return position;
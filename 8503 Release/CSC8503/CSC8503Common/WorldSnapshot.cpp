@@ -0,0 +1,165 @@
+#include "WorldSnapshot.h"
+#include <fstream>
+#include <cstring>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const uint32_t SNAPSHOT_MAGIC	= 0x504E5357; //'WSNP'
+const uint32_t SNAPSHOT_VERSION	= 3;
+
+//Flags are one byte each, but padded so the next section stays 4 byte aligned
+static size_t PaddedFlagBytes(int count) {
+	return ((size_t)count + 3) & ~(size_t)3;
+}
+
+WorldSnapshot::WorldSnapshot() {
+}
+
+WorldSnapshot::~WorldSnapshot() {
+}
+
+WorldSnapshot::Header& WorldSnapshot::GetHeader() {
+	return *(Header*)data.data();
+}
+
+const WorldSnapshot::Header& WorldSnapshot::GetHeader() const {
+	return *(const Header*)data.data();
+}
+
+int WorldSnapshot::GetNumObjects() const {
+	return data.empty() ? 0 : GetHeader().numObjects;
+}
+
+int WorldSnapshot::GetNumCollisions() const {
+	return data.empty() ? 0 : GetHeader().numCollisions;
+}
+
+void WorldSnapshot::SetTick(int64_t t) {
+	if (!data.empty()) {
+		GetHeader().tick = t;
+	}
+}
+
+int64_t WorldSnapshot::GetTick() const {
+	return data.empty() ? 0 : GetHeader().tick;
+}
+
+/*
+The buffer is laid out as the header, then the objects' ids, flags,
+scores and values, then the collisions' ids, frame counts and values.
+*/
+size_t WorldSnapshot::ObjectIDOffset() const {
+	return sizeof(Header);
+}
+
+size_t WorldSnapshot::ObjectFlagOffset() const {
+	return ObjectIDOffset() + sizeof(int32_t) * GetHeader().numObjects;
+}
+
+size_t WorldSnapshot::ObjectScoreOffset() const {
+	return ObjectFlagOffset() + PaddedFlagBytes(GetHeader().numObjects);
+}
+
+size_t WorldSnapshot::ObjectValueOffset(int value) const {
+	return ObjectScoreOffset() + sizeof(int32_t) * GetHeader().numObjects * (1 + (size_t)value);
+}
+
+size_t WorldSnapshot::ObjectSectionEnd() const {
+	return ObjectValueOffset(NUM_OBJECT_VALUES);
+}
+
+size_t WorldSnapshot::CollisionIntOffset(int value) const {
+	return ObjectSectionEnd() + sizeof(int32_t) * GetHeader().numCollisions * (size_t)value;
+}
+
+size_t WorldSnapshot::CollisionValueOffset(int value) const {
+	return CollisionIntOffset(3) + sizeof(float) * GetHeader().numCollisions * (size_t)value;
+}
+
+/*
+Resizing never shrinks the vector's memory, so taking a snapshot into the
+same WorldSnapshot over and over doesn't keep allocating.
+*/
+void WorldSnapshot::SetNumObjects(int count) {
+	Header header = {};
+	if (!data.empty()) {
+		header = GetHeader();
+	}
+	header.magic			= SNAPSHOT_MAGIC;
+	header.version			= SNAPSHOT_VERSION;
+	header.numObjects		= count;
+	header.numCollisions	= 0;
+
+	data.resize(sizeof(Header));
+	GetHeader() = header;
+	data.resize(ObjectSectionEnd());
+}
+
+void WorldSnapshot::SetNumCollisions(int count) {
+	GetHeader().numCollisions = count;
+	data.resize(CollisionValueOffset(NUM_COLLISION_VALUES));
+}
+
+bool WorldSnapshot::SetData(const char* bytes, size_t size) {
+	if (size < sizeof(Header)) {
+		return false;
+	}
+	Header header;
+	memcpy(&header, bytes, sizeof(Header));
+	if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.numObjects < 0 || header.numCollisions < 0) {
+		return false;
+	}
+	data.assign(bytes, bytes + size);
+	if (CollisionValueOffset(NUM_COLLISION_VALUES) != size) {
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+/*
+FNV-1a, but on 8 bytes at a time rather than 1, with a final mix so that
+every input bit affects every output bit.
+*/
+uint64_t WorldSnapshot::GetHash() const {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	size_t words = data.size() / 8;
+	for (size_t i = 0; i < words; ++i) {
+		uint64_t word;
+		memcpy(&word, data.data() + i * 8, 8);
+		hash = (hash ^ word) * 0x100000001B3ull;
+	}
+	for (size_t i = words * 8; i < data.size(); ++i) {
+		hash = (hash ^ (uint8_t)data[i]) * 0x100000001B3ull;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+bool WorldSnapshot::SaveToFile(const std::string& filename) const {
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	file.write(data.data(), data.size());
+	return file.good();
+}
+
+bool WorldSnapshot::LoadFromFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		return false;
+	}
+	std::vector<char> bytes((size_t)file.tellg());
+	file.seekg(0);
+	file.read(bytes.data(), bytes.size());
+	if (!file.good()) {
+		return false;
+	}
+	return SetData(bytes.data(), bytes.size());
+}
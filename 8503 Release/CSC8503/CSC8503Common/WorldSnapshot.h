@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		The complete state of a world at one moment, packed into a single
+		block of memory, so that it can be saved and restored quickly - for
+		rolling back, resetting a level without rebuilding it, or capturing
+		a game that's gone wrong so it can be replayed later.
+
+		GameWorld::Snapshot fills in the objects, and PhysicsSystem::Snapshot
+		adds the collision pairs it's tracking on to the end. Rather than one
+		struct per object, each value gets its own array (all the x positions,
+		then all the y positions...), so every section is just a flat run of
+		ints or floats.
+
+		A snapshot can only be restored into the world it was taken from (or
+		an identical one), with the same objects in it - it stores the state
+		of the objects, not the objects themselves.
+		*/
+		class WorldSnapshot {
+		public:
+			enum ObjectValue {
+				PositionX, PositionY, PositionZ,
+				OrientationX, OrientationY, OrientationZ, OrientationW,
+				ScaleX, ScaleY, ScaleZ,
+				InverseMass, Elasticity, Friction,
+				LinearVelocityX, LinearVelocityY, LinearVelocityZ,
+				ForceX, ForceY, ForceZ,
+				AngularVelocityX, AngularVelocityY, AngularVelocityZ,
+				TorqueX, TorqueY, TorqueZ,
+				InverseInertiaX, InverseInertiaY, InverseInertiaZ,
+				NUM_OBJECT_VALUES
+			};
+
+			enum ObjectFlags {
+				FlagActive		= 1,
+				FlagCollisions	= 2,
+				FlagGrounded	= 4,
+				FlagPhysics		= 8
+			};
+
+			enum CollisionValue {
+				LocalAX, LocalAY, LocalAZ,
+				LocalBX, LocalBY, LocalBZ,
+				NormalX, NormalY, NormalZ,
+				Penetration,
+				NUM_COLLISION_VALUES
+			};
+
+			WorldSnapshot();
+			~WorldSnapshot();
+
+			bool IsEmpty() const {
+				return data.empty();
+			}
+
+			int GetNumObjects() const;
+			int GetNumCollisions() const;
+
+			//Whatever step the snapshot was taken on, if the owner cares
+			void	SetTick(int64_t t);
+			int64_t	GetTick() const;
+
+			const char* GetData() const {
+				return data.data();
+			}
+
+			size_t GetSize() const {
+				return data.size();
+			}
+
+			//Takes a copy of a previously saved snapshot, returning false
+			//if it doesn't look like one
+			bool SetData(const char* bytes, size_t size);
+
+			/*
+			A 64 bit hash of the whole snapshot - two worlds that have been
+			stepped in lockstep should always have the same one, so clients
+			only need to send each other hashes to check they're in sync.
+			*/
+			uint64_t GetHash() const;
+
+			bool SaveToFile(const std::string& filename) const;
+			bool LoadFromFile(const std::string& filename);
+
+		protected:
+			friend class GameWorld;
+			friend class PhysicsSystem;
+
+			struct Header {
+				uint32_t	magic;
+				uint32_t	version;
+				int32_t		numObjects;
+				int32_t		numCollisions;
+				int32_t		numSlots;
+				float		physicsTimeOffset;
+				int64_t		tick;
+				uint64_t	randomState;
+			};
+
+			//Throws away any collisions, as they come after the objects
+			void SetNumObjects(int count);
+			void SetNumCollisions(int count);
+
+			Header&			GetHeader();
+			const Header&	GetHeader() const;
+
+			int32_t*		GetObjectIDs()					{ return (int32_t*)(data.data() + ObjectIDOffset()); }
+			uint8_t*		GetObjectFlags()				{ return (uint8_t*)(data.data() + ObjectFlagOffset()); }
+			int32_t*		GetObjectScores()				{ return (int32_t*)(data.data() + ObjectScoreOffset()); }
+			float*			GetObjectValues(int value)		{ return (float*)(data.data() + ObjectValueOffset(value)); }
+			int32_t*		GetCollisionIDsA()				{ return (int32_t*)(data.data() + CollisionIntOffset(0)); }
+			int32_t*		GetCollisionIDsB()				{ return (int32_t*)(data.data() + CollisionIntOffset(1)); }
+			int32_t*		GetCollisionFramesLeft()		{ return (int32_t*)(data.data() + CollisionIntOffset(2)); }
+			float*			GetCollisionValues(int value)	{ return (float*)(data.data() + CollisionValueOffset(value)); }
+
+			const int32_t*	GetObjectIDs() const				{ return (const int32_t*)(data.data() + ObjectIDOffset()); }
+			const uint8_t*	GetObjectFlags() const				{ return (const uint8_t*)(data.data() + ObjectFlagOffset()); }
+			const int32_t*	GetObjectScores() const				{ return (const int32_t*)(data.data() + ObjectScoreOffset()); }
+			const float*	GetObjectValues(int value) const	{ return (const float*)(data.data() + ObjectValueOffset(value)); }
+			const int32_t*	GetCollisionIDsA() const			{ return (const int32_t*)(data.data() + CollisionIntOffset(0)); }
+			const int32_t*	GetCollisionIDsB() const			{ return (const int32_t*)(data.data() + CollisionIntOffset(1)); }
+			const int32_t*	GetCollisionFramesLeft() const		{ return (const int32_t*)(data.data() + CollisionIntOffset(2)); }
+			const float*	GetCollisionValues(int value) const	{ return (const float*)(data.data() + CollisionValueOffset(value)); }
+
+			size_t ObjectIDOffset() const;
+			size_t ObjectFlagOffset() const;
+			size_t ObjectScoreOffset() const;
+			size_t ObjectValueOffset(int value) const;
+			size_t CollisionIntOffset(int value) const;
+			size_t CollisionValueOffset(int value) const;
+			size_t ObjectSectionEnd() const;
+
+			std::vector<char> data;
+		};
+	}
+}
@@ -0,0 +1,370 @@
+#include "XPBDSolver.h"
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "PhysicsObject.h"
+#include "PhysicsStats.h"
+#include "PositionConstraint.h"
+#include "ChainConstraint.h"
+#include "../../Common/Quaternion.h"
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8503;
+
+XPBDSolver::XPBDSolver() {
+	substeps				= 8;
+	contactCompliance		= 0.0f;
+	loadedConstraintVersion = -1;
+}
+
+XPBDSolver::~XPBDSolver() {
+}
+
+/*
+The objects' velocities are damped by their friction once per step, just
+like in IntegrateAccel, so that things feel the same whichever solver is
+being used.
+*/
+void XPBDSolver::LoadBodies(GameWorld& world) {
+	bodies.clear();
+	bodyIndices.clear();
+	posX.clear();	posY.clear();	posZ.clear();
+	velX.clear();	velY.clear();	velZ.clear();
+	accelX.clear(); accelY.clear(); accelZ.clear();
+	inverseMass.clear();
+	friction.clear();
+	elasticity.clear();
+
+	contactA.clear();
+	contactB.clear();
+	contactNormalX.clear(); contactNormalY.clear(); contactNormalZ.clear();
+	contactPenetration.clear();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	world.GetObjectIterators(first, last);
+
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* phys = (*i)->GetPhysicsObject();
+		if (!phys) {
+			continue;
+		}
+		bodyIndices[*i] = (int)bodies.size();
+		bodies.push_back(*i);
+
+		Vector3 pos		= (*i)->GetTransform().GetPosition();
+		Vector3 vel		= phys->GetLinearVelocity() * phys->GetFriction();
+		Vector3 accel	= phys->GetForce() * phys->GetInverseMass();
+
+		posX.push_back(pos.x);		posY.push_back(pos.y);		posZ.push_back(pos.z);
+		velX.push_back(vel.x);		velY.push_back(vel.y);		velZ.push_back(vel.z);
+		accelX.push_back(accel.x);	accelY.push_back(accel.y);	accelZ.push_back(accel.z);
+
+		inverseMass.push_back(phys->GetInverseMass());
+		friction.push_back(phys->GetFriction());
+		elasticity.push_back(phys->GetElasticity());
+	}
+	startX = posX;	startY = posY;	startZ = posZ;
+	prevX  = posX;	prevY  = posY;	prevZ  = posZ;
+}
+
+/*
+PositionConstraints, and each link of a ChainConstraint, become distance
+constraints. Anything else gets handed back to the PhysicsSystem to be
+solved the old way, once the XPBD step is done.
+*/
+void XPBDSolver::LoadConstraints(GameWorld& world) {
+	if (loadedConstraintVersion == world.GetConstraintVersion()) {
+		return;
+	}
+	loadedConstraintVersion = world.GetConstraintVersion();
+
+	distanceObjectA.clear();
+	distanceObjectB.clear();
+	distanceLength.clear();
+	distanceCompliance.clear();
+	unsupportedConstraints.clear();
+
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	world.GetConstraintIterators(first, last);
+
+	for (auto i = first; i != last; ++i) {
+		if (PositionConstraint* p = dynamic_cast<PositionConstraint*>(*i)) {
+			AddDistance(p->GetObjectA(), p->GetObjectB(), p->GetDistance(), p->GetCompliance());
+		}
+		else if (ChainConstraint* c = dynamic_cast<ChainConstraint*>(*i)) {
+			for (int link = 0; link < c->GetNumLinks(); ++link) {
+				AddDistance(c->GetLink(link), c->GetLink(link + 1), c->GetLinkDistance(link), c->GetCompliance());
+			}
+		}
+		else {
+			unsupportedConstraints.push_back(*i);
+		}
+	}
+	distanceA.resize(distanceLength.size());
+	distanceB.resize(distanceLength.size());
+	distanceLambda.resize(distanceLength.size());
+}
+
+void XPBDSolver::AddDistance(GameObject* a, GameObject* b, float distance, float compliance) {
+	distanceObjectA.push_back(a);
+	distanceObjectB.push_back(b);
+	distanceLength.push_back(distance);
+	distanceCompliance.push_back(compliance);
+}
+
+int XPBDSolver::GetBody(GameObject* o) const {
+	auto i = bodyIndices.find(o);
+	return i == bodyIndices.end() ? -1 : i->second;
+}
+
+/*
+Collision detection only runs once per step, so the contact normal stays
+the same throughout the substeps - but the penetration is worked out again
+every time from how far the objects have moved since it was found.
+*/
+void XPBDSolver::AddContact(const CollisionDetection::CollisionInfo& info) {
+	int a = GetBody(info.a);
+	int b = GetBody(info.b);
+	if (a < 0 || b < 0 || inverseMass[a] + inverseMass[b] <= 0.0f) {
+		return;
+	}
+	contactA.push_back(a);
+	contactB.push_back(b);
+	contactNormalX.push_back(info.point.normal.x);
+	contactNormalY.push_back(info.point.normal.y);
+	contactNormalZ.push_back(info.point.normal.z);
+	contactPenetration.push_back(info.point.penetration);
+}
+
+void XPBDSolver::Solve(float dt, const Vector3& gravity, PhysicsStats& stats) {
+	float h = dt / (float)substeps;
+
+	for (size_t i = 0; i < distanceLength.size(); ++i) {
+		distanceA[i] = GetBody(distanceObjectA[i]);
+		distanceB[i] = GetBody(distanceObjectB[i]);
+	}
+	contactLambda.resize(contactA.size());
+	contactNormalSpeed.resize(contactA.size());
+
+	for (int s = 0; s < substeps; ++s) {
+		Timepoint phaseStart = PhysicsStats::Now();
+		Integrate(h, gravity);
+		stats.AddPhaseTime(PhysicsPhase::IntegrateAccel, phaseStart);
+
+		phaseStart = PhysicsStats::Now();
+		SolveDistances(h);
+		stats.AddPhaseTime(PhysicsPhase::Constraints, phaseStart);
+
+		phaseStart = PhysicsStats::Now();
+		SolveContacts(h);
+		stats.AddPhaseTime(PhysicsPhase::Solver, phaseStart);
+
+		phaseStart = PhysicsStats::Now();
+		UpdateVelocities(h);
+		stats.AddPhaseTime(PhysicsPhase::IntegrateVelocity, phaseStart);
+
+		phaseStart = PhysicsStats::Now();
+		SolveContactVelocities(h);
+		stats.AddPhaseTime(PhysicsPhase::Solver, phaseStart);
+	}
+}
+
+/*
+Moves everything along by its velocity, remembering where it started, so
+we can get the velocity back out afterwards. Before anything moves, the
+speed each contact is closing at is stored, so we know how hard to bounce.
+Each constraint is only solved once per substep, so the lambdas all start
+again from 0.
+*/
+void XPBDSolver::Integrate(float h, const Vector3& gravity) {
+	for (size_t c = 0; c < contactA.size(); ++c) {
+		int a = contactA[c];
+		int b = contactB[c];
+		contactNormalSpeed[c] =
+			(velX[b] - velX[a]) * contactNormalX[c] +
+			(velY[b] - velY[a]) * contactNormalY[c] +
+			(velZ[b] - velZ[a]) * contactNormalZ[c];
+		contactLambda[c] = 0.0f;
+	}
+	for (size_t c = 0; c < distanceLambda.size(); ++c) {
+		distanceLambda[c] = 0.0f;
+	}
+
+	int numBodies = (int)bodies.size();
+	prevX = posX;
+	prevY = posY;
+	prevZ = posZ;
+	for (int i = 0; i < numBodies; ++i) {
+		float g = inverseMass[i] > 0.0f ? 1.0f : 0.0f;
+		velX[i] += (gravity.x * g + accelX[i]) * h;
+		velY[i] += (gravity.y * g + accelY[i]) * h;
+		velZ[i] += (gravity.z * g + accelZ[i]) * h;
+	}
+	for (int i = 0; i < numBodies; ++i) {
+		posX[i] += velX[i] * h;
+		posY[i] += velY[i] * h;
+		posZ[i] += velZ[i] * h;
+	}
+}
+
+/*
+The compliance is scaled by the substep length squared, which is what lets
+the stiffness stay the same no matter how many substeps we take.
+*/
+void XPBDSolver::SolveDistances(float h) {
+	float invH2 = 1.0f / (h * h);
+	for (size_t c = 0; c < distanceLength.size(); ++c) {
+		int a = distanceA[c];
+		int b = distanceB[c];
+		if (a < 0 || b < 0) {
+			continue;
+		}
+		float w = inverseMass[a] + inverseMass[b];
+		if (w <= 0.0f) {
+			continue;
+		}
+		Vector3 delta	= GetPosition(b) - GetPosition(a);
+		float length	= delta.Length();
+		if (length <= 0.0f) {
+			continue;
+		}
+		Vector3 n		= delta / length;
+		float error		= length - distanceLength[c];
+		float alpha		= distanceCompliance[c] * invH2;
+		float lambda	= (-error - alpha * distanceLambda[c]) / (w + alpha);
+		distanceLambda[c] += lambda;
+
+		MoveBody(a, n * (-inverseMass[a] * lambda));
+		MoveBody(b, n * (inverseMass[b] * lambda));
+	}
+}
+
+/*
+Contacts can only push, never pull. If the contact is pressing hard enough,
+static friction then stops the objects sliding over each other at all,
+by taking the sideways part of this substep's movement back out.
+*/
+void XPBDSolver::SolveContacts(float h) {
+	float alpha = contactCompliance / (h * h);
+	for (size_t c = 0; c < contactA.size(); ++c) {
+		int a = contactA[c];
+		int b = contactB[c];
+		Vector3 n(contactNormalX[c], contactNormalY[c], contactNormalZ[c]);
+
+		Vector3 movedA(posX[a] - startX[a], posY[a] - startY[a], posZ[a] - startZ[a]);
+		Vector3 movedB(posX[b] - startX[b], posY[b] - startY[b], posZ[b] - startZ[b]);
+		float penetration = contactPenetration[c] - Vector3::Dot(movedB - movedA, n);
+		if (penetration <= 0.0f) {
+			continue;
+		}
+		float w			= inverseMass[a] + inverseMass[b];
+		float lambda	= (penetration - alpha * contactLambda[c]) / (w + alpha);
+		contactLambda[c] += lambda;
+
+		MoveBody(a, n * (-inverseMass[a] * lambda));
+		MoveBody(b, n * (inverseMass[b] * lambda));
+
+		float mu = std::sqrt(friction[a] * friction[a] + friction[b] * friction[b]);
+
+		Vector3 stepA(posX[a] - prevX[a], posY[a] - prevY[a], posZ[a] - prevZ[a]);
+		Vector3 stepB(posX[b] - prevX[b], posY[b] - prevY[b], posZ[b] - prevZ[b]);
+		Vector3 slide = stepA - stepB;
+		slide -= n * Vector3::Dot(slide, n);
+
+		if (slide.Length() < mu * contactLambda[c] * w) {
+			MoveBody(a, slide * (-inverseMass[a] / w));
+			MoveBody(b, slide * (inverseMass[b] / w));
+		}
+	}
+}
+
+void XPBDSolver::UpdateVelocities(float h) {
+	float invH = 1.0f / h;
+	int numBodies = (int)bodies.size();
+	for (int i = 0; i < numBodies; ++i) {
+		if (inverseMass[i] <= 0.0f) {
+			continue;
+		}
+		velX[i] = (posX[i] - prevX[i]) * invH;
+		velY[i] = (posY[i] - prevY[i]) * invH;
+		velZ[i] = (posZ[i] - prevZ[i]) * invH;
+	}
+}
+
+/*
+Things that can't be done by moving positions around - sliding friction
+slows the objects down by however much the contact was pushed this substep,
+and the normal velocity is replaced by a bounce based on how fast they were
+closing before we started. Really slow contacts don't bounce at all, or
+resting objects would jitter forever.
+*/
+void XPBDSolver::SolveContactVelocities(float h) {
+	const float restingSpeed = 0.1f;
+
+	for (size_t c = 0; c < contactA.size(); ++c) {
+		if (contactLambda[c] <= 0.0f) {
+			continue;
+		}
+		int a = contactA[c];
+		int b = contactB[c];
+		Vector3 n(contactNormalX[c], contactNormalY[c], contactNormalZ[c]);
+
+		Vector3 relativeVel	= GetVelocity(b) - GetVelocity(a);
+		float normalSpeed	= Vector3::Dot(relativeVel, n);
+		Vector3 sliding		= relativeVel - n * normalSpeed;
+		float slideSpeed	= sliding.Length();
+
+		Vector3 change;
+		if (slideSpeed > 0.0f) {
+			float mu		= std::sqrt(friction[a] * friction[a] + friction[b] * friction[b]);
+			float slowdown	= mu * contactLambda[c] / h;
+			if (slowdown > slideSpeed) {
+				slowdown = slideSpeed;
+			}
+			change -= sliding * (slowdown / slideSpeed);
+		}
+
+		float restitution = (elasticity[a] + elasticity[b]) * 0.5f;
+		if (std::abs(normalSpeed) < restingSpeed) {
+			restitution = 0.0f;
+		}
+		float bounce = -restitution * contactNormalSpeed[c];
+		if (bounce < 0.0f) {
+			bounce = 0.0f;
+		}
+		change += n * (bounce - normalSpeed);
+
+		float w = inverseMass[a] + inverseMass[b];
+		AddVelocity(a, change * (-inverseMass[a] / w));
+		AddVelocity(b, change * (inverseMass[b] / w));
+	}
+}
+
+/*
+Only now do the transforms get touched, once per step rather than once
+per substep. Rotation is integrated the same way as in the impulse solver.
+*/
+void XPBDSolver::StoreBodies(float dt) {
+	for (size_t i = 0; i < bodies.size(); ++i) {
+		GameObject*		object		= bodies[i];
+		PhysicsObject*	phys		= object->GetPhysicsObject();
+		Transform&		transform	= object->GetTransform();
+
+		float damping = 1.0f - (friction[i] * dt);
+
+		transform.SetPosition(GetPosition(i));
+		phys->SetLinearVelocity(GetVelocity(i) * damping);
+
+		Vector3 angVel = phys->GetAngularVelocity();
+		angVel += phys->GetInertiaTensor() * phys->GetTorque() * friction[i] * dt;
+
+		Quaternion orientation = transform.GetOrientation();
+		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
+		orientation.Normalise();
+		transform.SetOrientation(orientation);
+
+		phys->SetAngularVelocity(angVel * damping);
+	}
+}
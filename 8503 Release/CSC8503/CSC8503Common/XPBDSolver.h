@@ -0,0 +1,141 @@
+#pragma once
+#include "CollisionDetection.h"
+#include "../../Common/Vector3.h"
+#include <vector>
+#include <unordered_map>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class GameWorld;
+		class Constraint;
+		class PhysicsStats;
+
+		/*
+		An extended position based dynamics (XPBD) solver. Rather than
+		nudging velocities a little bit, over and over again, each step is
+		cut into a number of small substeps - in each one, every object is
+		moved by its velocity, the constraints move the positions straight
+		back to where they should be, and the velocity is then worked out
+		from how far things actually moved.
+
+		How stiff a constraint is depends on its compliance (the inverse of
+		its stiffness, in metres per newton), rather than on how many times
+		the solver gets run, so 0 is completely rigid however many substeps
+		we use. Bodies are stored as separate arrays of x, y and z, so the
+		integration loops are nice and tight.
+
+		Only linear motion is handled here - rotations are still integrated
+		from the angular velocity, but contacts don't make things spin.
+		*/
+		class XPBDSolver {
+		public:
+			XPBDSolver();
+			~XPBDSolver();
+
+			void SetSubsteps(int count) {
+				substeps = count < 1 ? 1 : count;
+			}
+
+			int GetSubsteps() const {
+				return substeps;
+			}
+
+			//How 'squishy' contacts are - 0 is perfectly hard
+			void SetContactCompliance(float c) {
+				contactCompliance = c;
+			}
+
+			float GetContactCompliance() const {
+				return contactCompliance;
+			}
+
+			//Copies every object's state into the solver, ready for a step
+			void LoadBodies(GameWorld& world);
+			//Works out which constraints the solver can handle, and which
+			//will still need solving the old way afterwards
+			void LoadConstraints(GameWorld& world);
+
+			void AddContact(const CollisionDetection::CollisionInfo& info);
+
+			void Solve(float dt, const Vector3& gravity, PhysicsStats& stats);
+
+			//Copies the results back out into the objects
+			void StoreBodies(float dt);
+
+			const std::vector<Constraint*>& GetUnsupportedConstraints() const {
+				return unsupportedConstraints;
+			}
+
+			int GetNumContacts() const {
+				return (int)contactA.size();
+			}
+
+		protected:
+			void Integrate(float h, const Vector3& gravity);
+			void SolveDistances(float h);
+			void SolveContacts(float h);
+			void UpdateVelocities(float h);
+			void SolveContactVelocities(float h);
+
+			void AddDistance(GameObject* a, GameObject* b, float distance, float compliance);
+
+			int GetBody(GameObject* o) const;
+
+			Vector3 GetPosition(int i) const {
+				return Vector3(posX[i], posY[i], posZ[i]);
+			}
+
+			Vector3 GetVelocity(int i) const {
+				return Vector3(velX[i], velY[i], velZ[i]);
+			}
+
+			void MoveBody(int i, const Vector3& offset) {
+				posX[i] += offset.x;
+				posY[i] += offset.y;
+				posZ[i] += offset.z;
+			}
+
+			void AddVelocity(int i, const Vector3& change) {
+				velX[i] += change.x;
+				velY[i] += change.y;
+				velZ[i] += change.z;
+			}
+
+			int		substeps;
+			float	contactCompliance;
+
+			//Bodies
+			std::vector<GameObject*>	bodies;
+			std::unordered_map<GameObject*, int> bodyIndices;
+			std::vector<float>			posX, posY, posZ;
+			std::vector<float>			prevX, prevY, prevZ;	//at the start of the substep
+			std::vector<float>			startX, startY, startZ;	//at the start of the step
+			std::vector<float>			velX, velY, velZ;
+			std::vector<float>			accelX, accelY, accelZ;	//from forces added to the object
+			std::vector<float>			inverseMass;
+			std::vector<float>			friction;
+			std::vector<float>			elasticity;
+
+			//Distance constraints
+			std::vector<GameObject*>	distanceObjectA;
+			std::vector<GameObject*>	distanceObjectB;
+			std::vector<int>			distanceA;
+			std::vector<int>			distanceB;
+			std::vector<float>			distanceLength;
+			std::vector<float>			distanceCompliance;
+			std::vector<float>			distanceLambda;
+			std::vector<Constraint*>	unsupportedConstraints;
+			int							loadedConstraintVersion;
+
+			//Contacts, found once per step
+			std::vector<int>			contactA;
+			std::vector<int>			contactB;
+			std::vector<float>			contactNormalX, contactNormalY, contactNormalZ;
+			std::vector<float>			contactPenetration;
+			std::vector<float>			contactLambda;
+			std::vector<float>			contactNormalSpeed;	//before the substep, for bouncing
+		};
+	}
+}
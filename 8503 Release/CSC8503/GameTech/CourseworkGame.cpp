@@ -5,16 +5,26 @@
 #include "../../Plugins/OpenGLRendering/OGLTexture.h"
 #include "../../Common/TextureLoader.h"
 #include "../CSC8503Common/PositionConstraint.h"
+#include "../CSC8503Common/ChainConstraint.h"
 #include "../CSC8503Common/StateObstacleObject.h"
+#include "../CSC8503Common/NavigationAssets.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace NCL;
 using namespace CSC8503;
 
+//What the enemies' planners think it costs to go through a cell with an obstacle over it
+const float OBSTACLE_COST = 20.0f;
+
 CourseworkGame::CourseworkGame() {
 	machine = new PushdownMachine(new IntroScreen(this));
 	world = new GameWorld();
 	renderer = new GameTechRenderer(*world);
 	physics = new PhysicsSystem(*world);
+	jobSystem = new JobSystem();
+	physics->SetJobSystem(jobSystem);
+	physicsThread = new PhysicsThread(*physics, *world);
 
 	Debug::SetRenderer(renderer);
 
@@ -46,6 +56,13 @@ void CourseworkGame::InitialiseAssets() {
 
 		basicTex = (OGLTexture*)TextureLoader::LoadAPITexture("checkerboard.png");
 		basicShader = new OGLShader("GameTechVert.glsl", "GameTechFrag.glsl");
+
+		//Every enemy paths across the same map, to the same end area
+		navGrid = NavigationAssets::GetGrid("TestGrid1.txt");
+		goalField = new FlowField(*navGrid, Vector3(90, 0, 0));
+		pathService = new PathfindingService(*navGrid);
+
+		InitialisePrefabs();
 		
 		initialised = true;
 	}
@@ -53,7 +70,54 @@ void CourseworkGame::InitialiseAssets() {
 	InitWorld();
 }
 
+/*
+
+Everything the level spawns lots of copies of. These only need setting up
+once - the inertia is worked out here, rather than for every copy.
+
+*/
+void CourseworkGame::InitialisePrefabs() {
+	coinPrefab = new Prefab("Coin");
+	coinPrefab->SetBoundingVolume((CollisionVolume*)new SphereVolume(0.25f))
+		.SetScale(Vector3(0.25, 0.25, 0.25))
+		.SetInverseMass(0)
+		.SetFriction(1)
+		.SetElasticity(0)
+		.SetInertia(PrefabInertia::Sphere)
+		.SetRenderObject(bonusMesh, nullptr, basicShader);
+
+	float meshSize = 3.0f;
+	enemyPrefab = new Prefab("Enemy");
+	enemyPrefab->SetBoundingVolume((CollisionVolume*)new AABBVolume(Vector3(0.3f, 0.9f, 0.3f) * meshSize))
+		.SetScale(Vector3(meshSize, meshSize, meshSize))
+		.SetInverseMass(0.5f)
+		.SetFriction(1)
+		.SetElasticity(0)
+		.SetInertia(PrefabInertia::Sphere)
+		.SetRenderObject(enemyMesh, nullptr, basicShader);
+
+	Vector3 plankSize = Vector3(1, 0.1, 2);
+	plankPrefab = new Prefab("World");
+	plankPrefab->SetBoundingVolume((CollisionVolume*)new AABBVolume(plankSize))
+		.SetScale(plankSize * 2)
+		.SetInverseMass(5)
+		.SetRenderObject(cubeMesh, basicTex, basicShader);
+
+	anchorPrefab = new Prefab("World");
+	anchorPrefab->SetBoundingVolume((CollisionVolume*)new AABBVolume(plankSize))
+		.SetScale(plankSize * 2)
+		.SetInverseMass(0)
+		.SetRenderObject(cubeMesh, basicTex, basicShader);
+}
+
 CourseworkGame::~CourseworkGame() {
+	delete coinPrefab;
+	delete enemyPrefab;
+	delete plankPrefab;
+	delete anchorPrefab;
+	delete goalField;
+	NavigationAssets::Clear();
+
 	delete cubeMesh;
 	delete sphereMesh;
 	delete charMeshA;
@@ -64,16 +128,13 @@ CourseworkGame::~CourseworkGame() {
 	delete basicTex;
 	delete basicShader;
 
+	delete physicsThread;
 	delete physics;
+	delete jobSystem;
 	delete renderer;
+	world->ClearAndErase();
 	delete world;
-	delete player;
-	for (auto& i: enemies) {
-		delete i;
-	}
-	for (auto& i : obstacles) {
-		delete i;
-	}
+	delete pathService; //the enemies cancel their requests with it as they're deleted
 }
 
 void CourseworkGame::DrawMainMenu() {
@@ -84,9 +145,16 @@ void CourseworkGame::DrawMainMenu() {
 	renderer->DrawString("Press 'M' for multiplayer with AI", Vector2(30, 50));
 	renderer->DrawString("Press Esc to quit", Vector2(30, 70));
 	renderer->Render();
+	//This is called every frame the menu is up, but the level only
+	//needs tearing down the once
+	if (world->GetNumObjects() == 0) {
+		return;
+	}
+	physicsThread->Stop();
 	world->ClearAndErase();
 	enemies.clear();
 	obstacles.clear();
+	obstacleCells.clear();
 	player = nullptr;
 	physics->Clear();
 	winnerName.clear();
@@ -123,22 +191,37 @@ void CourseworkGame::UpdateGame(float dt) {
 
 
 		UpdateKeys();
-		if (multi) {
-			for (StateGameObject* e : enemies) {
-				e->Update(dt);
+		pathService->BeginFrame();
+		UpdateObstacleCells();
+		//Enemies and obstacles are all agents - enemies only exist in multiplayer
+		world->GetEntities().ForEachChunk(ComponentBit(ComponentType::AIAgent),
+			[&](ArchetypeChunk& chunk) {
+				const AIAgentComponent* agents = chunk.Get<AIAgentComponent>();
+				for (int i = 0; i < chunk.GetCount(); ++i) {
+					agents[i].agent->Update(dt);
+				}
+			}
+		);
+
+		//With physics on its own thread, the game just picks up wherever
+		//physics has got to - raycasting for selection would have to read
+		//the objects while they're being moved, so it's not allowed
+		if (threadedPhysics) {
+			if (!physicsThread->IsRunning()) {
+				physicsThread->Start();
 			}
+			physicsThread->ApplySnapshot();
 		}
-		for (StateObstacleObject* e : obstacles) {
-			e->Update(dt);
+		else {
+			physicsThread->Stop();
+			SelectObject();
+			MoveSelectedObject();
+			physics->Update(dt);
 		}
 
-		SelectObject();
-		MoveSelectedObject();
-		physics->Update(dt);
-
 		if (lockedObject != nullptr) {
-			Vector3 objPos = lockedObject->GetTransform().GetPosition();
-			Vector3 camPos = objPos + (lockedObject->GetTransform().GetOrientation() * Vector3(0, min(max(0, lockedPitch), 45), 20));
+			Vector3 objPos = lockedObject->GetGamePosition();
+			Vector3 camPos = objPos + (lockedObject->GetGameOrientation() * Vector3(0, min(max(0, lockedPitch), 45), 20));
 
 			Matrix4 temp = Matrix4::BuildViewMatrix(camPos, objPos, Vector3(0, 1, 0));
 
@@ -157,48 +240,49 @@ void CourseworkGame::UpdateGame(float dt) {
 		if (elapsedTime <= 0 && player != nullptr) {
 			elapsedTime = 1.0f;
 			player->DecrementScore();
-			for (GameObject* e : enemies) {
-				e->DecrementScore();
+			for (GameObjectHandle h : enemies) {
+				if (GameObject* e = world->GetGameObject(h)) {
+					e->DecrementScore();
+				}
 			}
 		}
 		
 		renderer->DrawString("Current Score: " + std::to_string(player->GetScore()), Vector2(5, 80));
 		
 
-		world->UpdateWorld(dt);
+		if (!threadedPhysics) {
+			world->UpdateWorld(dt);
+		}
 		if (WinConditionMet(player)) {
 			winnerName = player->GetName();
 		}
 		else {
-			for (GameObject* e : enemies) {
-				if (WinConditionMet(e)) {
+			for (GameObjectHandle h : enemies) {
+				GameObject* e = world->GetGameObject(h);
+				if (e && WinConditionMet(e)) {
 					winnerName = e->GetName();
 				}
 			}
 		}
 
-		if (player->GetTransform().GetPosition().y < -5) {
-			player->GetTransform().SetPosition(Vector3(-20, 5, 20));
+		if (player->GetGamePosition().y < -5) {
+			player->MoveTo(Vector3(-20, 5, 20));
 		}
 
 		renderer->Update(dt);
 	}
 
+	//Anything destroyed this frame is only actually deleted now, once
+	//nothing else can be using it
+	if (!threadedPhysics) {
+		world->FlushRemovals();
+	}
 
 	Debug::FlushRenderables(dt);
 	renderer->Render();
 }
 
-void CourseworkGame::UpdateKeys() {
-
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F2)) {
-		inSelectionMode = !inSelectionMode;
-		if (inSelectionMode) {
-			InitCamera();
-		} else{
-			lockedObject = player;
-		}
-	}
+void CourseworkGame::UpdatePhysicsKeys() {
 	//Always use gravity
 	physics->UseGravity(true);
 	//Running certain physics updates in a consistent order might cause some
@@ -219,8 +303,94 @@ void CourseworkGame::UpdateKeys() {
 		world->ShuffleObjects(false);
 	}
 
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
+		physics->UseBroadPhase(!physics->IsUsingBroadPhase());
+		std::cout << "Setting broadphase to " << physics->IsUsingBroadPhase() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() - 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() + 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::X)) {
+		bool xpbd = physics->GetSolverMode() == SolverMode::XPBD;
+		physics->SetSolverMode(xpbd ? SolverMode::Impulse : SolverMode::XPBD);
+		std::cout << "Switching to the " << (xpbd ? "impulse" : "XPBD") << " solver" << std::endl;
+	}
+}
+
+void CourseworkGame::UpdateKeys() {
+
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F2)) {
+		inSelectionMode = !inSelectionMode;
+		if (inSelectionMode) {
+			InitCamera();
+		} else{
+			lockedObject = player;
+		}
+	}
+	//Shuffling, and B / I / O / X, change how physics steps - not while it's
+	//on its own thread though, as it could be half way through a step
+	if (!threadedPhysics) {
+		UpdatePhysicsKeys();
+	}
+	else {
+		const KeyboardKeys physicsKeys[] = { KeyboardKeys::F7, KeyboardKeys::F8, KeyboardKeys::F9, KeyboardKeys::F10,
+			KeyboardKeys::B, KeyboardKeys::I, KeyboardKeys::O, KeyboardKeys::X };
+		for (KeyboardKeys key : physicsKeys) {
+			if (Window::GetKeyboard()->KeyPressed(key)) {
+				std::cout << "Turn threaded physics off (F3) before changing how physics runs\n";
+				break;
+			}
+		}
+	}
+
+	//F11 puts everything back where it was when the level started, without
+	//having to rebuild it all
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F11)) {
+		physicsThread->Stop();
+		if (world->Restore(levelStart) && physics->Restore(levelStart)) {
+			std::cout << "Level reset\n";
+		}
+	}
+
+	//F3 moves physics on to its own thread, and back again
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F3)) {
+		threadedPhysics = !threadedPhysics;
+		std::cout << "Threaded physics " << (threadedPhysics ? "on" : "off") << "\n";
+	}
+
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F6)) {
-		std::cout << player->GetTransform().GetPosition();
+		std::cout << player->GetGamePosition();
+	}
+
+	//F12 changes how the enemies find their way about
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F12)) {
+		const char* names[] = { "D* Lite planners", "the flow field", "the pathfinding service" };
+		enemyPathing = (EnemyPathing)(((int)enemyPathing + 1) % (int)EnemyPathing::MAX_PATHING);
+		for (GameObjectHandle h : enemies) {
+			if (StateGameObject* enemy = (StateGameObject*)world->GetGameObject(h)) {
+				SetEnemyPathing(*enemy);
+			}
+		}
+		std::cout << "Enemies now pathfinding with " << names[(int)enemyPathing] << "\n";
+	}
+
+	//Physics profiling - F4 toggles a per-frame CSV dump, F5 prints the rolling stats
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F4)) {
+		if (physics->GetStats().IsDumping()) {
+			physics->GetStats().StopDump();
+			std::cout << "Stopped physics stats dump\n";
+		}
+		else if (physics->GetStats().StartDump("PhysicsStats.csv")) {
+			std::cout << "Dumping physics stats to PhysicsStats.csv\n";
+		}
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F5)) {
+		physics->GetStats().PrintSummary(std::cout);
 	}
 
 	if (lockedObject) {
@@ -245,8 +415,8 @@ void CourseworkGame::LockedObjectMovement() {
 	fwdAxis.y = 0.0f;
 	fwdAxis.Normalise();
 
-	Vector3 charForward = lockedObject->GetTransform().GetOrientation() * Vector3(0, 0, 1);
-	Vector3 charForward2 = lockedObject->GetTransform().GetOrientation() * Vector3(0, 0, 1);
+	Vector3 charForward = lockedObject->GetGameOrientation() * Vector3(0, 0, 1);
+	Vector3 charForward2 = lockedObject->GetGameOrientation() * Vector3(0, 0, 1);
 
 	float force = 50;
 
@@ -275,38 +445,39 @@ void CourseworkGame::LockedObjectMovement() {
 
 void CourseworkGame::DebugObjectMovement() {
 	//If we've selected an object, we can manipulate it with some key presses
-	if (inSelectionMode && selectionObject) {
+	GameObject* selected = world->GetGameObject(selectionObject);
+	if (inSelectionMode && selected) {
 		//Twist the selected object!
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::LEFT)) {
-			selectionObject->GetPhysicsObject()->AddTorque(Vector3(-10, 0, 0));
+			selected->GetPhysicsObject()->AddTorque(Vector3(-10, 0, 0));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::RIGHT)) {
-			selectionObject->GetPhysicsObject()->AddTorque(Vector3(10, 0, 0));
+			selected->GetPhysicsObject()->AddTorque(Vector3(10, 0, 0));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::NUM7)) {
-			selectionObject->GetPhysicsObject()->AddTorque(Vector3(0, 10, 0));
+			selected->GetPhysicsObject()->AddTorque(Vector3(0, 10, 0));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::NUM8)) {
-			selectionObject->GetPhysicsObject()->AddTorque(Vector3(0, -10, 0));
+			selected->GetPhysicsObject()->AddTorque(Vector3(0, -10, 0));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::RIGHT)) {
-			selectionObject->GetPhysicsObject()->AddTorque(Vector3(10, 0, 0));
+			selected->GetPhysicsObject()->AddTorque(Vector3(10, 0, 0));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::UP)) {
-			selectionObject->GetPhysicsObject()->AddForce(Vector3(0, 0, -10));
+			selected->GetPhysicsObject()->AddForce(Vector3(0, 0, -10));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::DOWN)) {
-			selectionObject->GetPhysicsObject()->AddForce(Vector3(0, 0, 10));
+			selected->GetPhysicsObject()->AddForce(Vector3(0, 0, 10));
 		}
 
 		if (Window::GetKeyboard()->KeyDown(KeyboardKeys::NUM5)) {
-			selectionObject->GetPhysicsObject()->AddForce(Vector3(0, -10, 0));
+			selected->GetPhysicsObject()->AddForce(Vector3(0, -10, 0));
 		}
 	}
 	
@@ -322,7 +493,12 @@ void CourseworkGame::InitCamera() {
 }
 
 void CourseworkGame::InitWorld() {
+	physicsThread->Stop();
 	world->ClearAndErase();
+	enemies.clear();
+	obstacles.clear();
+	obstacleCells.clear();
+	selectionObject = GameObjectHandle();
 	physics->Clear();
 	InitPlayer();
 	if (multi) {
@@ -335,29 +511,36 @@ void CourseworkGame::InitWorld() {
 	AddStateObstacleToWorld(Vector3(0, 4, 15));
 	AddStateObstacleToWorld(Vector3(8, 4, 10));
 	AddStateObstacleToWorld(Vector3(16, 4, 10));
+
+	world->Snapshot(levelStart);
+	physics->Snapshot(levelStart);
 }
 
 void CourseworkGame::BridgeConstraintTest() {
-	Vector3 cubeSize = Vector3(1, 0.1, 2);
-	float invCubeMass = 5;
 	int numLinks = 27;
 	float maxDistance = 1.5;
 	float cubeDistance = 2;
 
 	Vector3 startPos = Vector3(-29, -1, -35);
-	GameObject* start = AddCubeToWorld(startPos + Vector3(0, 0, 0), cubeSize, 0);
-	GameObject* end = AddCubeToWorld(startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0), cubeSize, 0);
-	GameObject* previous = start;
+	Vector3 ends[2] = {
+		startPos,
+		startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0)
+	};
+	GameObject* anchors = world->SpawnPrefab(*anchorPrefab, ends, 2);
 
+	vector<Vector3> linkPositions;
 	for (int i = 0; i < numLinks; i++) {
-		GameObject* block = AddCubeToWorld(startPos + Vector3((i + 1) * cubeDistance, 0, 0), cubeSize, invCubeMass);
-		
-		PositionConstraint* constraint = new PositionConstraint(previous, block, maxDistance);
-		world->AddConstraint(constraint);
-		previous = block;
+		linkPositions.emplace_back(startPos + Vector3((i + 1) * cubeDistance, 0, 0));
 	}
-	PositionConstraint* constraint = new PositionConstraint(previous, end, maxDistance);
-	world->AddConstraint(constraint);
+	GameObject* links = world->SpawnPrefab(*plankPrefab, linkPositions.data(), numLinks);
+
+	//The whole bridge is one chain, solved exactly every step
+	ChainConstraint* chain = world->Create<ChainConstraint>(&anchors[0]);
+	for (int i = 0; i < numLinks; i++) {
+		chain->AddLink(&links[i], maxDistance);
+	}
+	chain->AddLink(&anchors[1], maxDistance);
+	world->AddConstraint(chain);
 }
 
 /*
@@ -368,245 +551,67 @@ A single function to add a large immoveable cube to the bottom of our world
 vector<GameObject*> CourseworkGame::AddWallsToWorld(const Vector3& position) {
 	vector<GameObject*> walls;
 
-	GameObject* wall1 = new GameObject("Wall");
-	Vector3 wallSize1 = Vector3(40, 4, 4);
-	AABBVolume* volume1 = new AABBVolume(wallSize1);
-	wall1->SetBoundingVolume((CollisionVolume*)volume1);
-	wall1->GetTransform()
-		.SetScale(wallSize1 * 2)
-		.SetPosition(position + Vector3(-10, 6, 0));
-
-	wall1->SetRenderObject(new RenderObject(&wall1->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall1->SetPhysicsObject(new PhysicsObject(&wall1->GetTransform(), wall1->GetBoundingVolume()));
-
-	wall1->GetPhysicsObject()->SetInverseMass(0);
-	wall1->GetPhysicsObject()->SetFriction(1);
-	wall1->GetPhysicsObject()->SetElasticity(0.5);
-	wall1->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall1);
-	walls.push_back(wall1);
-
-	GameObject* wall2 = new GameObject("Wall");
-	Vector3 wallSize2 = Vector3(40, 4, 4);
-	AABBVolume* volume2 = new AABBVolume(wallSize2);
-	wall2->SetBoundingVolume((CollisionVolume*)volume2);
-	wall2->GetTransform()
-		.SetScale(wallSize2 * 2)
-		.SetPosition(Vector3(10, 4, -23));
-
-	wall2->SetRenderObject(new RenderObject(&wall2->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall2->SetPhysicsObject(new PhysicsObject(&wall2->GetTransform(), wall2->GetBoundingVolume()));
-
-	wall2->GetPhysicsObject()->SetInverseMass(0);
-	wall2->GetPhysicsObject()->SetFriction(1);
-	wall2->GetPhysicsObject()->SetElasticity(0.5);
-	wall2->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall2);
-	walls.push_back(wall2);
-
-	GameObject* wall3 = new GameObject("Wall");
-	Vector3 wallSize3 = Vector3(40, 4, 4);
-	AABBVolume* volume3 = new AABBVolume(wallSize3);
-	wall3->SetBoundingVolume((CollisionVolume*)volume3);
-	wall3->GetTransform()
-		.SetScale(wallSize3 * 2)
-		.SetPosition(position + Vector3(-10, 6, -45));
-
-	wall3->SetRenderObject(new RenderObject(&wall3->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall3->SetPhysicsObject(new PhysicsObject(&wall3->GetTransform(), wall3->GetBoundingVolume()));
-
-	wall3->GetPhysicsObject()->SetInverseMass(0);
-	wall3->GetPhysicsObject()->SetFriction(1);
-	wall3->GetPhysicsObject()->SetElasticity(0.5);
-	wall3->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall3);
-	walls.push_back(wall3);
-
-	GameObject* wall4 = new GameObject("Wall");
-	Vector3 wallSize4 = Vector3(40, 4, 4);
-	AABBVolume* volume4 = new AABBVolume(wallSize4);
-	wall4->SetBoundingVolume((CollisionVolume*)volume4);
-	wall4->GetTransform()
-		.SetScale(wallSize4 * 2)
-		.SetPosition(position + Vector3(10, 6, -70));
-
-	wall4->SetRenderObject(new RenderObject(&wall4->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall4->SetPhysicsObject(new PhysicsObject(&wall4->GetTransform(), wall4->GetBoundingVolume()));
-
-	wall4->GetPhysicsObject()->SetInverseMass(0);
-	wall4->GetPhysicsObject()->SetFriction(1);
-	wall4->GetPhysicsObject()->SetElasticity(0.5);
-	wall4->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall4);
-	walls.push_back(wall4);
-
-	GameObject* wall5 = new GameObject("Wall");
-	Vector3 wallSize5 = Vector3(50, 4, 4);
-	AABBVolume* volume5 = new AABBVolume(wallSize5);
-	wall5->SetBoundingVolume((CollisionVolume*)volume5);
-	wall5->GetTransform()
-		.SetScale(wallSize5 * 2)
-		.SetPosition(Vector3(0, 4, 29));
-
-	wall5->SetRenderObject(new RenderObject(&wall5->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall5->SetPhysicsObject(new PhysicsObject(&wall5->GetTransform(), wall5->GetBoundingVolume()));
-
-	wall5->GetPhysicsObject()->SetInverseMass(0);
-	wall5->GetPhysicsObject()->SetFriction(1);
-	wall5->GetPhysicsObject()->SetElasticity(0.5);
-	wall5->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall5);
-	walls.push_back(wall5);
-
-	GameObject* wall6 = new GameObject("Wall");
-	Vector3 wallSize6 = Vector3(50, 4, 4);
-	AABBVolume* volume6 = new AABBVolume(wallSize6);
-	wall6->SetBoundingVolume((CollisionVolume*)volume6);
-	wall6->GetTransform()
-		.SetScale(wallSize6 * 2)
-		.SetPosition(Vector3(0, 4, -99));
-
-	wall6->SetRenderObject(new RenderObject(&wall6->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall6->SetPhysicsObject(new PhysicsObject(&wall6->GetTransform(), wall6->GetBoundingVolume()));
-
-	wall6->GetPhysicsObject()->SetInverseMass(0);
-	wall6->GetPhysicsObject()->SetFriction(1);
-	wall6->GetPhysicsObject()->SetElasticity(0.5);
-	wall6->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall6);
-	walls.push_back(wall6);
-
-	GameObject* wall7 = new GameObject("Wall");
-	Vector3 wallSize7 = Vector3(4, 4, 60);
-	AABBVolume* volume7 = new AABBVolume(wallSize7);
-	wall7->SetBoundingVolume((CollisionVolume*)volume7);
-	wall7->GetTransform()
-		.SetScale(wallSize7 * 2)
-		.SetPosition(Vector3(54, 4, -60 + 25));
-
-	wall7->SetRenderObject(new RenderObject(&wall7->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall7->SetPhysicsObject(new PhysicsObject(&wall7->GetTransform(), wall7->GetBoundingVolume()));
-
-	wall7->GetPhysicsObject()->SetInverseMass(0);
-	wall7->GetPhysicsObject()->SetFriction(1);
-	wall7->GetPhysicsObject()->SetElasticity(0.5);
-	wall7->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall7);
-	walls.push_back(wall7);
-
-	GameObject* wall8 = new GameObject("Wall");
-	Vector3 wallSize8 = Vector3(4, 4, 60);
-	AABBVolume* volume8 = new AABBVolume(wallSize8);
-	wall8->SetBoundingVolume((CollisionVolume*)volume8);
-	wall8->GetTransform()
-		.SetScale(wallSize8 * 2)
-		.SetPosition(Vector3(-54, 4, -60 + 25));
-
-	wall8->SetRenderObject(new RenderObject(&wall8->GetTransform(), cubeMesh, basicTex, basicShader));
-	wall8->SetPhysicsObject(new PhysicsObject(&wall8->GetTransform(), wall8->GetBoundingVolume()));
-
-	wall8->GetPhysicsObject()->SetInverseMass(0);
-	wall8->GetPhysicsObject()->SetFriction(1);
-	wall8->GetPhysicsObject()->SetElasticity(0.5);
-	wall8->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(wall8);
-	walls.push_back(wall8);
+	vector<GameObject*> added = AddStaticBoxesToWorld("Wall", Vector3(40, 4, 4), 0.5f, {
+		position + Vector3(-10, 6, 0),
+		Vector3(10, 4, -23),
+		position + Vector3(-10, 6, -45),
+		position + Vector3(10, 6, -70)
+	});
+	walls.insert(walls.end(), added.begin(), added.end());
+
+	added = AddStaticBoxesToWorld("Wall", Vector3(50, 4, 4), 0.5f, {
+		Vector3(0, 4, 29),
+		Vector3(0, 4, -99)
+	});
+	walls.insert(walls.end(), added.begin(), added.end());
+
+	added = AddStaticBoxesToWorld("Wall", Vector3(4, 4, 60), 0.5f, {
+		Vector3(54, 4, -60 + 25),
+		Vector3(-54, 4, -60 + 25)
+	});
+	walls.insert(walls.end(), added.begin(), added.end());
 
 	return walls;
 }
 
 vector<GameObject*> CourseworkGame::AddFloorToWorld(const Vector3& position) {
 	vector<GameObject*> floors;
-	
-	GameObject* floor = new GameObject("World");
-
-	Vector3 floorSize = Vector3(50, 2, 25);
-	AABBVolume* volume = new AABBVolume(floorSize);
-	floor->SetBoundingVolume((CollisionVolume*)volume);
-	floor->GetTransform()
-		.SetScale(floorSize * 2)
-		.SetPosition(position);
-
-	floor->SetRenderObject(new RenderObject(&floor->GetTransform(), cubeMesh, basicTex, basicShader));
-	floor->SetPhysicsObject(new PhysicsObject(&floor->GetTransform(), floor->GetBoundingVolume()));
-
-	floor->GetPhysicsObject()->SetInverseMass(0);
-	floor->GetPhysicsObject()->SetFriction(1);
-	floor->GetPhysicsObject()->SetElasticity(0);
-	floor->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(floor);
-	floors.push_back(floor);
 
-	GameObject* floor2 = new GameObject("World");
+	vector<GameObject*> added = AddStaticBoxesToWorld("World", Vector3(50, 2, 25), 0, {
+		position,
+		position + Vector3(0, 0, -70)
+	});
+	floors.insert(floors.end(), added.begin(), added.end());
 
-	Vector3 floorSize2 = Vector3(10, 2, 10);
-	AABBVolume* volume2 = new AABBVolume(floorSize2);
-	floor2->SetBoundingVolume((CollisionVolume*)volume2);
-	floor2->GetTransform()
-		.SetScale(floorSize2 * 2)
-		.SetPosition(position + Vector3(-40, 0, -35));
+	added = AddStaticBoxesToWorld("World", Vector3(10, 2, 10), 0, {
+		position + Vector3(-40, 0, -35),
+		position + Vector3(40, 0, -35)
+	});
+	floors.insert(floors.end(), added.begin(), added.end());
 
-	floor2->SetRenderObject(new RenderObject(&floor2->GetTransform(), cubeMesh, basicTex, basicShader));
-	floor2->SetPhysicsObject(new PhysicsObject(&floor2->GetTransform(), floor2->GetBoundingVolume()));
-
-	floor2->GetPhysicsObject()->SetInverseMass(0);
-	floor2->GetPhysicsObject()->SetFriction(1);
-	floor2->GetPhysicsObject()->SetElasticity(0);
-	floor2->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(floor2);
-	floors.push_back(floor2);
-
-	GameObject* floor3 = new GameObject("World");
-
-	Vector3 floorSize3 = Vector3(10, 2, 10);
-	AABBVolume* volume3 = new AABBVolume(floorSize3);
-	floor3->SetBoundingVolume((CollisionVolume*)volume3);
-	floor3->GetTransform()
-		.SetScale(floorSize3 * 2)
-		.SetPosition(position + Vector3(40, 0, -35));
-
-	floor3->SetRenderObject(new RenderObject(&floor3->GetTransform(), cubeMesh, basicTex, basicShader));
-	floor3->SetPhysicsObject(new PhysicsObject(&floor3->GetTransform(), floor3->GetBoundingVolume()));
-
-	floor3->GetPhysicsObject()->SetInverseMass(0);
-	floor3->GetPhysicsObject()->SetFriction(1);
-	floor3->GetPhysicsObject()->SetElasticity(0);
-	floor3->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(floor3);
-	floors.push_back(floor3);
-
-	GameObject* floor4 = new GameObject("World");
-	
-	Vector3 floorSize4 = Vector3(50, 2, 25);
-	AABBVolume* volume4 = new AABBVolume(floorSize4);
-	floor4->SetBoundingVolume((CollisionVolume*)volume4);
-	floor4->GetTransform()
-		.SetScale(floorSize4 * 2)
-		.SetPosition(position + Vector3(0, 0, -70));
-
-	floor4->SetRenderObject(new RenderObject(&floor4->GetTransform(), cubeMesh, basicTex, basicShader));
-	floor4->SetPhysicsObject(new PhysicsObject(&floor4->GetTransform(), floor4->GetBoundingVolume()));
+	return floors;
+}
 
-	floor4->GetPhysicsObject()->SetInverseMass(0);
-	floor4->GetPhysicsObject()->SetFriction(1);
-	floor4->GetPhysicsObject()->SetElasticity(0);
-	floor4->GetPhysicsObject()->InitCubeInertia();
+/*
+Walls and floors come in a few different sizes, so each size just gets a
+prefab of its own for as long as it takes to spawn them.
+*/
+vector<GameObject*> CourseworkGame::AddStaticBoxesToWorld(const string& name, const Vector3& halfSize, float elasticity, const vector<Vector3>& positions) {
+	Prefab box(name);
+	box.SetBoundingVolume((CollisionVolume*)new AABBVolume(halfSize))
+		.SetScale(halfSize * 2)
+		.SetInverseMass(0)
+		.SetFriction(1)
+		.SetElasticity(elasticity)
+		.SetRenderObject(cubeMesh, basicTex, basicShader);
 
-	world->AddGameObject(floor4);
-	floors.push_back(floor4);
+	GameObject* spawned = world->SpawnPrefab(box, positions.data(), (int)positions.size());
 
-	return floors;
+	vector<GameObject*> boxes;
+	for (int i = 0; i < (int)positions.size(); ++i) {
+		boxes.emplace_back(&spawned[i]);
+	}
+	return boxes;
 }
 
 /*
@@ -617,18 +622,18 @@ physics worlds. You'll probably need another function for the creation of OBB cu
 
 */
 GameObject* CourseworkGame::AddSphereToWorld(const Vector3& position, float radius, float inverseMass) {
-	GameObject* sphere = new GameObject();
+	GameObject* sphere = world->Create<GameObject>();
 
 	Vector3 sphereSize = Vector3(radius, radius, radius);
-	SphereVolume* volume = new SphereVolume(radius);
+	SphereVolume* volume = world->Create<SphereVolume>(radius);
 	sphere->SetBoundingVolume((CollisionVolume*)volume);
 
 	sphere->GetTransform()
 		.SetScale(sphereSize)
 		.SetPosition(position);
 
-	sphere->SetRenderObject(new RenderObject(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
-	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+	sphere->SetRenderObject(world->Create<RenderObject>(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
+	sphere->SetPhysicsObject(world->Create<PhysicsObject>(&sphere->GetTransform(), sphere->GetBoundingVolume()));
 
 	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
 	sphere->GetPhysicsObject()->InitSphereInertia();
@@ -639,17 +644,17 @@ GameObject* CourseworkGame::AddSphereToWorld(const Vector3& position, float radi
 }
 
 GameObject* CourseworkGame::AddCapsuleToWorld(const Vector3& position, float halfHeight, float radius, float inverseMass) {
-	GameObject* capsule = new GameObject();
+	GameObject* capsule = world->Create<GameObject>();
 
-	CapsuleVolume* volume = new CapsuleVolume(halfHeight, radius);
+	CapsuleVolume* volume = world->Create<CapsuleVolume>(halfHeight, radius);
 	capsule->SetBoundingVolume((CollisionVolume*)volume);
 
 	capsule->GetTransform()
 		.SetScale(Vector3(radius * 2, halfHeight, radius * 2))
 		.SetPosition(position);
 
-	capsule->SetRenderObject(new RenderObject(&capsule->GetTransform(), capsuleMesh, basicTex, basicShader));
-	capsule->SetPhysicsObject(new PhysicsObject(&capsule->GetTransform(), capsule->GetBoundingVolume()));
+	capsule->SetRenderObject(world->Create<RenderObject>(&capsule->GetTransform(), capsuleMesh, basicTex, basicShader));
+	capsule->SetPhysicsObject(world->Create<PhysicsObject>(&capsule->GetTransform(), capsule->GetBoundingVolume()));
 
 	capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
 	capsule->GetPhysicsObject()->InitCubeInertia();
@@ -661,9 +666,9 @@ GameObject* CourseworkGame::AddCapsuleToWorld(const Vector3& position, float hal
 }
 
 GameObject* CourseworkGame::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass) {
-	GameObject* cube = new GameObject("World");
+	GameObject* cube = world->Create<GameObject>("World");
 
-	AABBVolume* volume = new AABBVolume(dimensions);
+	AABBVolume* volume = world->Create<AABBVolume>(dimensions);
 
 	cube->SetBoundingVolume((CollisionVolume*)volume);
 
@@ -671,8 +676,8 @@ GameObject* CourseworkGame::AddCubeToWorld(const Vector3& position, Vector3 dime
 		.SetPosition(position)
 		.SetScale(dimensions * 2);
 
-	cube->SetRenderObject(new RenderObject(&cube->GetTransform(), cubeMesh, basicTex, basicShader));
-	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+	cube->SetRenderObject(world->Create<RenderObject>(&cube->GetTransform(), cubeMesh, basicTex, basicShader));
+	cube->SetPhysicsObject(world->Create<PhysicsObject>(&cube->GetTransform(), cube->GetBoundingVolume()));
 
 	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
 	cube->GetPhysicsObject()->InitCubeInertia();
@@ -738,43 +743,28 @@ void CourseworkGame::InitPlayer()
 }
 
 void CourseworkGame::InitEnemies() {
-	for (int i = 0; i < 4; i++) {
-		StateGameObject* enemy = AddStateEnemyToWorld(Vector3(-30, 5, 30));
-		enemy->GetPhysicsObject()->SetElasticity(0);
-		enemy->GetPhysicsObject()->SetFriction(1);
-		enemies.emplace_back(enemy);
-		enemy->GetPhysicsObject()->SetElasticity(0);
-	}
+	vector<Vector3> positions(4, Vector3(-20, 5, 20));
+	SpawnEnemies(positions.data(), (int)positions.size());
 }
 
 void CourseworkGame::InitCoins() {
-	for (int i = 0; i < 6; i++) {
-		GameObject* coin = AddBonusToWorld(Vector3(-20 + (i * 10), 5, -10));
-		coin->GetPhysicsObject()->SetElasticity(0);
-		coin->GetPhysicsObject()->SetFriction(1);
-		coin->GetPhysicsObject()->SetInverseMass(0);
-	}
-	for (int i = 0; i < 6; i++) {
-		GameObject* coin = AddBonusToWorld(Vector3(-20 + (i * 10), 5, -35));
-		coin->GetPhysicsObject()->SetElasticity(0);
-		coin->GetPhysicsObject()->SetFriction(1);
-		coin->GetPhysicsObject()->SetInverseMass(0);
-	}
-	for (int i = 0; i < 6; i++) {
-		GameObject* coin = AddBonusToWorld(Vector3(-20 + (i * 10), 5, -55));
-		coin->GetPhysicsObject()->SetElasticity(0);
-		coin->GetPhysicsObject()->SetFriction(1);
-		coin->GetPhysicsObject()->SetInverseMass(0);
+	vector<Vector3> positions;
+	float rows[3] = { -10, -35, -55 };
+	for (float z : rows) {
+		for (int i = 0; i < 6; i++) {
+			positions.emplace_back(Vector3(-20 + (i * 10), 5, z));
+		}
 	}
+	world->SpawnPrefab(*coinPrefab, positions.data(), (int)positions.size());
 }
 
 GameObject* CourseworkGame::AddPlayerToWorld(const Vector3& position) {
 	float meshSize = 3.0f;
 	float inverseMass = 0.5f;
 
-	GameObject* character = new GameObject("Player");
+	GameObject* character = world->Create<GameObject>("Player");
 
-	AABBVolume* volume = new AABBVolume(Vector3(0.3f, 0.85f, 0.3f) * meshSize);
+	AABBVolume* volume = world->Create<AABBVolume>(Vector3(0.3f, 0.85f, 0.3f) * meshSize);
 
 	character->SetBoundingVolume((CollisionVolume*)volume);
 
@@ -783,12 +773,12 @@ GameObject* CourseworkGame::AddPlayerToWorld(const Vector3& position) {
 		.SetPosition(Vector3(-20, 5, 20));
 
 	if (rand() % 2) {
-		character->SetRenderObject(new RenderObject(&character->GetTransform(), charMeshA, nullptr, basicShader));
+		character->SetRenderObject(world->Create<RenderObject>(&character->GetTransform(), charMeshA, nullptr, basicShader));
 	}
 	else {
-		character->SetRenderObject(new RenderObject(&character->GetTransform(), charMeshB, nullptr, basicShader));
+		character->SetRenderObject(world->Create<RenderObject>(&character->GetTransform(), charMeshB, nullptr, basicShader));
 	}
-	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
+	character->SetPhysicsObject(world->Create<PhysicsObject>(&character->GetTransform(), character->GetBoundingVolume()));
 
 	character->GetPhysicsObject()->SetInverseMass(inverseMass);
 	character->GetPhysicsObject()->InitSphereInertia();
@@ -802,17 +792,17 @@ GameObject* CourseworkGame::AddEnemyToWorld(const Vector3& position) {
 	float meshSize = 3.0f;
 	float inverseMass = 0.5f;
 
-	GameObject* character = new GameObject("Enemy");
+	GameObject* character = world->Create<GameObject>("Enemy");
 
-	AABBVolume* volume = new AABBVolume(Vector3(0.3f, 0.9f, 0.3f) * meshSize);
+	AABBVolume* volume = world->Create<AABBVolume>(Vector3(0.3f, 0.9f, 0.3f) * meshSize);
 	character->SetBoundingVolume((CollisionVolume*)volume);
 
 	character->GetTransform()
 		.SetScale(Vector3(meshSize, meshSize, meshSize))
 		.SetPosition(position);
 
-	character->SetRenderObject(new RenderObject(&character->GetTransform(), enemyMesh, nullptr, basicShader));
-	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
+	character->SetRenderObject(world->Create<RenderObject>(&character->GetTransform(), enemyMesh, nullptr, basicShader));
+	character->SetPhysicsObject(world->Create<PhysicsObject>(&character->GetTransform(), character->GetBoundingVolume()));
 
 	character->GetPhysicsObject()->SetInverseMass(inverseMass);
 	character->GetPhysicsObject()->InitSphereInertia();
@@ -823,72 +813,119 @@ GameObject* CourseworkGame::AddEnemyToWorld(const Vector3& position) {
 }
 
 GameObject* CourseworkGame::AddBonusToWorld(const Vector3& position) {
-	GameObject* coin = new GameObject("Coin");
-
-	SphereVolume* volume = new SphereVolume(0.25f);
-	coin->SetBoundingVolume((CollisionVolume*)volume);
-	coin->GetTransform()
-		.SetScale(Vector3(0.25, 0.25, 0.25))
-		.SetPosition(position);
-
-	coin->SetRenderObject(new RenderObject(&coin->GetTransform(), bonusMesh, nullptr, basicShader));
-	coin->SetPhysicsObject(new PhysicsObject(&coin->GetTransform(), coin->GetBoundingVolume()));
-
-	coin->GetPhysicsObject()->SetInverseMass(1.0f);
-	coin->GetPhysicsObject()->InitSphereInertia();
-
-	world->AddGameObject(coin);
-
-	return coin;
+	return world->SpawnPrefab(*coinPrefab, &position, 1);
 }
 
 StateGameObject* CourseworkGame::AddStateEnemyToWorld(const Vector3& position)
 {
-	float meshSize = 3.0f;
-	float inverseMass = 0.5f;
-	StateGameObject* enemy = new StateGameObject("Enemy");
+	return SpawnEnemies(&position, 1);
+}
 
-	AABBVolume* volume = new AABBVolume(Vector3(0.3f, 0.9f, 0.3f) * meshSize);
+StateGameObject* CourseworkGame::SpawnEnemies(const Vector3* positions, int count) {
+	StateGameObject* spawned = world->SpawnPrefab<StateGameObject>(*enemyPrefab, positions, count, navGrid);
+	for (int i = 0; i < count; i++) {
+		SetEnemyPathing(spawned[i]);
+		enemies.emplace_back(world->GetHandle(&spawned[i]));
+	}
+	return spawned;
+}
 
-	enemy->SetBoundingVolume((CollisionVolume*)volume);
-	enemy->GetTransform()
-		.SetScale(Vector3(meshSize, meshSize, meshSize))
-		.SetPosition(Vector3(-20, 5, 20));
+//An agent uses the first of these it's given, so each only gets the one it should be using
+void CourseworkGame::SetEnemyPathing(StateGameObject& enemy) {
+	enemy.SetPathing(enemyPathing == EnemyPathing::FlowField ? goalField : nullptr,
+		enemyPathing == EnemyPathing::Service ? pathService : nullptr);
+	enemy.SetPlanner(enemyPathing == EnemyPathing::Planner ? NewEnemyPlanner() : nullptr);
+}
 
-	enemy->SetRenderObject(new RenderObject(&enemy->GetTransform(), enemyMesh, nullptr, basicShader));
-	enemy->SetPhysicsObject(new PhysicsObject(&enemy->GetTransform(), enemy->GetBoundingVolume()));
+//Every enemy gets its own planner, already knowing where the obstacles are
+DStarLite* CourseworkGame::NewEnemyPlanner() const {
+	DStarLite* planner = new DStarLite(*navGrid);
+	for (int cell : obstacleCells) {
+		planner->SetCellCost(cell % navGrid->GetWidth(), cell / navGrid->GetWidth(), OBSTACLE_COST);
+	}
+	return planner;
+}
 
-	enemy->GetPhysicsObject()->SetInverseMass(inverseMass);
-	enemy->GetPhysicsObject()->InitSphereInertia();
+/*
+The obstacles slide about, so every frame the cells they're over are
+worked out again - only the cells that have changed since last frame are
+passed on to the enemies' planners, so if nothing's moved far enough to
+change cell, the planners have nothing to do. Obstacles are made
+expensive rather than blocked outright, as the grid's cells are bigger
+than they are - an enemy will still squeeze past if there's no other way.
+*/
+void CourseworkGame::UpdateObstacleCells() {
+	Vector3 shift(55, 0, 100); //From world space to the nav grid's
+	Vector3 halfSize(3, 0, 3);
+	int nodeSize = navGrid->GetNodeSize();
+	if (nodeSize <= 0) {
+		return; //the grid didn't load
+	}
+
+	vector<int> cells;
+	for (GameObjectHandle h : obstacles) {
+		GameObject* o = world->GetGameObject(h);
+		if (!o) {
+			continue;
+		}
+		Vector3 minPos = o->GetGamePosition() + shift - halfSize;
+		Vector3 maxPos = o->GetGamePosition() + shift + halfSize;
+		for (int y = (int)minPos.z / nodeSize; y <= (int)maxPos.z / nodeSize; ++y) {
+			for (int x = (int)minPos.x / nodeSize; x <= (int)maxPos.x / nodeSize; ++x) {
+				if (x >= 0 && y >= 0 && x < navGrid->GetWidth() && y < navGrid->GetHeight()) {
+					cells.push_back((y * navGrid->GetWidth()) + x);
+				}
+			}
+		}
+	}
+	std::sort(cells.begin(), cells.end());
+	cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+	if (cells == obstacleCells) {
+		return;
+	}
 
-	world->AddGameObject(enemy);
+	vector<int> cleared;
+	vector<int> covered;
+	std::set_difference(obstacleCells.begin(), obstacleCells.end(), cells.begin(), cells.end(), std::back_inserter(cleared));
+	std::set_difference(cells.begin(), cells.end(), obstacleCells.begin(), obstacleCells.end(), std::back_inserter(covered));
+	obstacleCells.swap(cells);
 
-	return enemy;
+	int width = navGrid->GetWidth();
+	for (GameObjectHandle h : enemies) {
+		StateGameObject* e = (StateGameObject*)world->GetGameObject(h);
+		if (!e || !e->GetPlanner()) {
+			continue;
+		}
+		for (int cell : cleared) {
+			e->GetPlanner()->SetCellCost(cell % width, cell / width, 1.0f);
+		}
+		for (int cell : covered) {
+			e->GetPlanner()->SetCellCost(cell % width, cell / width, OBSTACLE_COST);
+		}
+	}
 }
 
 StateObstacleObject* CourseworkGame::AddStateObstacleToWorld(const Vector3& position)
 {
 	float inverseMass = 1;
-	StateObstacleObject* obstacle = new StateObstacleObject("Floor", (((float)(rand() % 30)) / 10.0f));
+	StateObstacleObject* obstacle = world->Create<StateObstacleObject>("Floor", (((float)(rand() % 30)) / 10.0f));
 
-	AABBVolume* volume = new AABBVolume(Vector3(3, 0.5, 3));
+	AABBVolume* volume = world->Create<AABBVolume>(Vector3(3, 0.5, 3));
 
 	obstacle->SetBoundingVolume((CollisionVolume*)volume);
 	obstacle->GetTransform()
 		.SetPosition(position)
 		.SetScale(Vector3(3, 0.5, 3) * 2);
 
-	obstacle->SetRenderObject(new RenderObject(&obstacle->GetTransform(), cubeMesh, nullptr, basicShader));
-	obstacle->SetPhysicsObject(new PhysicsObject(&obstacle->GetTransform(), obstacle->GetBoundingVolume()));
+	obstacle->SetRenderObject(world->Create<RenderObject>(&obstacle->GetTransform(), cubeMesh, nullptr, basicShader));
+	obstacle->SetPhysicsObject(world->Create<PhysicsObject>(&obstacle->GetTransform(), obstacle->GetBoundingVolume()));
 
 	obstacle->GetPhysicsObject()->SetInverseMass(inverseMass);
 	obstacle->GetPhysicsObject()->SetFriction(1);
 	obstacle->GetPhysicsObject()->SetElasticity(0.5);
 	obstacle->GetPhysicsObject()->InitSphereInertia();
 
-	world->AddGameObject(obstacle);
-
-	obstacles.push_back(obstacle);
+	obstacles.push_back(world->AddGameObject(obstacle));
 
 	return obstacle;
 }
@@ -897,9 +934,10 @@ bool CourseworkGame::WinConditionMet(GameObject* testSubject)
 {
 	//std::cout << testSubject->GetName() << std::endl;
 	//if player in win area
-	if (testSubject->GetTransform().GetPosition().x > 25 && testSubject->GetTransform().GetPosition().z < -70 &&
-		testSubject->GetTransform().GetPosition().x < 50 && testSubject->GetTransform().GetPosition().z > -95 && 
-		testSubject->GetTransform().GetPosition().y > 0 && testSubject->GetScore() > 0) {
+	Vector3 position = testSubject->GetGamePosition();
+	if (position.x > 25 && position.z < -70 &&
+		position.x < 50 && position.z > -95 && 
+		position.y > 0 && testSubject->GetScore() > 0) {
 		//win
 		return true;
 	}
@@ -926,18 +964,19 @@ bool CourseworkGame::SelectObject() {
 	if (inSelectionMode) {
 
 		if (Window::GetMouse()->ButtonDown(NCL::MouseButtons::LEFT)) {
-			if (selectionObject) {	//set colour to deselected;
-				selectionObject->GetRenderObject()->SetColour(Vector4(1, 1, 1, 1));
-				selectionObject = nullptr;
+			if (GameObject* selected = world->GetGameObject(selectionObject)) {	//set colour to deselected;
+				selected->GetRenderObject()->SetColour(Vector4(1, 1, 1, 1));
 				lockedObject = nullptr;
 			}
+			selectionObject = GameObjectHandle();
 
 			Ray ray = CollisionDetection::BuildRayFromMouse(*world->GetMainCamera());
 
 			RayCollision closestCollision;
 			if (world->Raycast(ray, closestCollision, true)) {
-				selectionObject = (GameObject*)closestCollision.node;
-				selectionObject->GetRenderObject()->SetColour(Vector4(0, 1, 0, 1));
+				GameObject* selected = (GameObject*)closestCollision.node;
+				selectionObject = world->GetHandle(selected);
+				selected->GetRenderObject()->SetColour(Vector4(0, 1, 0, 1));
 				return true;
 			}
 			else {
@@ -956,14 +995,15 @@ added linear motion into our physics system. After the second tutorial, objects
 line - after the third, they'll be able to twist under torque aswell.
 */
 void CourseworkGame::MoveSelectedObject() {
-	if (!selectionObject) return;
+	GameObject* selected = world->GetGameObject(selectionObject);
+	if (!selected) return;
 
 	if (Window::GetMouse()->ButtonPressed(NCL::MouseButtons::RIGHT)) {
 		Ray ray = CollisionDetection::BuildRayFromMouse(*world->GetMainCamera());
 		RayCollision closestCollision;
 		if (world->Raycast(ray, closestCollision, true)) {
-			if (closestCollision.node == selectionObject) {
-				selectionObject->GetPhysicsObject()->AddForceAtPosition(ray.GetDirection() * 10, closestCollision.collidedAt);
+			if (closestCollision.node == selected) {
+				selected->GetPhysicsObject()->AddForceAtPosition(ray.GetDirection() * 10, closestCollision.collidedAt);
 			}
 		}
 	}
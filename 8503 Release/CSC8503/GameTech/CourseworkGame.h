@@ -1,6 +1,10 @@
 #pragma once
 #include "GameTechRenderer.h"
 #include "../CSC8503Common/PhysicsSystem.h"
+#include "../CSC8503Common/JobSystem.h"
+#include "../CSC8503Common/PhysicsThread.h"
+#include "../CSC8503Common/WorldSnapshot.h"
+#include "../CSC8503Common/Prefab.h"
 #include "../CSC8503Common/StateGameObject.h"
 #include "../CSC8503Common/StateObstacleObject.h"
 #include "../CSC8503Common/PushdownMachine.h"
@@ -33,6 +37,7 @@ namespace NCL {
 
 			void InitCamera();
 			void UpdateKeys();
+			void UpdatePhysicsKeys();
 
 			void InitWorld();
 
@@ -54,6 +59,7 @@ namespace NCL {
 			vector<GameObject*> AddWallsToWorld(const Vector3& position);
 
 			vector<GameObject*> AddFloorToWorld(const Vector3& position);
+			vector<GameObject*> AddStaticBoxesToWorld(const string& name, const Vector3& halfSize, float elasticity, const vector<Vector3>& positions);
 			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f);
 			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f);
 
@@ -70,19 +76,42 @@ namespace NCL {
 			GameTechRenderer* renderer;
 			PhysicsSystem* physics;
 			GameWorld* world;
+			JobSystem* jobSystem;
+			PhysicsThread* physicsThread;
+			bool threadedPhysics = false;
+			WorldSnapshot levelStart;
 
 			GameObject* player = nullptr;
 			std::string winnerName;
 
-			vector<StateGameObject*> enemies;
+			/*
+			How enemies find their way to the end area - their own D* Lite
+			planners, the shared flow field, or whole paths searched by the
+			pathfinding service. F12 switches between them.
+			*/
+			enum class EnemyPathing {
+				Planner,
+				FlowField,
+				Service,
+				MAX_PATHING
+			};
+
+			vector<GameObjectHandle> enemies;
+			EnemyPathing enemyPathing = EnemyPathing::Planner;
 			StateGameObject* AddStateEnemyToWorld(const Vector3& position);
+			StateGameObject* SpawnEnemies(const Vector3* positions, int count);
+			void SetEnemyPathing(StateGameObject& enemy);
 			bool multi;
 
-			vector<StateObstacleObject*> obstacles;
+			vector<GameObjectHandle> obstacles;
+			vector<int> obstacleCells;	//the nav grid cells the obstacles covered last frame
+
+			void UpdateObstacleCells();
+			DStarLite* NewEnemyPlanner() const;
 
 			StateObstacleObject* AddStateObstacleToWorld(const Vector3& position);
 
-			GameObject* selectionObject = nullptr;
+			GameObjectHandle selectionObject;
 			bool inSelectionMode;
 
 			OGLMesh* capsuleMesh = nullptr;
@@ -97,6 +126,16 @@ namespace NCL {
 			OGLMesh* enemyMesh = nullptr;
 			OGLMesh* bonusMesh = nullptr;
 
+			void InitialisePrefabs();
+			Prefab* coinPrefab = nullptr;
+			Prefab* enemyPrefab = nullptr;
+			Prefab* plankPrefab = nullptr;
+			Prefab* anchorPrefab = nullptr;
+
+			const NavigationGrid* navGrid = nullptr;
+			FlowField* goalField = nullptr;
+			PathfindingService* pathService = nullptr;
+
 			//Coursework Additional functionality	
 			GameObject* lockedObject = nullptr;
 			float lockedPitch = 0;
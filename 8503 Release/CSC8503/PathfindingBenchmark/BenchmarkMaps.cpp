@@ -0,0 +1,173 @@
+#include "BenchmarkMaps.h"
+#include <fstream>
+#include <random>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+//How many of a maze's inside walls get knocked through, so there's more than one way round
+const float MAZE_LOOP_CHANCE = 0.05f;
+
+//How much of an open field is covered in blocks
+const float OPEN_FIELD_DENSITY = 0.2f;
+
+void BenchmarkMaps::Generate(BenchmarkMap map, int size, unsigned int seed, std::vector<uint8_t>& walls) {
+	switch (map) {
+		case BenchmarkMap::Maze:		GenerateMaze(size, seed, walls);		break;
+		case BenchmarkMap::OpenField:	GenerateOpenField(size, seed, walls);	break;
+		default: walls.assign(size * size, 0); break;
+	}
+}
+
+/*
+A corridor maze, one cell wide, carved out with a depth first search from
+the top left - rooms are on the odd cells, with the cells between them
+knocked through as the search moves from one room to the next. That gives
+exactly one way between any two rooms, so a few extra walls are knocked
+through afterwards to give the searches some choices to make.
+*/
+void BenchmarkMaps::GenerateMaze(int size, unsigned int seed, std::vector<uint8_t>& walls) {
+	std::mt19937 random(seed);
+	walls.assign(size * size, 1);
+
+	int rooms = (size - 1) / 2; //along each side
+	if (rooms < 1) {
+		return;
+	}
+	const int dirX[4] = { 0, 0, -1, 1 };
+	const int dirY[4] = { -1, 1, 0, 0 };
+
+	std::vector<int> stack;
+	stack.reserve(rooms * rooms);
+	stack.push_back(0);
+	walls[(1 * size) + 1] = 0;
+
+	while (!stack.empty()) {
+		int room	= stack.back();
+		int rx		= room % rooms;
+		int ry		= room / rooms;
+
+		int choices[4];
+		int numChoices = 0;
+		for (int i = 0; i < 4; ++i) {
+			int nx = rx + dirX[i];
+			int ny = ry + dirY[i];
+			if (nx >= 0 && ny >= 0 && nx < rooms && ny < rooms && walls[(((ny * 2) + 1) * size) + (nx * 2) + 1]) {
+				choices[numChoices++] = i;
+			}
+		}
+		if (numChoices == 0) {
+			stack.pop_back();
+			continue;
+		}
+		int i	= choices[random() % numChoices];
+		int nx	= rx + dirX[i];
+		int ny	= ry + dirY[i];
+		walls[(((ry * 2) + 1 + dirY[i]) * size) + (rx * 2) + 1 + dirX[i]] = 0;
+		walls[(((ny * 2) + 1) * size) + (nx * 2) + 1] = 0;
+		stack.push_back((ny * rooms) + nx);
+	}
+
+	//Only the walls between two rooms, so that no new dead ends appear
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	for (int y = 1; y < rooms * 2; ++y) {
+		for (int x = 1; x < rooms * 2; ++x) {
+			int cell = (y * size) + x;
+			if (!walls[cell] || ((x + y) & 1) == 0) {
+				continue;
+			}
+			bool betweenRooms = (x & 1) ? (!walls[cell - size] && !walls[cell + size]) : (!walls[cell - 1] && !walls[cell + 1]);
+			if (betweenRooms && chance(random) < MAZE_LOOP_CHANCE) {
+				walls[cell] = 0;
+			}
+		}
+	}
+}
+
+/*
+Mostly open ground, with rectangular blocks of all sizes dropped about it
+until enough of it is covered. Blocks can land on each other, and can
+wall off little pockets - LabelRegions keeps queries out of those.
+*/
+void BenchmarkMaps::GenerateOpenField(int size, unsigned int seed, std::vector<uint8_t>& walls) {
+	std::mt19937 random(seed);
+	walls.assign(size * size, 0);
+
+	int maxBlock	= std::max(2, size / 32);
+	int target		= (int)(size * size * OPEN_FIELD_DENSITY);
+	int covered		= 0;
+	while (covered < target) {
+		int w = 1 + (int)(random() % maxBlock);
+		int h = 1 + (int)(random() % maxBlock);
+		int x = (int)(random() % size);
+		int y = (int)(random() % size);
+		for (int by = y; by < std::min(size, y + h); ++by) {
+			for (int bx = x; bx < std::min(size, x + w); ++bx) {
+				uint8_t& cell = walls[(by * size) + bx];
+				covered += cell == 0;
+				cell = 1;
+			}
+		}
+	}
+}
+
+bool BenchmarkMaps::WriteTextGrid(const std::string& path, int size, const std::vector<uint8_t>& walls) {
+	std::ofstream file(path);
+	file << 1 << "\n" << size << "\n" << size << "\n";
+
+	std::string line(size, '.');
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			line[x] = walls[(y * size) + x] ? 'x' : '.';
+		}
+		file << line << "\n";
+	}
+	return file.good();
+}
+
+void BenchmarkMaps::LabelRegions(int size, const std::vector<uint8_t>& walls, std::vector<int>& regions) {
+	regions.assign(size * size, -1);
+	std::vector<int> frontier;
+	int numRegions = 0;
+
+	for (int start = 0; start < size * size; ++start) {
+		if (walls[start] || regions[start] >= 0) {
+			continue;
+		}
+		regions[start] = numRegions;
+		frontier.assign(1, start);
+		while (!frontier.empty()) {
+			int cell = frontier.back();
+			frontier.pop_back();
+			int x = cell % size;
+			int y = cell / size;
+			int neighbours[4] = { y > 0 ? cell - size : -1, y < size - 1 ? cell + size : -1, x > 0 ? cell - 1 : -1, x < size - 1 ? cell + 1 : -1 };
+			for (int n : neighbours) {
+				if (n >= 0 && !walls[n] && regions[n] < 0) {
+					regions[n] = numRegions;
+					frontier.push_back(n);
+				}
+			}
+		}
+		numRegions++;
+	}
+}
+
+const char* BenchmarkMaps::GetMapName(BenchmarkMap map) {
+	switch (map) {
+		case BenchmarkMap::Maze:		return "maze";
+		case BenchmarkMap::OpenField:	return "open";
+		default: return "unknown";
+	}
+}
+
+bool BenchmarkMaps::GetMapFromName(const std::string& name, BenchmarkMap& map) {
+	for (int i = 0; i < (int)BenchmarkMap::MAX_MAPS; ++i) {
+		if (name == GetMapName((BenchmarkMap)i)) {
+			map = (BenchmarkMap)i;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		enum class BenchmarkMap {
+			Maze,
+			OpenField,
+			MAX_MAPS
+		};
+
+		/*
+		Generates square grid maps for the pathfinding benchmark, as one
+		byte per cell (1 for a wall), and writes them out in the same text
+		format as TestGrid1.txt, so they can be loaded by NavigationGrid.
+
+		Every map is generated from a fixed seed, so the same map type, size
+		and seed will always give the same map.
+		*/
+		class BenchmarkMaps {
+		public:
+			static void Generate(BenchmarkMap map, int size, unsigned int seed, std::vector<uint8_t>& walls);
+
+			static void GenerateMaze(int size, unsigned int seed, std::vector<uint8_t>& walls);
+			static void GenerateOpenField(int size, unsigned int seed, std::vector<uint8_t>& walls);
+
+			//Node size 1, so cell (x, y) is at position (x, 0, y)
+			static bool WriteTextGrid(const std::string& path, int size, const std::vector<uint8_t>& walls);
+
+			/*
+			Labels which open cells can reach each other - walls are given -1.
+			Queries are only picked between cells with the same label, so every
+			one of them should find a path.
+			*/
+			static void LabelRegions(int size, const std::vector<uint8_t>& walls, std::vector<int>& regions);
+
+			static const char*	GetMapName(BenchmarkMap map);
+			static bool			GetMapFromName(const std::string& name, BenchmarkMap& map);
+		};
+	}
+}
@@ -0,0 +1,570 @@
+/*
+A headless benchmark for the pathfinding - it generates grid maps, runs
+the same seeded set of start and goal pairs through every NavigationMap
+that can search them, and reports the queries per second, nodes expanded,
+memory use and how long the paths come out compared to the grid's A*.
+
+There's no window or renderer involved, so as well as building from the
+solution, it can be built on Linux straight from the command line, from
+the 8503 Release folder:
+
+	g++ -std=c++17 -O2 CSC8503/PathfindingBenchmark/{Main,BenchmarkMaps}.cpp \
+		CSC8503/CSC8503Common/{NavigationGrid,JumpPointSearch,HierarchicalGrid,ThetaStar,NavigationMesh,MappedFile,JobSystem}.cpp \
+		Common/{Vector2,Vector3,Vector4,Maths}.cpp -lpthread -o PathfindingBenchmark
+
+Maps are written into the data folder (as text, then saved back out as a
+binary grid) and loaded from there, so it needs running from somewhere
+that Assets::DATADIR points at the Assets/Data folder - the same as the
+game. The files are deleted again afterwards, unless --keep is on.
+
+Example usage:
+
+	PathfindingBenchmark --maps all --sizes 64,256,1024,4096 --csv paths.csv
+	PathfindingBenchmark --maps maze --sizes 1024 --algorithms astar,jps,hpa --queries 1000
+	PathfindingBenchmark --maps open --sizes 256 --mesh test.navmesh
+*/
+#include "BenchmarkMaps.h"
+#include "../CSC8503Common/NavigationGrid.h"
+#include "../CSC8503Common/JumpPointSearch.h"
+#include "../CSC8503Common/HierarchicalGrid.h"
+#include "../CSC8503Common/ThetaStar.h"
+#include "../CSC8503Common/NavigationMesh.h"
+#include "../CSC8503Common/JobSystem.h"
+#include "../../Common/Assets.h"
+#include "../../Common/GameTimer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+enum class BenchmarkAlgorithm {
+	AStar,			//NavigationGrid
+	JPS,			//JumpPointSearch, four way
+	JPS8,			//JumpPointSearch, eight way
+	Hierarchical,	//HierarchicalGrid
+	ThetaStar,		//ThetaStar
+	MAX_ALGORITHMS
+};
+
+const char* GetAlgorithmName(BenchmarkAlgorithm algorithm) {
+	switch (algorithm) {
+		case BenchmarkAlgorithm::AStar:			return "astar";
+		case BenchmarkAlgorithm::JPS:			return "jps";
+		case BenchmarkAlgorithm::JPS8:			return "jps8";
+		case BenchmarkAlgorithm::Hierarchical:	return "hpa";
+		case BenchmarkAlgorithm::ThetaStar:		return "theta";
+		default: return "unknown";
+	}
+}
+
+struct BenchmarkSettings {
+	std::vector<BenchmarkMap>		maps;
+	std::vector<int>				sizes;
+	std::vector<BenchmarkAlgorithm>	algorithms;
+	int				queries		= 200;
+	int				threads		= std::max(1, (int)std::thread::hardware_concurrency());
+	int				clusterSize = 32;
+	unsigned int	seed		= 1234;
+	bool			keep		= false;
+	std::string		meshFile;
+	std::string		csvFile;
+};
+
+struct Query {
+	Vector3 from;
+	Vector3 to;
+};
+
+struct BenchmarkResult {
+	float	buildTime		= 0.0f;	//seconds
+	float	runTime			= 0.0f;	//seconds
+	double	nodesExpanded	= 0;	//summed over all queries
+	double	lengthRatio		= 0;	//summed over every query both found a path for
+	int		compared		= 0;	//how many queries went into lengthRatio
+	int		found			= 0;
+	int		mismatches		= 0;	//found a path when A* didn't, or the other way round
+	float	memoryUsed		= 0.0f;	//KB, the map's own data, as it reports it
+	float	peakMemory		= 0.0f;	//MB, the whole process's, so far
+};
+
+/*
+Peak resident memory, in megabytes. What's in use right now isn't much
+help for telling how big a map is - the allocator hangs on to whatever the
+last map freed, so the maps report their own sizes instead.
+*/
+float GetPeakMemory() {
+	float peak = 0.0f;
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		peak = counters.PeakWorkingSetSize / (1024.0f * 1024.0f);
+	}
+#elif defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		std::istringstream s(line);
+		std::string key;
+		float kb = 0.0f;
+		s >> key >> kb;
+		if (key == "VmHWM:") {
+			peak = kb / 1024.0f;
+		}
+	}
+#endif
+	return peak;
+}
+
+float SecondsSince(const Timepoint& start) {
+	std::chrono::duration<float> diff = std::chrono::high_resolution_clock::now() - start;
+	return diff.count();
+}
+
+long GetFileSize(const std::string& path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	return file.is_open() ? (long)file.tellg() : 0;
+}
+
+template<class T>
+std::vector<T> SplitList(const std::string& input, T(*convert)(const std::string&)) {
+	std::vector<T> output;
+	std::istringstream s(input);
+	std::string entry;
+	while (std::getline(s, entry, ',')) {
+		if (!entry.empty()) {
+			output.push_back(convert(entry));
+		}
+	}
+	return output;
+}
+
+int ToInt(const std::string& s) {
+	return std::atoi(s.c_str());
+}
+
+void PrintUsage() {
+	std::cout << "Usage: PathfindingBenchmark [options]\n"
+		<< "  --maps <name[,name]>        maze, open or all (default all)\n"
+		<< "  --sizes <n[,n]>             map widths to test, 64 to 4096 (default 64,256,1024)\n"
+		<< "  --algorithms <name[,name]>  astar, jps, jps8, hpa, theta or all (default all)\n"
+		<< "  --queries <n>               start and goal pairs per map (default 200)\n"
+		<< "  --seed <n>                  seed for the maps and queries (default 1234)\n"
+		<< "  --cluster <n>               cluster size for hpa (default 32)\n"
+		<< "  --threads <n>               threads for building hpa's clusters (default all)\n"
+		<< "  --mesh <file>               also run queries across a navigation mesh from the data folder\n"
+		<< "  --keep <on|off>             keep the generated map files (default off)\n"
+		<< "  --csv <file>                write one row per run to a csv file\n";
+}
+
+bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings) {
+	std::string mapList			= "all";
+	std::string sizeList		= "64,256,1024";
+	std::string algorithmList	= "all";
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << arg << "\n";
+			return false;
+		}
+		std::string value = argv[++i];
+		if		(arg == "--maps")		{ mapList = value; }
+		else if (arg == "--sizes")		{ sizeList = value; }
+		else if (arg == "--algorithms")	{ algorithmList = value; }
+		else if (arg == "--queries")	{ settings.queries = std::max(1, ToInt(value)); }
+		else if (arg == "--seed")		{ settings.seed = (unsigned int)ToInt(value); }
+		else if (arg == "--cluster")	{ settings.clusterSize = std::max(4, ToInt(value)); }
+		else if (arg == "--threads")	{ settings.threads = std::max(1, ToInt(value)); }
+		else if (arg == "--mesh")		{ settings.meshFile = value; }
+		else if (arg == "--keep")		{ settings.keep = (value == "on" || value == "1"); }
+		else if (arg == "--csv")		{ settings.csvFile = value; }
+		else {
+			std::cout << "Unknown option " << arg << "\n";
+			return false;
+		}
+	}
+
+	for (const std::string& name : SplitList<std::string>(mapList, [](const std::string& s) { return s; })) {
+		if (name == "all") {
+			for (int i = 0; i < (int)BenchmarkMap::MAX_MAPS; ++i) {
+				settings.maps.push_back((BenchmarkMap)i);
+			}
+			continue;
+		}
+		BenchmarkMap map;
+		if (!BenchmarkMaps::GetMapFromName(name, map)) {
+			std::cout << "Unknown map " << name << "\n";
+			return false;
+		}
+		settings.maps.push_back(map);
+	}
+
+	for (const std::string& name : SplitList<std::string>(algorithmList, [](const std::string& s) { return s; })) {
+		bool known = false;
+		for (int i = 0; i < (int)BenchmarkAlgorithm::MAX_ALGORITHMS; ++i) {
+			if (name == "all" || name == GetAlgorithmName((BenchmarkAlgorithm)i)) {
+				settings.algorithms.push_back((BenchmarkAlgorithm)i);
+				known = true;
+			}
+		}
+		if (!known) {
+			std::cout << "Unknown algorithm " << name << "\n";
+			return false;
+		}
+	}
+
+	for (int size : SplitList<int>(sizeList, ToInt)) {
+		if (size < 8) {
+			std::cout << "Map size " << size << " is too small!\n";
+			return false;
+		}
+		settings.sizes.push_back(size);
+	}
+	if ((settings.maps.empty() || settings.sizes.empty() || settings.algorithms.empty()) && settings.meshFile.empty()) {
+		std::cout << "Nothing to run!\n";
+		return false;
+	}
+	return true;
+}
+
+/*
+Starts and goals are picked at random from the open cells, but only
+between cells that can reach each other - so every query should find a
+path, and a map that can't find one has gone wrong.
+*/
+std::vector<Query> MakeQueries(int size, const std::vector<uint8_t>& walls, int numQueries, unsigned int seed) {
+	std::vector<int> regions;
+	BenchmarkMaps::LabelRegions(size, walls, regions);
+
+	std::mt19937 random(seed);
+	std::vector<Query> queries;
+	int attempts = numQueries * 1000;
+	while ((int)queries.size() < numQueries && attempts-- > 0) {
+		int from	= (int)(random() % (size * size));
+		int to		= (int)(random() % (size * size));
+		if (regions[from] < 0 || regions[from] != regions[to]) {
+			continue;
+		}
+		queries.push_back({ Vector3((float)(from % size), 0, (float)(from / size)), Vector3((float)(to % size), 0, (float)(to / size)) });
+	}
+	return queries;
+}
+
+float GetPathLength(NavigationPath& path) {
+	float length = 0.0f;
+	Vector3 last;
+	Vector3 waypoint;
+	bool first = true;
+	while (path.PopWaypoint(waypoint)) {
+		if (!first) {
+			length += (waypoint - last).Length();
+		}
+		last	= waypoint;
+		first	= false;
+	}
+	return length;
+}
+
+NavigationMap* BuildMap(const BenchmarkSettings& settings, BenchmarkAlgorithm algorithm, const NavigationGrid& grid, JobSystem* jobs) {
+	switch (algorithm) {
+		case BenchmarkAlgorithm::JPS:			return new JumpPointSearch(grid, GridConnectivity::Four);
+		case BenchmarkAlgorithm::JPS8:			return new JumpPointSearch(grid, GridConnectivity::Eight);
+		case BenchmarkAlgorithm::Hierarchical:	return new HierarchicalGrid(grid, settings.clusterSize, jobs);
+		case BenchmarkAlgorithm::ThetaStar:		return new ThetaStar(grid);
+		default: return nullptr; //A* is just the grid itself
+	}
+}
+
+/*
+Runs every query through the map. With referenceLengths given, each path
+is compared against A*'s for the same query - otherwise, this is the A*
+run, and the lengths are filled in.
+*/
+BenchmarkResult RunQueries(const NavigationMap& map, const std::vector<Query>& queries, std::vector<float>& referenceLengths, bool isReference) {
+	BenchmarkResult result;
+	if (isReference) {
+		referenceLengths.assign(queries.size(), -1.0f);
+	}
+	std::vector<float> lengths(queries.size(), -1.0f);
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < queries.size(); ++i) {
+		NavigationPath path;
+		int nodesExpanded = 0;
+		if (map.FindPath(queries[i].from, queries[i].to, path, nodesExpanded)) {
+			lengths[i] = GetPathLength(path);
+			result.found++;
+		}
+		result.nodesExpanded += std::max(0, nodesExpanded);
+	}
+	result.runTime = SecondsSince(start);
+
+	for (size_t i = 0; i < queries.size(); ++i) {
+		if (isReference) {
+			referenceLengths[i] = lengths[i];
+			continue;
+		}
+		if ((lengths[i] < 0) != (referenceLengths[i] < 0)) {
+			result.mismatches++;
+		}
+		else if (lengths[i] >= 0 && referenceLengths[i] > 0) {
+			result.lengthRatio += lengths[i] / referenceLengths[i];
+			result.compared++;
+		}
+	}
+	if (isReference) {
+		result.lengthRatio	= result.found;
+		result.compared		= result.found;
+	}
+	return result;
+}
+
+void PrintHeader() {
+	std::cout << std::left
+		<< std::setw(7)	<< "map"
+		<< std::setw(7)	<< "size"
+		<< std::setw(8)	<< "search"
+		<< std::setw(11)<< "build ms"
+		<< std::setw(11)<< "queries/s"
+		<< std::setw(12)<< "nodes/query"
+		<< std::setw(11)<< "len vs A*"
+		<< std::setw(9)	<< "found"
+		<< std::setw(11)<< "mismatches"
+		<< std::setw(9)	<< "mem KB"
+		<< std::setw(9)	<< "peak MB" << "\n";
+	std::cout << std::right;
+}
+
+void PrintResult(const std::string& mapName, int size, const std::string& searchName, int numQueries, const BenchmarkResult& r) {
+	std::cout << std::left << std::fixed << std::setprecision(2)
+		<< std::setw(7)	<< mapName
+		<< std::setw(7)	<< size
+		<< std::setw(8)	<< searchName
+		<< std::setw(11)<< r.buildTime * 1000.0f
+		<< std::setw(11)<< std::setprecision(1) << numQueries / std::max(r.runTime, 1e-6f)
+		<< std::setw(12)<< r.nodesExpanded / std::max(numQueries, 1);
+	if (r.compared > 0) {
+		std::cout << std::setw(11) << std::setprecision(4) << r.lengthRatio / r.compared;
+	}
+	else {
+		std::cout << std::setw(11) << "-";
+	}
+	std::cout << std::setw(9) << r.found
+		<< std::setw(11)<< r.mismatches
+		<< std::setprecision(1)
+		<< std::setw(9) << r.memoryUsed
+		<< std::setw(9) << r.peakMemory << "\n";
+	std::cout << std::right << std::defaultfloat;
+}
+
+void WriteCSVHeader(std::ofstream& csv) {
+	csv << "map,size,search,queries,buildSeconds,runSeconds,queriesPerSecond,nodesPerQuery,lengthVsAStar,found,mismatches,memoryKB,peakMemoryMB\n";
+}
+
+void WriteCSVResult(std::ofstream& csv, const std::string& mapName, int size, const std::string& searchName, int numQueries, const BenchmarkResult& r) {
+	csv << mapName << "," << size << "," << searchName << "," << numQueries << "," << r.buildTime << "," << r.runTime << ","
+		<< numQueries / std::max(r.runTime, 1e-6f) << "," << r.nodesExpanded / std::max(numQueries, 1) << ",";
+	if (r.compared > 0) {
+		csv << r.lengthRatio / r.compared;
+	}
+	csv << "," << r.found << "," << r.mismatches << "," << r.memoryUsed << "," << r.peakMemory << "\n";
+	csv.flush();
+}
+
+/*
+Generates the map and writes it out as text, loads it (timing how long
+that takes), saves it back out as a binary grid and loads that too - then
+runs the queries through A* first, to have path lengths for the rest to be
+compared to.
+*/
+void BenchmarkGridMap(const BenchmarkSettings& settings, BenchmarkMap mapType, int size, JobSystem* jobs, std::ofstream& csv) {
+	std::string mapName		= BenchmarkMaps::GetMapName(mapType);
+	std::string baseName	= "PathBenchmark_" + mapName + "_" + std::to_string(size) + "_" + std::to_string(settings.seed);
+	std::string textFile	= baseName + ".txt";
+	std::string binaryFile	= baseName + ".navgrid";
+
+	std::vector<uint8_t> walls;
+	BenchmarkMaps::Generate(mapType, size, settings.seed, walls);
+	if (!BenchmarkMaps::WriteTextGrid(Assets::DATADIR + textFile, size, walls)) {
+		std::cout << "Can't write " << Assets::DATADIR + textFile << "!\n";
+		return;
+	}
+	std::vector<Query> queries = MakeQueries(size, walls, settings.queries, settings.seed);
+	walls.clear();
+	walls.shrink_to_fit();
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	NavigationGrid* textGrid = new NavigationGrid(textFile);
+	float textLoadTime = SecondsSince(start);
+
+	textGrid->WriteBinary(binaryFile);
+	delete textGrid;
+
+	start = std::chrono::high_resolution_clock::now();
+	NavigationGrid* grid = new NavigationGrid(binaryFile); //mapped, so it has to go before its file does
+	float binaryLoadTime = SecondsSince(start);
+
+	std::cout << std::fixed << std::setprecision(2) << mapName << " " << size << "x" << size << ": "
+		<< queries.size() << " queries, loaded text in " << textLoadTime * 1000.0f << "ms (" << std::setprecision(1) << GetFileSize(Assets::DATADIR + textFile) / 1024.0f << "KB), "
+		<< std::setprecision(2) << "binary in " << binaryLoadTime * 1000.0f << "ms (" << std::setprecision(1) << GetFileSize(Assets::DATADIR + binaryFile) / 1024.0f << "KB)\n" << std::defaultfloat;
+
+	if (grid->GetWidth() != size) {
+		std::cout << "Couldn't load the generated map back in!\n";
+		delete grid;
+		return;
+	}
+
+	std::vector<float> referenceLengths;
+	BenchmarkResult reference = RunQueries(*grid, queries, referenceLengths, true);
+	reference.buildTime = binaryLoadTime;
+	reference.memoryUsed	= grid->GetMemoryUsage() / 1024.0f;
+	reference.peakMemory	= GetPeakMemory();
+
+	for (BenchmarkAlgorithm algorithm : settings.algorithms) {
+		BenchmarkResult result;
+		if (algorithm == BenchmarkAlgorithm::AStar) {
+			result = reference;
+		}
+		else {
+			start = std::chrono::high_resolution_clock::now();
+			NavigationMap* map = BuildMap(settings, algorithm, *grid, jobs);
+			float buildTime = SecondsSince(start);
+
+			result = RunQueries(*map, queries, referenceLengths, false);
+			result.buildTime = buildTime;
+			result.memoryUsed	= map->GetMemoryUsage() / 1024.0f;
+			result.peakMemory	= GetPeakMemory();
+			delete map;
+		}
+		PrintResult(mapName, size, GetAlgorithmName(algorithm), (int)queries.size(), result);
+		if (csv.is_open()) {
+			WriteCSVResult(csv, mapName, size, GetAlgorithmName(algorithm), (int)queries.size(), result);
+		}
+	}
+	delete grid;
+
+	if (!settings.keep) {
+		std::remove((Assets::DATADIR + textFile).c_str());
+		std::remove((Assets::DATADIR + binaryFile).c_str());
+	}
+}
+
+/*
+There's no A* to compare a mesh against, so it just gets queries between
+the middles of random triangles. Like the grids, the mesh is loaded as it
+is, then saved out as a binary mesh and loaded again from that.
+*/
+void BenchmarkMesh(const BenchmarkSettings& settings, std::ofstream& csv) {
+	std::string binaryFile = "PathBenchmark_mesh_" + std::to_string(settings.seed) + ".navbin";
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	NavigationMesh* textMesh = new NavigationMesh(settings.meshFile);
+	float textLoadTime = SecondsSince(start);
+
+	if (textMesh->GetNumTriangles() == 0) {
+		std::cout << "Couldn't load " << settings.meshFile << "!\n";
+		delete textMesh;
+		return;
+	}
+	textMesh->WriteBinary(binaryFile);
+	delete textMesh;
+
+	start = std::chrono::high_resolution_clock::now();
+	NavigationMesh* mesh = new NavigationMesh(binaryFile);
+	float loadTime = SecondsSince(start);
+
+	if (mesh->GetNumTriangles() == 0) {
+		std::cout << "Couldn't load the binary mesh back in!\n";
+		delete mesh;
+		return;
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << settings.meshFile << ": " << mesh->GetNumTriangles() << " triangles, loaded in "
+		<< textLoadTime * 1000.0f << "ms, binary in " << loadTime * 1000.0f << "ms (" << std::setprecision(1)
+		<< GetFileSize(Assets::DATADIR + binaryFile) / 1024.0f << "KB)\n" << std::defaultfloat;
+
+	std::mt19937 random(settings.seed);
+	std::vector<Query> queries;
+	for (int i = 0; i < settings.queries; ++i) {
+		int from	= (int)(random() % mesh->GetNumTriangles());
+		int to		= (int)(random() % mesh->GetNumTriangles());
+		queries.push_back({ mesh->GetTriangleCentre(from), mesh->GetTriangleCentre(to) });
+	}
+	std::vector<float> lengths;
+	BenchmarkResult result = RunQueries(*mesh, queries, lengths, true);
+	result.buildTime	= loadTime;
+	result.compared		= 0; //nothing to compare against
+	result.memoryUsed	= mesh->GetMemoryUsage() / 1024.0f;
+	result.peakMemory	= GetPeakMemory();
+
+	PrintResult("mesh", mesh->GetNumTriangles(), "mesh", (int)queries.size(), result);
+	if (csv.is_open()) {
+		WriteCSVResult(csv, "mesh", mesh->GetNumTriangles(), "mesh", (int)queries.size(), result);
+	}
+	delete mesh;
+
+	if (!settings.keep) {
+		std::remove((Assets::DATADIR + binaryFile).c_str());
+	}
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+	if (!ParseArguments(argc, argv, settings)) {
+		PrintUsage();
+		return 1;
+	}
+
+	std::ofstream csv;
+	if (!settings.csvFile.empty()) {
+		csv.open(settings.csvFile);
+		if (!csv.is_open()) {
+			std::cout << "Can't open " << settings.csvFile << " for writing!\n";
+			return 1;
+		}
+		WriteCSVHeader(csv);
+	}
+
+	JobSystem* jobs = nullptr;
+	if (settings.threads > 1) {
+		jobs = new JobSystem(settings.threads - 1);
+	}
+
+	std::cout << "Every search gets the same " << settings.queries << " queries per map. Path lengths are compared to A*'s (four way, so eight way and any angle searches come in under 1).\n";
+	std::cout << "Build time and memory are for the search's own data - for A*, that's loading the binary grid.\n";
+	PrintHeader();
+
+	for (BenchmarkMap map : settings.maps) {
+		for (int size : settings.sizes) {
+			BenchmarkGridMap(settings, map, size, jobs, csv);
+		}
+	}
+	if (!settings.meshFile.empty()) {
+		BenchmarkMesh(settings, csv);
+	}
+	delete jobs;
+	return 0;
+}
@@ -0,0 +1,276 @@
+#include "BenchmarkScenes.h"
+#include "../CSC8503Common/PhysicsObject.h"
+#include "../CSC8503Common/PositionConstraint.h"
+#include "../CSC8503Common/AABBVolume.h"
+#include "../CSC8503Common/SphereVolume.h"
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+void BenchmarkScenes::BuildScene(GameWorld& world, BenchmarkScene scene, int numBodies, unsigned int seed) {
+	switch (scene) {
+		case BenchmarkScene::SphereGrid:	BuildSphereGrid(world, numBodies);		break;
+		case BenchmarkScene::CubeGrid:		BuildCubeGrid(world, numBodies);		break;
+		case BenchmarkScene::MixedGrid:		BuildMixedGrid(world, numBodies, seed);	break;
+		case BenchmarkScene::Bridge:		BuildBridge(world, numBodies);			break;
+		case BenchmarkScene::Maze:			BuildMaze(world, numBodies, seed);		break;
+		default: break;
+	}
+}
+
+/*
+The grids are kept as close to square as we can, and are centred on the
+origin, so that the broadphase tree is as balanced as possible. Bodies
+start just above the floor (the velocity damping in IntegrateAccel makes
+things fall very slowly), so the run is mostly measuring resting contacts.
+*/
+const float dropHeight = 1.1f;
+
+void BenchmarkScenes::GetGridSize(int numBodies, int& numRows, int& numCols) {
+	numCols = std::max(1, (int)std::ceil(std::sqrt((float)numBodies)));
+	numRows = std::max(1, (numBodies + numCols - 1) / numCols);
+}
+
+void BenchmarkScenes::BuildSphereGrid(GameWorld& world, int numBodies) {
+	int numRows, numCols;
+	GetGridSize(numBodies, numRows, numCols);
+
+	float radius	= 1.0f;
+	float spacing	= 3.0f;
+	Vector3 offset	= Vector3(numCols * spacing, 0, numRows * spacing) * -0.5f;
+
+	int added = 0;
+	for (int x = 0; x < numCols && added < numBodies; ++x) {
+		for (int z = 0; z < numRows && added < numBodies; ++z, ++added) {
+			Vector3 position = offset + Vector3(x * spacing, dropHeight, z * spacing);
+			AddSphere(world, position, radius, 1.0f);
+		}
+	}
+	float floorSize = std::max(numCols, numRows) * spacing * 0.5f + 10.0f;
+	AddFloor(world, Vector3(0, -2, 0), Vector3(floorSize, 2, floorSize));
+}
+
+void BenchmarkScenes::BuildCubeGrid(GameWorld& world, int numBodies) {
+	int numRows, numCols;
+	GetGridSize(numBodies, numRows, numCols);
+
+	Vector3 cubeDims	= Vector3(1, 1, 1);
+	float spacing		= 3.0f;
+	Vector3 offset		= Vector3(numCols * spacing, 0, numRows * spacing) * -0.5f;
+
+	int added = 0;
+	for (int x = 0; x < numCols && added < numBodies; ++x) {
+		for (int z = 0; z < numRows && added < numBodies; ++z, ++added) {
+			Vector3 position = offset + Vector3(x * spacing, dropHeight, z * spacing);
+			AddCube(world, position, cubeDims, 1.0f);
+		}
+	}
+	float floorSize = std::max(numCols, numRows) * spacing * 0.5f + 10.0f;
+	AddFloor(world, Vector3(0, -2, 0), Vector3(floorSize, 2, floorSize));
+}
+
+void BenchmarkScenes::BuildMixedGrid(GameWorld& world, int numBodies, unsigned int seed) {
+	int numRows, numCols;
+	GetGridSize(numBodies, numRows, numCols);
+
+	std::mt19937 rng(seed);
+
+	float sphereRadius	= 1.0f;
+	Vector3 cubeDims	= Vector3(1, 1, 1);
+	float spacing		= 3.0f;
+	Vector3 offset		= Vector3(numCols * spacing, 0, numRows * spacing) * -0.5f;
+
+	int added = 0;
+	for (int x = 0; x < numCols && added < numBodies; ++x) {
+		for (int z = 0; z < numRows && added < numBodies; ++z, ++added) {
+			Vector3 position = offset + Vector3(x * spacing, dropHeight, z * spacing);
+			if (rng() % 2) {
+				AddCube(world, position, cubeDims, 1.0f);
+			}
+			else {
+				AddSphere(world, position, sphereRadius, 1.0f);
+			}
+		}
+	}
+	float floorSize = std::max(numCols, numRows) * spacing * 0.5f + 10.0f;
+	AddFloor(world, Vector3(0, -2, 0), Vector3(floorSize, 2, floorSize));
+}
+
+/*
+The same rope bridge as the game's BridgeConstraintTest, just with as
+many links as we want, hanging between two fixed blocks.
+*/
+void BenchmarkScenes::BuildBridge(GameWorld& world, int numLinks) {
+	Vector3 cubeSize	= Vector3(1, 0.1f, 2);
+	float invCubeMass	= 5;
+	float maxDistance	= 1.5f;
+	float cubeDistance	= 2;
+
+	numLinks = std::max(1, numLinks - 2); //the two ends count as bodies too!
+
+	Vector3 startPos = Vector3(-(numLinks + 2) * cubeDistance * 0.5f, 0, 0);
+	GameObject* start	= AddCube(world, startPos, cubeSize, 0);
+	GameObject* end		= AddCube(world, startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0), cubeSize, 0);
+	GameObject* previous = start;
+
+	for (int i = 0; i < numLinks; ++i) {
+		GameObject* block = AddCube(world, startPos + Vector3((i + 1) * cubeDistance, 0, 0), cubeSize, invCubeMass);
+		world.AddConstraint(world.Create<PositionConstraint>(previous, block, maxDistance));
+		previous = block;
+	}
+	world.AddConstraint(world.Create<PositionConstraint>(previous, end, maxDistance));
+}
+
+/*
+A maze of static wall blocks, carved out with a simple depth first
+search. Every open cell gets a coin, and every few cells an 'Enemy' is
+sent off down the corridors instead, so that the coin pickup logic in
+GameObject::OnCollisionBegin gets exercised as the benchmark runs.
+
+Roughly half of the cells end up as walls, so the maze is sized so that
+walls + coins + enemies comes out close to the requested body count.
+*/
+void BenchmarkScenes::BuildMaze(GameWorld& world, int numBodies, unsigned int seed) {
+	int mazeSize = std::max(5, (int)std::ceil(std::sqrt((float)numBodies)));
+	if (mazeSize % 2 == 0) {
+		mazeSize++; //needs to be odd so there's an outer wall all round
+	}
+	std::mt19937 rng(seed);
+
+	std::vector<char> cells(mazeSize * mazeSize, 'x');
+
+	std::vector<int> stack;
+	cells[1 * mazeSize + 1] = '.';
+	stack.push_back(1 * mazeSize + 1);
+
+	const int dirX[4] = { 2, -2, 0, 0 };
+	const int dirZ[4] = { 0, 0, 2, -2 };
+
+	while (!stack.empty()) {
+		int current = stack.back();
+		int cx = current % mazeSize;
+		int cz = current / mazeSize;
+
+		int options[4];
+		int numOptions = 0;
+		for (int i = 0; i < 4; ++i) {
+			int nx = cx + dirX[i];
+			int nz = cz + dirZ[i];
+			if (nx > 0 && nx < mazeSize - 1 && nz > 0 && nz < mazeSize - 1 && cells[nz * mazeSize + nx] == 'x') {
+				options[numOptions++] = i;
+			}
+		}
+		if (numOptions == 0) {
+			stack.pop_back();
+			continue;
+		}
+		int dir = options[rng() % numOptions];
+		int nx	= cx + dirX[dir];
+		int nz	= cz + dirZ[dir];
+		cells[(cz + dirZ[dir] / 2) * mazeSize + (cx + dirX[dir] / 2)] = '.';
+		cells[nz * mazeSize + nx] = '.';
+		stack.push_back(nz * mazeSize + nx);
+	}
+
+	float cellSize	= 4.0f;
+	float halfCell	= cellSize * 0.5f;
+	Vector3 offset	= Vector3(mazeSize * cellSize, 0, mazeSize * cellSize) * -0.5f;
+
+	std::uniform_real_distribution<float> speed(-10.0f, 10.0f);
+
+	int openCells = 0;
+	for (int z = 0; z < mazeSize; ++z) {
+		for (int x = 0; x < mazeSize; ++x) {
+			Vector3 position = offset + Vector3(x * cellSize, halfCell, z * cellSize);
+			if (cells[z * mazeSize + x] == 'x') {
+				AddCube(world, position, Vector3(halfCell, halfCell, halfCell), 0.0f);
+				continue;
+			}
+			if (openCells++ % 8 == 0) {
+				GameObject* enemy = AddCube(world, position, Vector3(0.9f, 1.8f, 0.9f), 0.5f, "Enemy");
+				enemy->GetPhysicsObject()->SetLinearVelocity(Vector3(speed(rng), 0, speed(rng)));
+			}
+			else {
+				GameObject* coin = AddSphere(world, position, 0.25f, 0.0f, "Coin");
+				coin->GetPhysicsObject()->SetElasticity(0);
+				coin->GetPhysicsObject()->SetFriction(1);
+			}
+		}
+	}
+	float floorSize = mazeSize * halfCell + 10.0f;
+	AddFloor(world, Vector3(0, -2, 0), Vector3(floorSize, 2, floorSize));
+}
+
+GameObject* BenchmarkScenes::AddSphere(GameWorld& world, const Vector3& position, float radius, float inverseMass, const std::string& name) {
+	GameObject* sphere = world.Create<GameObject>(name);
+
+	SphereVolume* volume = world.Create<SphereVolume>(radius);
+	sphere->SetBoundingVolume((CollisionVolume*)volume);
+
+	sphere->GetTransform()
+		.SetScale(Vector3(radius, radius, radius))
+		.SetPosition(position);
+
+	sphere->SetPhysicsObject(world.Create<PhysicsObject>(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+
+	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+	sphere->GetPhysicsObject()->InitSphereInertia();
+
+	world.AddGameObject(sphere);
+
+	return sphere;
+}
+
+GameObject* BenchmarkScenes::AddCube(GameWorld& world, const Vector3& position, const Vector3& halfSize, float inverseMass, const std::string& name) {
+	GameObject* cube = world.Create<GameObject>(name);
+
+	AABBVolume* volume = world.Create<AABBVolume>(halfSize);
+	cube->SetBoundingVolume((CollisionVolume*)volume);
+
+	cube->GetTransform()
+		.SetPosition(position)
+		.SetScale(halfSize * 2);
+
+	cube->SetPhysicsObject(world.Create<PhysicsObject>(&cube->GetTransform(), cube->GetBoundingVolume()));
+
+	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+	cube->GetPhysicsObject()->InitCubeInertia();
+
+	world.AddGameObject(cube);
+
+	return cube;
+}
+
+GameObject* BenchmarkScenes::AddFloor(GameWorld& world, const Vector3& position, const Vector3& halfSize) {
+	GameObject* floor = AddCube(world, position, halfSize, 0.0f, "World");
+
+	floor->GetPhysicsObject()->SetFriction(1);
+	floor->GetPhysicsObject()->SetElasticity(0);
+
+	return floor;
+}
+
+const char* BenchmarkScenes::GetSceneName(BenchmarkScene scene) {
+	switch (scene) {
+		case BenchmarkScene::SphereGrid:	return "spheres";
+		case BenchmarkScene::CubeGrid:		return "cubes";
+		case BenchmarkScene::MixedGrid:		return "mixed";
+		case BenchmarkScene::Bridge:		return "bridge";
+		case BenchmarkScene::Maze:			return "maze";
+		default:							return "unknown";
+	}
+}
+
+bool BenchmarkScenes::GetSceneFromName(const std::string& name, BenchmarkScene& scene) {
+	for (int i = 0; i < (int)BenchmarkScene::MAX_SCENES; ++i) {
+		if (name == GetSceneName((BenchmarkScene)i)) {
+			scene = (BenchmarkScene)i;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "../CSC8503Common/GameWorld.h"
+#include "../CSC8503Common/GameObject.h"
+#include <string>
+
+namespace NCL {
+	namespace CSC8503 {
+		enum class BenchmarkScene {
+			SphereGrid,
+			CubeGrid,
+			MixedGrid,
+			Bridge,
+			Maze,
+			MAX_SCENES
+		};
+
+		/*
+		Builds GameWorld scenes for the physics benchmark. These mirror the
+		InitSphereGridWorld etc functions in the game, but don't create any
+		RenderObjects, so they can be used without a window or renderer.
+
+		Every scene is built from a fixed seed, so the same scene and body
+		count will always give the same starting state.
+		*/
+		class BenchmarkScenes {
+		public:
+			static void BuildScene(GameWorld& world, BenchmarkScene scene, int numBodies, unsigned int seed = 1234);
+
+			static void BuildSphereGrid(GameWorld& world, int numBodies);
+			static void BuildCubeGrid(GameWorld& world, int numBodies);
+			static void BuildMixedGrid(GameWorld& world, int numBodies, unsigned int seed);
+			static void BuildBridge(GameWorld& world, int numLinks);
+			static void BuildMaze(GameWorld& world, int numBodies, unsigned int seed);
+
+			static const char*	GetSceneName(BenchmarkScene scene);
+			static bool			GetSceneFromName(const std::string& name, BenchmarkScene& scene);
+
+		protected:
+			static GameObject* AddSphere(GameWorld& world, const Vector3& position, float radius, float inverseMass, const std::string& name = "");
+			static GameObject* AddCube(GameWorld& world, const Vector3& position, const Vector3& halfSize, float inverseMass, const std::string& name = "World");
+			static GameObject* AddFloor(GameWorld& world, const Vector3& position, const Vector3& halfSize);
+
+			static void GetGridSize(int numBodies, int& numRows, int& numCols);
+		};
+	}
+}
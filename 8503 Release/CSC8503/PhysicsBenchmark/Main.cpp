@@ -0,0 +1,501 @@
+/*
+A headless benchmark for the physics engine - it builds scenes straight
+into a GameWorld, steps a PhysicsSystem a fixed number of frames, and
+reports the throughput, per-phase times and memory use of each run.
+
+There's no window, renderer or OpenGL involved, so as well as building
+from the solution, it can be built on Linux straight from the command
+line, from the 8503 Release folder:
+
+	g++ -std=c++17 -O2 -ffp-contract=off -IPlugins/OpenGLRendering CSC8503/PhysicsBenchmark/{Main,BenchmarkScenes}.cpp \
+		CSC8503/CSC8503Common/{CollisionDetection,GameObject,ChainConstraint,GameWorld,JobSystem,PhysicsObject,PhysicsStats,PhysicsSystem,PositionConstraint,RenderObject,Simulation,SimulationHost,Transform,WorldSnapshot,XPBDSolver,Components,EntityRegistry,LevelArena,Prefab}.cpp \
+		Common/{Vector2,Vector3,Vector4,Matrix2,Matrix3,Matrix4,Quaternion,Maths,Plane,GameTimer,Camera,Window,Keyboard,Mouse}.cpp \
+		-lpthread -o PhysicsBenchmark
+
+(The OpenGLRendering folder is only needed for its headers, nothing from
+it gets linked in.)
+
+Example usage:
+
+	PhysicsBenchmark --scene all --sizes 1000,10000,100000 --broadphase both --csv results.csv
+	PhysicsBenchmark --scene bridge,mixed --sizes 1000 --broadphase quadtree --solver both --substeps 8
+	PhysicsBenchmark --scene mixed --sizes 500 --broadphase quadtree --worlds 32
+*/
+#include "BenchmarkScenes.h"
+#include "../CSC8503Common/PhysicsSystem.h"
+#include "../CSC8503Common/GameWorld.h"
+#include "../CSC8503Common/JobSystem.h"
+#include "../CSC8503Common/ChainConstraint.h"
+#include "../CSC8503Common/Simulation.h"
+#include "../CSC8503Common/SimulationHost.h"
+#include "../CSC8503Common/WorldSnapshot.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+struct BenchmarkSettings {
+	std::vector<BenchmarkScene>	scenes;
+	std::vector<int>			sizes;
+	std::vector<bool>			broadphases;
+	std::vector<SolverMode>		solvers;
+	int				frames			= 120;
+	int				substeps		= 8;
+	int				maxBruteForce	= 10000;
+	int				threads			= std::max(1, (int)std::thread::hardware_concurrency());
+	int				worlds			= 1;
+	float			frameTime		= 1.0f / 60.0f;
+	unsigned int	seed			= 1234;
+	bool			chains			= false;
+	bool			snapshots		= false;
+	bool			hash			= false;
+	std::string		csvFile;
+	std::string		statsFile;
+};
+
+struct BenchmarkResult {
+	float	buildTime		= 0.0f;	//seconds
+	float	runTime			= 0.0f;	//seconds
+	int		substeps		= 0;
+	float	phaseTime[NUM_PHYSICS_PHASES]	= { 0 };	//ms, summed over all frames
+	double	counters[NUM_PHYSICS_COUNTERS]	= { 0 };	//summed over all frames
+	float	memoryBefore	= 0.0f;	//MB
+	float	memoryAfter		= 0.0f;	//MB
+	float	peakMemory		= 0.0f;	//MB
+	float	snapshotTime	= 0.0f;	//ms per snapshot
+	float	restoreTime		= 0.0f;	//ms per restore
+	size_t	snapshotSize	= 0;	//bytes
+	uint64_t stateHash		= 0;
+};
+
+/*
+Current and peak resident memory, in megabytes.
+*/
+void GetMemoryUsage(float& current, float& peak) {
+	current = 0.0f;
+	peak	= 0.0f;
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		current = counters.WorkingSetSize		/ (1024.0f * 1024.0f);
+		peak	= counters.PeakWorkingSetSize	/ (1024.0f * 1024.0f);
+	}
+#elif defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		std::istringstream s(line);
+		std::string key;
+		float kb = 0.0f;
+		s >> key >> kb;
+		if (key == "VmRSS:") {
+			current = kb / 1024.0f;
+		}
+		else if (key == "VmHWM:") {
+			peak = kb / 1024.0f;
+		}
+	}
+#endif
+}
+
+template<class T>
+std::vector<T> SplitList(const std::string& input, T(*convert)(const std::string&)) {
+	std::vector<T> output;
+	std::istringstream s(input);
+	std::string entry;
+	while (std::getline(s, entry, ',')) {
+		if (!entry.empty()) {
+			output.push_back(convert(entry));
+		}
+	}
+	return output;
+}
+
+int ToInt(const std::string& s) {
+	return std::atoi(s.c_str());
+}
+
+void PrintUsage() {
+	std::cout << "Usage: PhysicsBenchmark [options]\n"
+		<< "  --scene <name[,name]>     spheres, cubes, mixed, bridge, maze or all (default spheres)\n"
+		<< "  --sizes <n[,n]>           body counts to test (default 1000)\n"
+		<< "  --frames <n>              frames to step per run (default 120)\n"
+		<< "  --broadphase <mode>       brute, quadtree or both (default both)\n"
+		<< "  --maxbrute <n>            skip brute force runs above this many bodies (default 10000)\n"
+		<< "  --seed <n>                seed for the scene generators (default 1234)\n"
+		<< "  --chains <on|off>         solve runs of position constraints as chains (default off)\n"
+		<< "  --solver <mode>           impulse, xpbd or both (default impulse)\n"
+		<< "  --substeps <n>            substeps per physics step for the xpbd solver (default 8)\n"
+		<< "  --snapshots <on|off>      time saving and restoring the world after each run (default off)\n"
+		<< "  --hash <on|off>           print a hash of the final state, to check runs match (default off)\n"
+		<< "  --threads <n>             threads for the constraint solver, 1 to solve serially (default all)\n"
+		<< "  --worlds <n>              independent copies of each scene, stepped in parallel (default 1)\n"
+		<< "  --csv <file>              write one row per run to a csv file\n"
+		<< "  --stats <file>            dump the per-frame physics stats of the last run\n";
+}
+
+bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings) {
+	std::string sceneList	= "spheres";
+	std::string sizeList	= "1000";
+	std::string broadphase	= "both";
+	std::string solver		= "impulse";
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << arg << "\n";
+			return false;
+		}
+		std::string value = argv[++i];
+		if		(arg == "--scene")		{ sceneList = value; }
+		else if (arg == "--sizes" || arg == "--bodies") { sizeList = value; }
+		else if (arg == "--frames")		{ settings.frames = std::max(1, ToInt(value)); }
+		else if (arg == "--broadphase")	{ broadphase = value; }
+		else if (arg == "--maxbrute")	{ settings.maxBruteForce = ToInt(value); }
+		else if (arg == "--seed")		{ settings.seed = (unsigned int)ToInt(value); }
+		else if (arg == "--solver")		{ solver = value; }
+		else if (arg == "--substeps")	{ settings.substeps = std::max(1, ToInt(value)); }
+		else if (arg == "--chains")		{ settings.chains = (value == "on" || value == "1"); }
+		else if (arg == "--snapshots")	{ settings.snapshots = (value == "on" || value == "1"); }
+		else if (arg == "--hash")		{ settings.hash = (value == "on" || value == "1"); }
+		else if (arg == "--threads")	{ settings.threads = std::max(1, ToInt(value)); }
+		else if (arg == "--worlds")		{ settings.worlds = std::max(1, ToInt(value)); }
+		else if (arg == "--csv")		{ settings.csvFile = value; }
+		else if (arg == "--stats")		{ settings.statsFile = value; }
+		else {
+			std::cout << "Unknown option " << arg << "\n";
+			return false;
+		}
+	}
+
+	for (const std::string& name : SplitList<std::string>(sceneList, [](const std::string& s) { return s; })) {
+		if (name == "all") {
+			for (int i = 0; i < (int)BenchmarkScene::MAX_SCENES; ++i) {
+				settings.scenes.push_back((BenchmarkScene)i);
+			}
+			continue;
+		}
+		BenchmarkScene scene;
+		if (!BenchmarkScenes::GetSceneFromName(name, scene)) {
+			std::cout << "Unknown scene " << name << "\n";
+			return false;
+		}
+		settings.scenes.push_back(scene);
+	}
+
+	settings.sizes = SplitList<int>(sizeList, ToInt);
+
+	if (broadphase == "brute" || broadphase == "both") {
+		settings.broadphases.push_back(false);
+	}
+	if (broadphase == "quadtree" || broadphase == "both") {
+		settings.broadphases.push_back(true);
+	}
+	if (solver == "impulse" || solver == "both") {
+		settings.solvers.push_back(SolverMode::Impulse);
+	}
+	if (solver == "xpbd" || solver == "both") {
+		settings.solvers.push_back(SolverMode::XPBD);
+	}
+	if (settings.scenes.empty() || settings.sizes.empty() || settings.broadphases.empty() || settings.solvers.empty()) {
+		std::cout << "Nothing to run!\n";
+		return false;
+	}
+	return true;
+}
+
+float SecondsSince(const Timepoint& start) {
+	std::chrono::duration<float> diff = std::chrono::high_resolution_clock::now() - start;
+	return diff.count();
+}
+
+/*
+Saves the world as it was at the end of the run, then restores it again,
+a few times over, checking that the restored world saves out identically.
+*/
+void TimeSnapshots(GameWorld& world, PhysicsSystem& physics, BenchmarkResult& result) {
+	const int repeats = 20;
+	WorldSnapshot snapshot;
+	WorldSnapshot check;
+	world.Snapshot(snapshot); //the first one allocates
+	physics.Snapshot(snapshot);
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < repeats; ++i) {
+		world.Snapshot(snapshot);
+		physics.Snapshot(snapshot);
+	}
+	result.snapshotTime = SecondsSince(start) * 1000.0f / repeats;
+
+	start = std::chrono::high_resolution_clock::now();
+	bool restored = true;
+	for (int i = 0; i < repeats; ++i) {
+		restored &= world.Restore(snapshot);
+		restored &= physics.Restore(snapshot);
+	}
+	result.restoreTime	= SecondsSince(start) * 1000.0f / repeats;
+	result.snapshotSize = snapshot.GetSize();
+
+	world.Snapshot(check);
+	physics.Snapshot(check);
+	if (!restored || check.GetSize() != snapshot.GetSize() || memcmp(check.GetData(), snapshot.GetData(), snapshot.GetSize()) != 0) {
+		std::cout << "Snapshot restore didn't match!\n";
+	}
+}
+
+BenchmarkResult RunBenchmark(const BenchmarkSettings& settings, JobSystem* jobs, BenchmarkScene scene, int numBodies, bool useBroadPhase, SolverMode solver, bool dumpStats) {
+	BenchmarkResult result;
+	float peak;
+	GetMemoryUsage(result.memoryBefore, peak);
+
+	GameWorld		world;
+	PhysicsSystem	physics(world);
+
+	physics.UseGravity(true);
+	physics.UseBroadPhase(useBroadPhase);
+	physics.UseAdaptiveTimestep(false);
+	physics.SetJobSystem(jobs);
+	physics.SetSolverMode(solver);
+	physics.GetXPBDSolver().SetSubsteps(settings.substeps);
+	world.SetRandomSeed(settings.seed);
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	BenchmarkScenes::BuildScene(world, scene, numBodies, settings.seed);
+	if (settings.chains) {
+		ChainConstraint::CollapseChains(world);
+	}
+	result.buildTime = SecondsSince(start);
+
+	if (dumpStats) {
+		physics.GetStats().StartDump(settings.statsFile);
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < settings.frames; ++i) {
+		world.UpdateWorld(settings.frameTime);
+		physics.Update(settings.frameTime);
+
+		const PhysicsFrameStats& frame = physics.GetStats().GetLastFrame();
+		for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+			result.phaseTime[p] += frame.phaseTime[p];
+		}
+		for (int c = 0; c < NUM_PHYSICS_COUNTERS; ++c) {
+			result.counters[c] += frame.counters[c];
+		}
+	}
+	result.runTime	= SecondsSince(start);
+	result.substeps = (int)result.counters[(int)PhysicsCounter::Substeps];
+
+	GetMemoryUsage(result.memoryAfter, result.peakMemory);
+
+	if (settings.hash) {
+		WorldSnapshot snapshot;
+		world.Snapshot(snapshot);
+		physics.Snapshot(snapshot);
+		result.stateHash = snapshot.GetHash();
+	}
+	if (settings.snapshots) {
+		TimeSnapshots(world, physics, result);
+	}
+
+	world.ClearAndErase();
+
+	return result;
+}
+
+/*
+The same scene built into lots of separate simulations, which are then all
+stepped together on the job system. Phase times and counters are summed
+over every world, so they're the total CPU time spent per frame.
+*/
+BenchmarkResult RunMultiWorldBenchmark(const BenchmarkSettings& settings, JobSystem* jobs, BenchmarkScene scene, int numBodies, bool useBroadPhase, SolverMode solver) {
+	BenchmarkResult result;
+	float peak;
+	GetMemoryUsage(result.memoryBefore, peak);
+
+	SimulationHost host(jobs);
+
+	Timepoint start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < settings.worlds; ++i) {
+		Simulation* s = new Simulation();
+		s->GetPhysics().UseBroadPhase(useBroadPhase);
+		s->GetPhysics().SetSolverMode(solver);
+		s->GetPhysics().GetXPBDSolver().SetSubsteps(settings.substeps);
+		BenchmarkScenes::BuildScene(s->GetWorld(), scene, numBodies, settings.seed + i);
+		if (settings.chains) {
+			ChainConstraint::CollapseChains(s->GetWorld());
+		}
+		host.AddSimulation(s);
+	}
+	result.buildTime = SecondsSince(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < settings.frames; ++i) {
+		host.Step(settings.frameTime);
+
+		for (int w = 0; w < host.GetNumSimulations(); ++w) {
+			const PhysicsFrameStats& frame = host.GetSimulation(w)->GetPhysics().GetStats().GetLastFrame();
+			for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+				result.phaseTime[p] += frame.phaseTime[p];
+			}
+			for (int c = 0; c < NUM_PHYSICS_COUNTERS; ++c) {
+				result.counters[c] += frame.counters[c];
+			}
+		}
+	}
+	result.runTime	= SecondsSince(start);
+	result.substeps = (int)result.counters[(int)PhysicsCounter::Substeps];
+
+	GetMemoryUsage(result.memoryAfter, result.peakMemory);
+	return result;
+}
+
+const char* GetSolverName(SolverMode solver) {
+	return solver == SolverMode::XPBD ? "xpbd" : "impulse";
+}
+
+void PrintHeader() {
+	std::cout << std::left
+		<< std::setw(9)	<< "scene"
+		<< std::setw(9)	<< "bodies"
+		<< std::setw(10)<< "broad"
+		<< std::setw(9)	<< "solver"
+		<< std::setw(10)<< "frames/s"
+		<< std::setw(10)<< "steps/s";
+	for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+		std::string name = PhysicsStats::GetPhaseName((PhysicsPhase)p);
+		std::cout << std::setw(11) << name.substr(0, 10);
+	}
+	std::cout << std::setw(11) << "pairs/f" << std::setw(11) << "contacts/f" << std::setw(9) << "mem MB" << std::setw(9) << "peak MB" << "\n";
+	std::cout << std::right;
+}
+
+void PrintResult(const BenchmarkSettings& settings, BenchmarkScene scene, int numBodies, bool useBroadPhase, SolverMode solver, const BenchmarkResult& r) {
+	float frames = (float)settings.frames;
+	std::cout << std::left << std::fixed << std::setprecision(2)
+		<< std::setw(9)	<< BenchmarkScenes::GetSceneName(scene)
+		<< std::setw(9)	<< numBodies
+		<< std::setw(10)<< (useBroadPhase ? "quadtree" : "brute")
+		<< std::setw(9)	<< GetSolverName(solver)
+		<< std::setw(10)<< frames / r.runTime
+		<< std::setw(10)<< r.substeps / r.runTime;
+	for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+		std::cout << std::setw(11) << std::setprecision(3) << r.phaseTime[p] / frames;
+	}
+	std::cout << std::setprecision(0)
+		<< std::setw(11) << r.counters[(int)PhysicsCounter::CandidatePairs] / frames
+		<< std::setw(11) << r.counters[(int)PhysicsCounter::Contacts] / frames
+		<< std::setprecision(1)
+		<< std::setw(9) << r.memoryAfter
+		<< std::setw(9) << r.peakMemory << "\n";
+	if (settings.hash) {
+		std::cout << "    state hash " << std::hex << std::setw(16) << std::setfill('0') << r.stateHash << std::dec << std::setfill(' ') << "\n";
+	}
+	if (settings.snapshots) {
+		std::cout << std::setprecision(3) << "    snapshot " << r.snapshotTime << "ms, restore " << r.restoreTime << "ms, "
+			<< std::setprecision(1) << r.snapshotSize / 1024.0f << "KB\n";
+	}
+	std::cout << std::right << std::defaultfloat;
+}
+
+void WriteCSVHeader(std::ofstream& csv) {
+	csv << "scene,bodies,broadphase,solver,threads,frames,buildSeconds,runSeconds,framesPerSecond,stepsPerSecond";
+	for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+		csv << "," << PhysicsStats::GetPhaseName((PhysicsPhase)p) << "Ms";
+	}
+	for (int c = 0; c < NUM_PHYSICS_COUNTERS; ++c) {
+		csv << "," << PhysicsStats::GetCounterName((PhysicsCounter)c);
+	}
+	csv << ",memoryBeforeMB,memoryAfterMB,peakMemoryMB\n";
+}
+
+void WriteCSVResult(std::ofstream& csv, const BenchmarkSettings& settings, BenchmarkScene scene, int numBodies, bool useBroadPhase, SolverMode solver, const BenchmarkResult& r) {
+	float frames = (float)settings.frames;
+	csv << BenchmarkScenes::GetSceneName(scene) << "," << numBodies << "," << (useBroadPhase ? "quadtree" : "brute") << "," << GetSolverName(solver) << ","
+		<< settings.threads << "," << settings.frames << "," << r.buildTime << "," << r.runTime << "," << frames / r.runTime << "," << r.substeps / r.runTime;
+	for (int p = 0; p < NUM_PHYSICS_PHASES; ++p) {
+		csv << "," << r.phaseTime[p] / frames;
+	}
+	for (int c = 0; c < NUM_PHYSICS_COUNTERS; ++c) {
+		csv << "," << r.counters[c] / frames;
+	}
+	csv << "," << r.memoryBefore << "," << r.memoryAfter << "," << r.peakMemory << "\n";
+	csv.flush();
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+	if (!ParseArguments(argc, argv, settings)) {
+		PrintUsage();
+		return 1;
+	}
+
+	std::ofstream csv;
+	if (!settings.csvFile.empty()) {
+		csv.open(settings.csvFile);
+		if (!csv.is_open()) {
+			std::cout << "Can't open " << settings.csvFile << " for writing!\n";
+			return 1;
+		}
+		WriteCSVHeader(csv);
+	}
+
+	JobSystem* jobs = nullptr;
+	if (settings.threads > 1) {
+		jobs = new JobSystem(settings.threads - 1);
+	}
+
+	std::cout << "Stepping " << settings.frames << " frames at " << 1.0f / settings.frameTime << "hz per run, using " << settings.threads << " thread(s). Phase times are ms per frame.\n";
+	if (settings.worlds > 1) {
+		std::cout << "Each run steps " << settings.worlds << " worlds in parallel - phase times and counters are summed over all of them.\n";
+	}
+	PrintHeader();
+
+	int runsLeft = (int)(settings.scenes.size() * settings.sizes.size() * settings.broadphases.size() * settings.solvers.size());
+	for (BenchmarkScene scene : settings.scenes) {
+		for (int numBodies : settings.sizes) {
+			for (bool useBroadPhase : settings.broadphases) {
+				for (SolverMode solver : settings.solvers) {
+					runsLeft--;
+					if (!useBroadPhase && numBodies > settings.maxBruteForce) {
+						std::cout << std::left << std::setw(9) << BenchmarkScenes::GetSceneName(scene) << std::setw(9) << numBodies
+							<< std::setw(10) << "brute" << std::setw(9) << GetSolverName(solver) << "skipped (over --maxbrute " << settings.maxBruteForce << ")\n" << std::right;
+						continue;
+					}
+					bool dumpStats = !settings.statsFile.empty() && runsLeft == 0;
+					BenchmarkResult result = settings.worlds > 1 ?
+						RunMultiWorldBenchmark(settings, jobs, scene, numBodies, useBroadPhase, solver) :
+						RunBenchmark(settings, jobs, scene, numBodies, useBroadPhase, solver, dumpStats);
+					PrintResult(settings, scene, numBodies, useBroadPhase, solver, result);
+					if (csv.is_open()) {
+						WriteCSVResult(csv, settings, scene, numBodies, useBroadPhase, solver, result);
+					}
+				}
+			}
+		}
+	}
+	delete jobs;
+	return 0;
+}